@@ -19,6 +19,11 @@ void Cmd_Scene_f(void) {
 		sceneParams = nullptr;
 	}
 
+	// demos run this to get back to the start of the scene. built up front, since the scene can
+	// run console commands while it loads and the args won't be valid after that.
+	char sceneCmd[1024];
+	snprintf(sceneCmd, sizeof(sceneCmd), "scene %s %s", mainScriptName, sceneParams != nullptr ? sceneParams : "");
+
 	if (vm != nullptr) {
 		Wren_Scene_Shutdown(vm);
 		Wren_FreeVM(vm);
@@ -27,6 +32,7 @@ void Cmd_Scene_f(void) {
 	vm = Wren_Init(mainScriptName, sceneParams);
 	if (vm != nullptr) {
 		SLT_Con_SetVar("engine.errorMessage", "");
+		SLT_Con_SetVar("engine.scene", sceneCmd);
 	}
 }
 
@@ -44,6 +50,8 @@ void Cmd_Map_f(void) {
 	}
 
 	snprintf(filename, sizeof(filename), "maps/%s", mapname);
+	char mapCmd[300];
+	snprintf(mapCmd, sizeof(mapCmd), "map %s", mapname);
 	Com_DefaultExtension(filename, sizeof(filename), ".tmx");
 
 	if (!SLT_FS_Exists(filename)) {
@@ -59,6 +67,7 @@ void Cmd_Map_f(void) {
 	vm = Wren_Init("scripts/main.wren", filename);
 	if (vm != nullptr) {
 		SLT_Con_SetVar("engine.errorMessage", "");
+		SLT_Con_SetVar("engine.scene", mapCmd);
 	}
 }
 
@@ -124,7 +133,6 @@ void Com_DefaultExtension(char *path, int maxSize, const char *extension) {
 }
 
 void main_loop() {
-	bool ranUpdate = false;
 	double dt = SLT_StartFrame();
 	if (dt < 0) {
 		loop = false;
@@ -140,17 +148,24 @@ void main_loop() {
 			return;
 		}
 
-		if (dt > 0) {
-			ranUpdate = Wren_Update(vm, dt);
+		// input timing is advanced per tick so a press is seen by exactly one tick, and carries over
+		// to the next frame if this one didn't run any
+		int ticks = SLT_Tick_Begin(dt);
+		for (int i = 0; i < ticks; i++) {
+			SLT_Prof_Begin("wren update");
+			Wren_Update(vm, SLT_Tick_Length());
+			SLT_Prof_End();
+			SLT_UpdateLastFrameTime();
 		}
 	}
 
 	int width, height;
 	SLT_GetResolution(&width, &height);
-	Wren_Draw(vm, width, height);
+	SLT_Prof_Begin("wren draw");
+	Wren_Draw(vm, width, height, SLT_Tick_Alpha());
+	SLT_Prof_End();
+	Wren_ReportStats();
 	SLT_EndFrame();
-
-	SLT_UpdateLastFrameTime();
 }
 
 int main(int argc, char* argv[]) {
@@ -171,6 +186,7 @@ int main(int argc, char* argv[]) {
 	vm = Wren_Init("scripts/main.wren", nullptr);
 	if (vm != nullptr) {
 		SLT_Con_SetVar("engine.errorMessage", "");
+		SLT_Con_SetVar("engine.scene", "scene scripts/main.wren");
 	}
 
 #ifdef __EMSCRIPTEN__
@@ -1,4 +1,5 @@
 #include <tmx.h>
+#include "../src/slate2d.h"
 #include <cstring>
 
 int Map_GetLayerByName(const tmx_map *map, const char *name) {
@@ -16,14 +17,7 @@ int Map_GetLayerByName(const tmx_map *map, const char *name) {
 }
 
 tmx_layer *Map_GetLayer(const tmx_map *map, int id) {
-	int i = 0;
-	tmx_layer *layer = map->ly_head;
-	while (layer != nullptr && i < id) {
-		layer = layer->next;
-		i++;
-	}
-
-	return layer;
+	return SLT_TMX_GetLayer(map, id);
 }
 
 tmx_object *Map_LayerObjects(const tmx_map *map, int id, const tmx_object *current) {
@@ -67,9 +61,99 @@ tmx_tile *Map_GetTileInfo(const tmx_map *map, unsigned int gid) {
 
 unsigned int Map_GetTile(const tmx_map *map, int id, unsigned int x, unsigned int y) {
 	tmx_layer *layer = Map_GetLayer(map, id);
-	if (layer->type != L_LAYER) {
+	if (layer == nullptr || layer->type != L_LAYER || x >= map->width || y >= map->height) {
 		return 0;
 	}
+
+	if (map->infinite) {
+		const tmxMapInfo_t *info = SLT_TMX_GetInfo(map);
+		unsigned int chunkW = (unsigned int)info->chunkW, chunkH = (unsigned int)info->chunkH;
+		const int32_t *gids = SLT_TMX_GetChunk(map, id, (int)(x / chunkW), (int)(y / chunkH));
+		return gids != nullptr ? (gids[(y % chunkH) * chunkW + (x % chunkW)] & TMX_FLIP_BITS_REMOVAL) : 0;
+	}
 	
 	return (layer->content.gids[(y*map->width) + x]) & TMX_FLIP_BITS_REMOVAL;
-}
\ No newline at end of file
+}
+
+// copies count gids from row y of a chunked layer starting at x, which all have to be in the map.
+// cells in chunks that were never drawn on are 0.
+static void Map_GetChunkRow(const tmx_map *map, int id, int x, int y, int count, int32_t *dst) {
+	const tmxMapInfo_t *info = SLT_TMX_GetInfo(map);
+	int chunkW = info->chunkW, chunkH = info->chunkH;
+
+	while (count > 0) {
+		int inX = x % chunkW;
+		int n = chunkW - inX < count ? chunkW - inX : count;
+		const int32_t *gids = SLT_TMX_GetChunk(map, id, x / chunkW, y / chunkH);
+
+		if (gids == nullptr) {
+			memset(dst, 0, sizeof(int32_t) * n);
+		}
+		else {
+			const int32_t *src = &gids[(y % chunkH) * chunkW + inX];
+			for (int i = 0; i < n; i++) {
+				dst[i] = (int32_t)((uint32_t)src[i] & TMX_FLIP_BITS_REMOVAL);
+			}
+		}
+
+		x += n;
+		dst += n;
+		count -= n;
+	}
+}
+
+int Map_GetTiles(const tmx_map *map, int id, int x, int y, int w, int h, int32_t *out) {
+	tmx_layer *layer = Map_GetLayer(map, id);
+	if (layer == nullptr || layer->type != L_LAYER) {
+		return 0;
+	}
+
+	if (w <= 0 || h <= 0) {
+		return 0;
+	}
+
+	int64_t mapW = map->width;
+	int64_t mapH = map->height;
+	const int32_t *gids = layer->content.gids;
+	bool chunked = map->infinite != 0;
+
+	// clip the block to the map, anything outside is -1. done in 64 bits so x + w can't overflow,
+	// and clamped to [0, w] so blocks entirely off either side of the map are all -1.
+	int64_t startX = -(int64_t)x, endX = mapW - x;
+	int start = (int)(startX < 0 ? 0 : startX > w ? w : startX);
+	int end = (int)(endX < start ? start : endX > w ? w : endX);
+	int64_t startY = -(int64_t)y, endY = mapH - y;
+	int firstRow = (int)(startY < 0 ? 0 : startY > h ? h : startY);
+	int lastRow = (int)(endY < firstRow ? firstRow : endY > h ? h : endY);
+
+	for (int row = 0; row < h; row++) {
+		int32_t *dst = &out[row * w];
+
+		if (row < firstRow || row >= lastRow) {
+			for (int col = 0; col < w; col++) {
+				dst[col] = -1;
+			}
+			continue;
+		}
+
+		int ty = y + row;
+
+		for (int col = 0; col < start; col++) {
+			dst[col] = -1;
+		}
+		if (chunked) {
+			Map_GetChunkRow(map, id, x + start, ty, end - start, &dst[start]);
+		}
+		else {
+			const int32_t *src = &gids[ty * mapW];
+			for (int col = start; col < end; col++) {
+				dst[col] = (int32_t)((uint32_t)src[x + col] & TMX_FLIP_BITS_REMOVAL);
+			}
+		}
+		for (int col = end; col < w; col++) {
+			dst[col] = -1;
+		}
+	}
+
+	return w * h;
+}
@@ -1,9 +1,13 @@
 #pragma once
 #include <tmx.h>
+#include <stdint.h>
 
 int Map_GetLayerByName(const tmx_map *map, const char *name);
 tmx_layer *Map_GetLayer(const tmx_map *map, int id);
 tmx_object *Map_LayerObjects(const tmx_map *map, int layer, const tmx_object *current);
 const char *Map_GetObjectType(const tmx_map *map, const tmx_object *obj);
 tmx_tile *Map_GetTileInfo(const tmx_map *map, unsigned int gid);
-unsigned int Map_GetTile(const tmx_map *map, int id, unsigned int x, unsigned int y);
\ No newline at end of file
+unsigned int Map_GetTile(const tmx_map *map, int id, unsigned int x, unsigned int y);
+// copies the gids of a w by h block of a tile layer into out, row by row, with flip bits removed.
+// cells outside the map are -1. returns the number of cells written, 0 if id isn't a tile layer.
+int Map_GetTiles(const tmx_map *map, int id, int x, int y, int w, int h, int32_t *out);
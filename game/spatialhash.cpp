@@ -0,0 +1,246 @@
+#include "spatialhash.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void SHash_Init(spatialHash_t *hash, double cellSize) {
+	memset(hash, 0, sizeof(*hash));
+	hash->cellSize = cellSize > 0 ? cellSize : 32;
+}
+
+void SHash_Free(spatialHash_t *hash) {
+	for (int i = 0; i < hash->cellCapacity; i++) {
+		free(hash->cells[i].ids);
+	}
+
+	free(hash->cells);
+	free(hash->entries);
+	memset(hash, 0, sizeof(*hash));
+}
+
+static uint32_t SHash_CellHash(int32_t cx, int32_t cy) {
+	return ((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u);
+}
+
+// returns the cell at cx, cy, or the empty slot it would go in. capacity is always a power of 2.
+static spatialHashCell_t* SHash_FindSlot(spatialHashCell_t *cells, int capacity, int32_t cx, int32_t cy) {
+	uint32_t mask = (uint32_t)capacity - 1;
+	uint32_t i = SHash_CellHash(cx, cy) & mask;
+	while (cells[i].used && (cells[i].cx != cx || cells[i].cy != cy)) {
+		i = (i + 1) & mask;
+	}
+
+	return &cells[i];
+}
+
+static spatialHashCell_t* SHash_FindCell(const spatialHash_t *hash, int32_t cx, int32_t cy) {
+	if (hash->cellCapacity == 0) {
+		return nullptr;
+	}
+
+	spatialHashCell_t *cell = SHash_FindSlot(hash->cells, hash->cellCapacity, cx, cy);
+	return cell->used ? cell : nullptr;
+}
+
+static spatialHashCell_t* SHash_GetCell(spatialHash_t *hash, int32_t cx, int32_t cy) {
+	spatialHashCell_t *cell = SHash_FindCell(hash, cx, cy);
+	if (cell != nullptr) {
+		return cell;
+	}
+
+	// keep the table under 3/4 full, the id lists move over as they are
+	if ((hash->cellCount + 1) * 4 > hash->cellCapacity * 3) {
+		int capacity = hash->cellCapacity == 0 ? 64 : hash->cellCapacity * 2;
+		spatialHashCell_t *cells = (spatialHashCell_t*)calloc(capacity, sizeof(spatialHashCell_t));
+		for (int i = 0; i < hash->cellCapacity; i++) {
+			if (hash->cells[i].used) {
+				*SHash_FindSlot(cells, capacity, hash->cells[i].cx, hash->cells[i].cy) = hash->cells[i];
+			}
+		}
+
+		free(hash->cells);
+		hash->cells = cells;
+		hash->cellCapacity = capacity;
+	}
+
+	cell = SHash_FindSlot(hash->cells, hash->cellCapacity, cx, cy);
+	cell->used = true;
+	cell->cx = cx;
+	cell->cy = cy;
+	hash->cellCount++;
+	return cell;
+}
+
+static void SHash_CellAdd(spatialHash_t *hash, int32_t cx, int32_t cy, int32_t id) {
+	spatialHashCell_t *cell = SHash_GetCell(hash, cx, cy);
+	if (cell->count == cell->capacity) {
+		cell->capacity = cell->capacity == 0 ? 8 : cell->capacity * 2;
+		cell->ids = (int32_t*)realloc(cell->ids, sizeof(int32_t) * cell->capacity);
+	}
+
+	cell->ids[cell->count++] = id;
+}
+
+static void SHash_CellRemove(spatialHash_t *hash, int32_t cx, int32_t cy, int32_t id) {
+	spatialHashCell_t *cell = SHash_FindCell(hash, cx, cy);
+	if (cell == nullptr) {
+		return;
+	}
+
+	for (int i = 0; i < cell->count; i++) {
+		if (cell->ids[i] == id) {
+			cell->ids[i] = cell->ids[--cell->count];
+			return;
+		}
+	}
+}
+
+static void SHash_CellRange(const spatialHash_t *hash, double x, double y, double w, double h, int *cx0, int *cy0, int *cx1, int *cy1) {
+	*cx0 = (int)floor(x / hash->cellSize);
+	*cy0 = (int)floor(y / hash->cellSize);
+	*cx1 = (int)floor((x + w) / hash->cellSize);
+	*cy1 = (int)floor((y + h) / hash->cellSize);
+}
+
+bool SHash_Insert(spatialHash_t *hash, int id, double x, double y, double w, double h) {
+	if (id < 0) {
+		return false;
+	}
+
+	if (id >= hash->entryCapacity) {
+		int capacity = hash->entryCapacity == 0 ? 64 : hash->entryCapacity;
+		while (capacity <= id) {
+			capacity *= 2;
+		}
+
+		hash->entries = (spatialHashEntry_t*)realloc(hash->entries, sizeof(spatialHashEntry_t) * capacity);
+		memset(hash->entries + hash->entryCapacity, 0, sizeof(spatialHashEntry_t) * (capacity - hash->entryCapacity));
+		hash->entryCapacity = capacity;
+	}
+
+	spatialHashEntry_t *ent = &hash->entries[id];
+	int cx0, cy0, cx1, cy1;
+	SHash_CellRange(hash, x, y, w, h, &cx0, &cy0, &cx1, &cy1);
+
+	ent->x = x;
+	ent->y = y;
+	ent->w = w;
+	ent->h = h;
+
+	// most moves stay inside the same cells, so only the box needs updating
+	if (ent->used && ent->cx0 == cx0 && ent->cy0 == cy0 && ent->cx1 == cx1 && ent->cy1 == cy1) {
+		return true;
+	}
+
+	if (ent->used) {
+		for (int cy = ent->cy0; cy <= ent->cy1; cy++) {
+			for (int cx = ent->cx0; cx <= ent->cx1; cx++) {
+				SHash_CellRemove(hash, cx, cy, id);
+			}
+		}
+	}
+	else {
+		ent->used = true;
+		hash->count++;
+	}
+
+	for (int cy = cy0; cy <= cy1; cy++) {
+		for (int cx = cx0; cx <= cx1; cx++) {
+			SHash_CellAdd(hash, cx, cy, id);
+		}
+	}
+
+	ent->cx0 = cx0;
+	ent->cy0 = cy0;
+	ent->cx1 = cx1;
+	ent->cy1 = cy1;
+	return true;
+}
+
+void SHash_Remove(spatialHash_t *hash, int id) {
+	if (id < 0 || id >= hash->entryCapacity || !hash->entries[id].used) {
+		return;
+	}
+
+	spatialHashEntry_t *ent = &hash->entries[id];
+	for (int cy = ent->cy0; cy <= ent->cy1; cy++) {
+		for (int cx = ent->cx0; cx <= ent->cx1; cx++) {
+			SHash_CellRemove(hash, cx, cy, id);
+		}
+	}
+
+	ent->used = false;
+	hash->count--;
+}
+
+static int SHash_Collect(spatialHash_t *hash, const spatialHashCell_t *cell, double x, double y, double w, double h, int32_t *out, int max, int found) {
+	for (int i = 0; i < cell->count; i++) {
+		spatialHashEntry_t *ent = &hash->entries[cell->ids[i]];
+		if (ent->stamp == hash->stamp) {
+			continue;
+		}
+
+		ent->stamp = hash->stamp;
+
+		// touching edges count, callers do their own exact tests
+		if (ent->x > x + w || ent->x + ent->w < x || ent->y > y + h || ent->y + ent->h < y) {
+			continue;
+		}
+
+		if (found < max) {
+			out[found] = cell->ids[i];
+		}
+		found++;
+	}
+
+	return found;
+}
+
+int SHash_Query(spatialHash_t *hash, double x, double y, double w, double h, int32_t *out, int max) {
+	int cx0, cy0, cx1, cy1;
+	SHash_CellRange(hash, x, y, w, h, &cx0, &cy0, &cx1, &cy1);
+
+	hash->stamp++;
+	if (hash->stamp == 0) {
+		// wrapped around, clear the old stamps so nothing gets skipped
+		for (int i = 0; i < hash->entryCapacity; i++) {
+			hash->entries[i].stamp = 0;
+		}
+		hash->stamp = 1;
+	}
+
+	int found = 0;
+	if ((double)(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > hash->cellCount) {
+		// rect covers more cells than exist, walk the table instead
+		for (int i = 0; i < hash->cellCapacity; i++) {
+			const spatialHashCell_t *cell = &hash->cells[i];
+			if (cell->used && cell->cx >= cx0 && cell->cx <= cx1 && cell->cy >= cy0 && cell->cy <= cy1) {
+				found = SHash_Collect(hash, cell, x, y, w, h, out, max, found);
+			}
+		}
+	}
+	else {
+		for (int cy = cy0; cy <= cy1; cy++) {
+			for (int cx = cx0; cx <= cx1; cx++) {
+				const spatialHashCell_t *cell = SHash_FindCell(hash, cx, cy);
+				if (cell != nullptr) {
+					found = SHash_Collect(hash, cell, x, y, w, h, out, max, found);
+				}
+			}
+		}
+	}
+
+	// cell order depends on where things are, sort so results come back in a stable order
+	int n = found < max ? found : max;
+	for (int i = 1; i < n; i++) {
+		int32_t id = out[i];
+		int j = i - 1;
+		while (j >= 0 && out[j] > id) {
+			out[j + 1] = out[j];
+			j--;
+		}
+		out[j + 1] = id;
+	}
+
+	return found;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// spatialhash.h - uniform grid broadphase for boxes, exposed to wren as SpatialHash. boxes are
+// keyed by small integer ids picked by the caller, and queries return the ids of every box that
+// touches a rect so scripts only run their exact checks against nearby things.
+
+#include <stdint.h>
+
+typedef struct {
+	double x, y, w, h;
+	int cx0, cy0, cx1, cy1; // cells the box covers, inclusive
+	uint32_t stamp; // last query that returned this id, so boxes over several cells come back once
+	bool used;
+} spatialHashEntry_t;
+
+typedef struct {
+	int32_t cx, cy;
+	int32_t count, capacity;
+	int32_t *ids;
+	bool used;
+} spatialHashCell_t;
+
+typedef struct {
+	double cellSize;
+
+	spatialHashEntry_t *entries; // indexed by id
+	int entryCapacity;
+	int count;
+
+	// open addressing table of cells, keyed by cell coordinates. cells are kept once made, a
+	// level only ever touches so many of them.
+	spatialHashCell_t *cells;
+	int cellCapacity;
+	int cellCount;
+
+	uint32_t stamp;
+} spatialHash_t;
+
+void SHash_Init(spatialHash_t *hash, double cellSize);
+void SHash_Free(spatialHash_t *hash);
+
+// adds a box, or moves it if id is already in the hash. returns false if id is negative.
+bool SHash_Insert(spatialHash_t *hash, int id, double x, double y, double w, double h);
+void SHash_Remove(spatialHash_t *hash, int id);
+
+// writes the ids of boxes touching the rect into out, up to max of them, sorted by id. returns how
+// many were found, which can be more than max.
+int SHash_Query(spatialHash_t *hash, double x, double y, double w, double h, int32_t *out, int max);
@@ -0,0 +1,181 @@
+#include "tilecollider.h"
+#include "map.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t TileCol_GidFlags(const tileCollider_t *tc, int32_t gid) {
+	if (gid <= 0) {
+		return 0;
+	}
+
+	return gid < tc->flagCount ? tc->flags[gid] : TILE_SOLID;
+}
+
+static void TileCol_Rebuild(tileCollider_t *tc) {
+	for (int i = 0; tc->gids != nullptr && i < tc->w * tc->h; i++) {
+		tc->cells[i] = TileCol_GidFlags(tc, tc->gids[i]);
+	}
+
+	tc->dirty = false;
+}
+
+bool TileCol_Init(tileCollider_t *tc, const tmx_map *map, int layer) {
+	memset(tc, 0, sizeof(*tc));
+
+	tmx_layer *lyr = Map_GetLayer(map, layer);
+	if (lyr == nullptr || lyr->type != L_LAYER) {
+		return false;
+	}
+
+	tc->w = (int)map->width;
+	tc->h = (int)map->height;
+	tc->tileW = (int)map->tile_width;
+	tc->tileH = (int)map->tile_height;
+	tc->map = map;
+	tc->layer = layer;
+
+	// copying an infinite map would decode every chunk, so those are looked up a cell at a time
+	if (!map->infinite) {
+		tc->gids = (int32_t*)malloc(sizeof(int32_t) * tc->w * tc->h);
+		tc->cells = (uint8_t*)malloc(tc->w * tc->h);
+		Map_GetTiles(map, layer, 0, 0, tc->w, tc->h, tc->gids);
+	}
+
+	// gids index map->tiles, so the table covers every gid the map can have
+	tc->flagCount = (int)map->tilecount + 1;
+	tc->flags = (uint8_t*)malloc(tc->flagCount);
+	memset(tc->flags, TILE_SOLID, tc->flagCount);
+	tc->flags[0] = 0;
+	TileCol_Rebuild(tc);
+
+	return true;
+}
+
+void TileCol_Free(tileCollider_t *tc) {
+	free(tc->gids);
+	free(tc->cells);
+	free(tc->flags);
+	memset(tc, 0, sizeof(*tc));
+}
+
+void TileCol_SetFlags(tileCollider_t *tc, int first, int last, uint8_t flags) {
+	first = first < 1 ? 1 : first;
+	last = last >= tc->flagCount ? tc->flagCount - 1 : last;
+	if (last < first) {
+		return;
+	}
+
+	memset(tc->flags + first, flags, last - first + 1);
+	tc->dirty = true;
+}
+
+static uint8_t TileCol_CellFlags(const tileCollider_t *tc, int tx, int ty, int32_t *gid) {
+	if (tx < 0 || tx >= tc->w) {
+		*gid = tc->borderH;
+		return TileCol_GidFlags(tc, tc->borderH);
+	}
+
+	if (ty < 0 || ty >= tc->h) {
+		*gid = tc->borderV;
+		return TileCol_GidFlags(tc, tc->borderV);
+	}
+
+	if (tc->gids == nullptr) {
+		*gid = (int32_t)Map_GetTile(tc->map, tc->layer, (unsigned int)tx, (unsigned int)ty);
+		return TileCol_GidFlags(tc, *gid);
+	}
+
+	*gid = tc->gids[ty * tc->w + tx];
+	return tc->cells[ty * tc->w + tx];
+}
+
+// same as the old script version, the tiles the box covers along one axis, with the far edge
+// extended by d. ranges run backwards when d is negative.
+static void TileCol_Range(double ts, double x, double w, double d, int *from, int *to) {
+	*from = (int)floor(x / ts);
+	double right = x + w + d;
+	right = right == floor(right) ? right - 1 : right;
+	*to = d >= 0 ? (int)floor(right / ts) : (int)floor((x + d) / ts);
+}
+
+static bool TileCol_Collides(tileCollider_t *tc, int tx, int ty, int side, double y, double h, double ldy, uint8_t mask) {
+	int32_t gid;
+	uint8_t flags = TileCol_CellFlags(tc, tx, ty, &gid);
+
+	// editor tiles never collide, no matter what the mask asks for
+	flags = (flags & TILE_EDITOR) ? 0 : flags & mask;
+	if (flags == 0) {
+		return false;
+	}
+
+	bool hit;
+	if (flags & TILE_ONEWAY) {
+		double top = (double)ty * tc->tileH;
+		hit = side == TILE_DIR_DOWN && y + h <= top && y + h + ldy > top;
+	}
+	else {
+		hit = (flags & TILE_SOLID) != 0;
+	}
+
+	if (hit) {
+		tc->side = side;
+		tc->tile = gid;
+		tc->tileX = tx;
+		tc->tileY = ty;
+	}
+
+	return hit;
+}
+
+double TileCol_Query(tileCollider_t *tc, double x, double y, double w, double h, int dim, double d, uint8_t mask) {
+	if (tc->dirty) {
+		TileCol_Rebuild(tc);
+	}
+
+	tc->side = 0;
+	tc->tile = 0;
+	tc->tileX = 0;
+	tc->tileY = 0;
+
+	int x0, x1, y0, y1;
+
+	if (dim == TILE_DIM_H) {
+		TileCol_Range(tc->tileW, x, w, d, &x0, &x1);
+		TileCol_Range(tc->tileH, y, h, 0, &y0, &y1);
+		int xStep = x1 >= x0 ? 1 : -1;
+		int yStep = y1 >= y0 ? 1 : -1;
+		int side = d < 0 ? TILE_DIR_LEFT : TILE_DIR_RIGHT;
+
+		for (int tx = x0; tx != x1 + xStep; tx += xStep) {
+			for (int ty = y0; ty != y1 + yStep; ty += yStep) {
+				if (TileCol_Collides(tc, tx, ty, side, y, h, 0, mask)) {
+					double origPos = x + d;
+					double edge = (tx + (d >= 0 ? 0 : 1)) * (double)tc->tileW - (d >= 0 ? w : 0);
+					double stop = d < 0 ? fmax(origPos, edge) : fmin(origPos, edge);
+					return stop - x;
+				}
+			}
+		}
+	}
+	else {
+		TileCol_Range(tc->tileW, x, w, 0, &x0, &x1);
+		TileCol_Range(tc->tileH, y, h, d, &y0, &y1);
+		int xStep = x1 >= x0 ? 1 : -1;
+		int yStep = y1 >= y0 ? 1 : -1;
+		int side = d < 0 ? TILE_DIR_UP : TILE_DIR_DOWN;
+
+		for (int ty = y0; ty != y1 + yStep; ty += yStep) {
+			for (int tx = x0; tx != x1 + xStep; tx += xStep) {
+				if (TileCol_Collides(tc, tx, ty, side, y, h, d, mask)) {
+					double origPos = y + d;
+					double edge = (ty + (d >= 0 ? 0 : 1)) * (double)tc->tileH - (d >= 0 ? h : 0);
+					double stop = d < 0 ? fmax(origPos, edge) : fmin(origPos, edge);
+					return stop - y;
+				}
+			}
+		}
+	}
+
+	return d;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// tilecollider.h - swept aabb queries against a tile layer, exposed to wren as TileCollider.
+// the grid copies the layer's gids when it's created, and each gid maps to a set of flags that
+// decide how (or if) it collides. layers of infinite maps aren't copied, cells are read from the
+// map's chunks as queries reach them.
+
+#include <stdint.h>
+#include <tmx.h>
+
+// tile flags, every gid other than 0 starts out solid
+#define TILE_SOLID (1 << 0)
+#define TILE_ONEWAY (1 << 1) // only collides when moving down onto the top of it
+#define TILE_EDITOR (1 << 2) // only shows up in the editor, never collides
+
+// values match Dim and Dir in collision.wren
+#define TILE_DIM_H 1
+#define TILE_DIM_V 2
+#define TILE_DIR_LEFT 1
+#define TILE_DIR_RIGHT 2
+#define TILE_DIR_UP 4
+#define TILE_DIR_DOWN 8
+
+typedef struct {
+	int w, h; // grid size in tiles
+	int tileW, tileH;
+	int32_t *gids; // nullptr for infinite maps
+
+	const tmx_map *map;
+	int layer;
+
+	uint8_t *flags; // indexed by gid
+	int flagCount;
+
+	uint8_t *cells; // flags for each cell, rebuilt from gids and flags when flags change
+	bool dirty;
+
+	// gids used for cells past the left/right and top/bottom edges of the grid
+	int32_t borderH, borderV;
+
+	// details of the tile the last query stopped at, side is 0 if nothing was hit
+	int side, tile, tileX, tileY;
+} tileCollider_t;
+
+// builds the grid from a tile layer of map. returns false if layer isn't a tile layer.
+bool TileCol_Init(tileCollider_t *tc, const tmx_map *map, int layer);
+void TileCol_Free(tileCollider_t *tc);
+
+// sets the flags for every gid from first to last, inclusive. last is clamped to the highest gid in the map.
+void TileCol_SetFlags(tileCollider_t *tc, int first, int last, uint8_t flags);
+
+// moves the box x, y, w, h by d along dim and returns how far it can go before hitting a tile.
+// only tiles with flags in mask are considered.
+double TileCol_Query(tileCollider_t *tc, double x, double y, double w, double h, int dim, double d, uint8_t mask);
@@ -52,6 +52,10 @@ typedef void* (*WrenReallocateFn)(void* memory, size_t newSize);
 // A function callable from Wren code, but implemented in C.
 typedef void (*WrenForeignMethodFn)(WrenVM* vm);
 
+// Called when a garbage collection starts (with [starting] true) and again
+// when it finishes.
+typedef void (*WrenGCFn)(WrenVM* vm, bool starting);
+
 // A finalizer function for freeing resources owned by an instance of a foreign
 // class. Unlike most foreign methods, finalizers do not have access to the VM
 // and should not interact with it since it's in the middle of a garbage
@@ -177,6 +181,12 @@ typedef struct
   // errors.
   WrenErrorFn errorFn;
 
+  // The callback Wren invokes around each garbage collection, for example to
+  // time them.
+  //
+  // If this is `NULL`, nothing is called.
+  WrenGCFn gcFn;
+
   // The number of bytes Wren will allocate before triggering the first garbage
   // collection.
   //
@@ -43,6 +43,7 @@ void wrenInitConfiguration(WrenConfiguration* config)
   config->bindForeignClassFn = NULL;
   config->writeFn = NULL;
   config->errorFn = NULL;
+  config->gcFn = NULL;
   config->initialHeapSize = 1024 * 1024 * 10;
   config->minHeapSize = 1024 * 1024;
   config->heapGrowthPercent = 50;
@@ -113,6 +114,8 @@ void wrenFreeVM(WrenVM* vm)
 
 void wrenCollectGarbage(WrenVM* vm)
 {
+  if (vm->config.gcFn != NULL) vm->config.gcFn(vm, true);
+
 #if WREN_DEBUG_TRACE_MEMORY || WREN_DEBUG_TRACE_GC
   printf("-- gc --\n");
 
@@ -194,6 +197,8 @@ void wrenCollectGarbage(WrenVM* vm)
          (unsigned long)vm->nextGC,
          elapsed);
 #endif
+
+  if (vm->config.gcFn != NULL) vm->config.gcFn(vm, false);
 }
 
 void* wrenReallocate(WrenVM* vm, void* memory, size_t oldSize, size_t newSize)
@@ -1,14 +1,17 @@
 #include "wrenapi.h"
+#include "wrenarray.h"
 #include "../src/slate2d.h"
 #include "game.h"
+#include <algorithm>
 #include <cstring>
+#include <vector>
 #include "wren/wren.hpp"
 extern "C" {
 #include "wren/wren_debug.h"
 }
 #include "map.h"
-#include <string>
-#include <map>
+#include "tilecollider.h"
+#include "spatialhash.h"
 #include <imgui.h>
 
 static unsigned int mapId;
@@ -33,7 +36,8 @@ bool wrenCheckArgs(WrenVM *vm, int count, ...) {
 	va_list args;
 	va_start(args, count);
 	for (int i = 1; i <= count; ++i) {
-		WrenType result = va_arg(args, WrenType);
+		// enums are promoted to int through ..., gcc aborts on va_arg with the enum type itself
+		WrenType result = (WrenType)va_arg(args, int);
 		WrenType slot = wrenGetSlotType(vm, i);
 		if (result == WREN_TYPE_UNKNOWN) {
 			continue;
@@ -210,6 +214,188 @@ void wren_trap_get_platform(WrenVM *vm) {
 	wrenSetSlotString(vm, 0, platform);
 }
 
+// reads started from script that haven't called back yet, so they can be cancelled when the vm is freed
+typedef struct {
+	WrenVM *vm;
+	WrenHandle *fn;
+	int request;
+} wrenAsyncRead_t;
+
+static std::vector<wrenAsyncRead_t*> asyncReads;
+
+static void wren_trap_read_done(int request, const char *path, const void *buffer, int size, void *userdata) {
+	NOTUSED(request);
+	NOTUSED(path);
+	wrenAsyncRead_t *read = (wrenAsyncRead_t*)userdata;
+	asyncReads.erase(std::find(asyncReads.begin(), asyncReads.end(), read));
+
+	WrenVM *vm = read->vm;
+	WrenHandle *callHnd = wrenMakeCallHandle(vm, "call(_)");
+	wrenEnsureSlots(vm, 2);
+	wrenSetSlotHandle(vm, 0, read->fn);
+	if (size < 0) {
+		wrenSetSlotNull(vm, 1);
+	}
+	else {
+		wrenSetSlotBytes(vm, 1, (const char*)buffer, size);
+	}
+	wrenCall(vm, callHnd);
+
+	wrenReleaseHandle(vm, callHnd);
+	wrenReleaseHandle(vm, read->fn);
+	delete read;
+}
+
+// readFileAsync(path, priority, fn) reads the file on the io thread and calls fn with its contents,
+// or null if it couldn't be read, at the start of a later frame. returns an id for cancelRead.
+void wren_trap_read_async(WrenVM *vm) {
+	CHECK_ARGS(3, WREN_TYPE_STRING, WREN_TYPE_NUM, WREN_TYPE_UNKNOWN);
+
+	wrenAsyncRead_t *read = new wrenAsyncRead_t();
+	read->vm = vm;
+	read->fn = wrenGetSlotHandle(vm, 3);
+	read->request = SLT_FS_ReadAsync(wrenGetSlotString(vm, 1), (int)wrenGetSlotDouble(vm, 2), wren_trap_read_done, read);
+
+	if (read->request < 0) {
+		wrenReleaseHandle(vm, read->fn);
+		delete read;
+		wrenSetSlotDouble(vm, 0, -1);
+		return;
+	}
+
+	asyncReads.push_back(read);
+	wrenSetSlotDouble(vm, 0, read->request);
+}
+
+static void wren_trap_cancel_read_at(size_t i) {
+	wrenAsyncRead_t *read = asyncReads[i];
+	SLT_FS_CancelAsync(read->request);
+	wrenReleaseHandle(read->vm, read->fn);
+	delete read;
+	asyncReads.erase(asyncReads.begin() + i);
+}
+
+void wren_trap_cancel_read(WrenVM *vm) {
+	CHECK_ARGS(1, WREN_TYPE_NUM);
+
+	int request = (int)wrenGetSlotDouble(vm, 1);
+	for (size_t i = 0; i < asyncReads.size(); i++) {
+		if (asyncReads[i]->vm == vm && asyncReads[i]->request == request) {
+			wren_trap_cancel_read_at(i);
+			wrenSetSlotBool(vm, 0, true);
+			return;
+		}
+	}
+
+	wrenSetSlotBool(vm, 0, false);
+}
+
+#pragma endregion
+
+#pragma region TileCollider Module
+
+// query(x, y, w, h, dim, d, mask) returns how far the box can move, side/tile/tileX/tileY
+// describe what it stopped at
+void wren_tilecol_query(WrenVM *vm) {
+	CHECK_ARGS(7, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	double x = wrenGetSlotDouble(vm, 1);
+	double y = wrenGetSlotDouble(vm, 2);
+	double w = wrenGetSlotDouble(vm, 3);
+	double h = wrenGetSlotDouble(vm, 4);
+	int dim = (int)wrenGetSlotDouble(vm, 5);
+	double d = wrenGetSlotDouble(vm, 6);
+	uint8_t mask = (uint8_t)wrenGetSlotDouble(vm, 7);
+
+	wrenSetSlotDouble(vm, 0, TileCol_Query(tc, x, y, w, h, dim, d, mask));
+}
+
+void wren_tilecol_setflags(WrenVM *vm) {
+	CHECK_ARGS(3, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	double first = wrenGetSlotDouble(vm, 1);
+	double last = wrenGetSlotDouble(vm, 2);
+	uint8_t flags = (uint8_t)wrenGetSlotDouble(vm, 3);
+
+	// clamp before converting so Num.largest works as "every gid after first"
+	first = first < 0 ? 0 : (first > INT32_MAX ? INT32_MAX : first);
+	last = last < -1 ? -1 : (last > INT32_MAX ? INT32_MAX : last);
+	TileCol_SetFlags(tc, (int)first, (int)last, flags);
+}
+
+void wren_tilecol_setborder(WrenVM *vm) {
+	CHECK_ARGS(2, WREN_TYPE_NUM, WREN_TYPE_NUM);
+
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	tc->borderH = (int32_t)wrenGetSlotDouble(vm, 1);
+	tc->borderV = (int32_t)wrenGetSlotDouble(vm, 2);
+}
+
+void wren_tilecol_side(WrenVM *vm) {
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, tc->side);
+}
+
+void wren_tilecol_tile(WrenVM *vm) {
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, tc->tile);
+}
+
+void wren_tilecol_tilex(WrenVM *vm) {
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, tc->tileX);
+}
+
+void wren_tilecol_tiley(WrenVM *vm) {
+	tileCollider_t *tc = (tileCollider_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, tc->tileY);
+}
+
+#pragma endregion
+
+#pragma region SpatialHash Module
+
+// insert(id, x, y, w, h), also used for move since inserting an id that's already there moves it
+void wren_shash_insert(WrenVM *vm) {
+	CHECK_ARGS(5, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+
+	spatialHash_t *hash = (spatialHash_t*)wrenGetSlotForeign(vm, 0);
+	int id = (int)wrenGetSlotDouble(vm, 1);
+	if (!SHash_Insert(hash, id, wrenGetSlotDouble(vm, 2), wrenGetSlotDouble(vm, 3), wrenGetSlotDouble(vm, 4), wrenGetSlotDouble(vm, 5))) {
+		wrenSetSlotString(vm, 0, "SpatialHash ids can't be negative");
+		wrenAbortFiber(vm, 0);
+	}
+}
+
+void wren_shash_remove(WrenVM *vm) {
+	CHECK_ARGS(1, WREN_TYPE_NUM);
+
+	spatialHash_t *hash = (spatialHash_t*)wrenGetSlotForeign(vm, 0);
+	SHash_Remove(hash, (int)wrenGetSlotDouble(vm, 1));
+}
+
+// query(x, y, w, h, out) fills the Int32Array out with the ids touching the rect and returns how
+// many there were. if that's more than out.count, only out.count of them were written.
+void wren_shash_query(WrenVM *vm) {
+	CHECK_ARGS(5, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_FOREIGN);
+
+	spatialHash_t *hash = (spatialHash_t*)wrenGetSlotForeign(vm, 0);
+	wrenArray_t *out = WrenArr_Get(vm, 5, WARR_INT32);
+	if (out == nullptr) {
+		return;
+	}
+
+	int found = SHash_Query(hash, wrenGetSlotDouble(vm, 1), wrenGetSlotDouble(vm, 2), wrenGetSlotDouble(vm, 3), wrenGetSlotDouble(vm, 4), WrenArr_Data(out, int32_t), out->count);
+	wrenSetSlotDouble(vm, 0, found);
+}
+
+void wren_shash_count(WrenVM *vm) {
+	spatialHash_t *hash = (spatialHash_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, hash->count);
+}
+
 #pragma endregion
 
 #pragma region CVar Module
@@ -253,18 +439,18 @@ void wren_cvar_set(WrenVM *vm) {
 		double value = wrenGetSlotDouble(vm, 1);
 		char cvarStr[1024];
 		snprintf(cvarStr, 1024, "%f", value);
-		SLT_Con_SetVar((*var)->name, cvarStr);
+		SLT_Con_SetVarHandle(*var, cvarStr);
 	}
 	else if (valType == WREN_TYPE_BOOL) {
 		bool value = wrenGetSlotBool(vm, 1);
-		SLT_Con_SetVar((*var)->name, value ? "1" : "0");
+		SLT_Con_SetVarHandle(*var, value ? "1" : "0");
 	}
 	else if (valType == WREN_TYPE_STRING) {
 		const char *value = wrenGetSlotString(vm, 1);
-		SLT_Con_SetVar((*var)->name, value);
+		SLT_Con_SetVarHandle(*var, value);
 	}
 	else {
-		SLT_Con_SetVar((*var)->name, "0");
+		SLT_Con_SetVarHandle(*var, "0");
 	}
 }
 
@@ -626,45 +812,388 @@ void wren_dc_clear(WrenVM *vm) {
 }
 #pragma endregion
 
-#pragma region Map Module
+#pragma region DrawBuffer Module
+
+// draw commands recorded from script into native memory and turned into render commands
+// by a single flush() call. each command is an opcode byte followed by a fixed number of
+// floats in args. flush doesn't clear, so a buffer that doesn't change can be replayed
+// every frame without going back to script.
+typedef enum {
+	DBUF_SETCOLOR,
+	DBUF_RESETTRANSFORM,
+	DBUF_TRANSLATE,
+	DBUF_RECT,
+	DBUF_IMAGE,
+	DBUF_LINE,
+	DBUF_CIRCLE,
+	DBUF_TRI,
+	DBUF_SPRITE,
+} drawBufferOp_t;
+
+static const int drawBufferOpArgs[] = { 4, 0, 2, 5, 9, 4, 4, 7, 8 };
+
+typedef struct {
+	uint8_t *ops;
+	int opCount;
+	int opCapacity;
+
+	float *args;
+	int argCount;
+	int argCapacity;
+} drawBuffer_t;
+
+// commands replayed by every flush since the last Wren_ReportStats
+static int64_t drawBufferCmds = 0;
+
+// a buffer holds at most this many args, which keeps the counts and the capacity doubling below from overflowing
+#define DRAWBUF_MAX_ARGS (1 << 28)
+
+// makes room for opc more ops and argc more args, false if the buffer would get too big or
+// the allocation failed. the buffer is left as it was on failure.
+static bool DrawBuf_Reserve(drawBuffer_t *buf, int64_t opc, int64_t argc) {
+	if ((int64_t)buf->argCount + argc > DRAWBUF_MAX_ARGS || (int64_t)buf->opCount + opc > DRAWBUF_MAX_ARGS) {
+		return false;
+	}
+
+	if (buf->opCount + opc > buf->opCapacity) {
+		int capacity = buf->opCapacity > 0 ? buf->opCapacity : 64;
+		while (buf->opCount + opc > capacity) {
+			capacity *= 2;
+		}
+		uint8_t *ops = (uint8_t*)realloc(buf->ops, capacity);
+		if (ops == nullptr) {
+			return false;
+		}
+		buf->ops = ops;
+		buf->opCapacity = capacity;
+	}
+
+	if (buf->argCount + argc > buf->argCapacity) {
+		int capacity = buf->argCapacity > 0 ? buf->argCapacity : 256;
+		while (buf->argCount + argc > capacity) {
+			capacity *= 2;
+		}
+		float *args = (float*)realloc(buf->args, capacity * sizeof(float));
+		if (args == nullptr) {
+			return false;
+		}
+		buf->args = args;
+		buf->argCapacity = capacity;
+	}
+
+	return true;
+}
+
+// appends count commands of the same op and returns where their args go, or nullptr if the buffer would get too big
+static float* DrawBuf_Push(drawBuffer_t *buf, drawBufferOp_t op, int count) {
+	int64_t argc = (int64_t)drawBufferOpArgs[op] * count;
+	if (!DrawBuf_Reserve(buf, count, argc)) {
+		return nullptr;
+	}
+
+	memset(&buf->ops[buf->opCount], op, count);
+	buf->opCount += count;
+
+	float *args = &buf->args[buf->argCount];
+	buf->argCount += (int)argc;
+	return args;
+}
+
+// callers check the slot types first, same as the Draw methods
+static void wren_dbuf_write(WrenVM *vm, drawBufferOp_t op) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	int argc = drawBufferOpArgs[op];
+	float *args = DrawBuf_Push(buf, op, 1);
+	if (args == nullptr) {
+		wrenSetSlotString(vm, 0, "DrawBuffer is full");
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+
+	// outline flags come in as bools, everything else is a number
+	for (int i = 0; i < argc; i++) {
+		args[i] = wrenGetSlotType(vm, i + 1) == WREN_TYPE_BOOL ? (wrenGetSlotBool(vm, i + 1) ? 1.0f : 0.0f) : (float)wrenGetSlotDouble(vm, i + 1);
+	}
+}
+
+void wren_dbuf_setcolor(WrenVM *vm) {
+	CHECK_ARGS(4, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+	wren_dbuf_write(vm, DBUF_SETCOLOR);
+}
+
+void wren_dbuf_reset_transform(WrenVM *vm) {
+	wren_dbuf_write(vm, DBUF_RESETTRANSFORM);
+}
+
+void wren_dbuf_translate(WrenVM *vm) {
+	CHECK_ARGS(2, WREN_TYPE_NUM, WREN_TYPE_NUM);
+	wren_dbuf_write(vm, DBUF_TRANSLATE);
+}
+
+void wren_dbuf_rect(WrenVM *vm) {
+	CHECK_ARGS(5, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_BOOL);
+	wren_dbuf_write(vm, DBUF_RECT);
+}
+
+void wren_dbuf_image(WrenVM *vm) {
+	CHECK_ARGS(9, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM,
+		WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+	wren_dbuf_write(vm, DBUF_IMAGE);
+}
+
+void wren_dbuf_line(WrenVM *vm) {
+	CHECK_ARGS(4, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+	wren_dbuf_write(vm, DBUF_LINE);
+}
+
+void wren_dbuf_circle(WrenVM *vm) {
+	CHECK_ARGS(4, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_BOOL);
+	wren_dbuf_write(vm, DBUF_CIRCLE);
+}
+
+void wren_dbuf_tri(WrenVM *vm) {
+	CHECK_ARGS(7, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_BOOL);
+	wren_dbuf_write(vm, DBUF_TRI);
+}
 
-void parseProperties(WrenVM *vm, int propSlot, int *totalSlotsIn, int *sIn, void *properties) {
-	int &s = *sIn;
-	int &totalSlots = *totalSlotsIn;
-
-	// loop through properties
-	if (properties != nullptr) {
-		auto &props = *(std::map<std::string, void *>*) properties;
-
-		for (auto item : props) {
-			// add 2 slots for key, value
-			totalSlots += 2;
-			wrenEnsureSlots(vm, totalSlots);
-
-			auto prop = (tmx_property*)item.second;
-			wrenSetSlotString(vm, s++, prop->name);
-			switch (prop->type) {
-			case PT_INT:
-				wrenSetSlotDouble(vm, s++, prop->value.integer);
-				break;
-			case PT_FLOAT:
-				wrenSetSlotDouble(vm, s++, prop->value.decimal);
-				break;
-			case PT_BOOL:
-				wrenSetSlotBool(vm, s++, prop->value.boolean);
-				break;
-			case PT_COLOR:
-				wrenSetSlotDouble(vm, s++, prop->value.color);
-				break;
-			case PT_NONE:
-			case PT_STRING:
-			case PT_FILE:
-			default:
-				wrenSetSlotString(vm, s++, prop->value.string);
-				break;
+void wren_dbuf_sprite(WrenVM *vm) {
+	CHECK_ARGS(8, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM,
+		WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+	wren_dbuf_write(vm, DBUF_SPRITE);
+}
+
+// rects(xywh, outline) records a rect for every 4 floats in a Float32Array
+void wren_dbuf_rects(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	wrenArray_t *arr = WrenArr_Get(vm, 1, WARR_FLOAT32);
+	if (arr == nullptr) {
+		return;
+	}
+
+	if (wrenGetSlotType(vm, 2) != WREN_TYPE_BOOL) {
+		wrenSetSlotString(vm, 0, "expected a bool in parameter 2");
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+
+	float outline = wrenGetSlotBool(vm, 2) ? 1.0f : 0.0f;
+	const float *src = WrenArr_Data(arr, float);
+	int count = arr->count / 4;
+	float *args = DrawBuf_Push(buf, DBUF_RECT, count);
+	if (args == nullptr) {
+		wrenSetSlotString(vm, 0, "DrawBuffer is full");
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+	for (int i = 0; i < count; i++, src += 4, args += 5) {
+		memcpy(args, src, 4 * sizeof(float));
+		args[4] = outline;
+	}
+}
+
+// colorRects(data, palette) records a rect for every x, y, w, h, color, outline in a Float32Array,
+// setting the color to entry color of a Float32Array of r, g, b, a first. outline is non-zero for
+// outline. flush drops the color changes that repeat, so rects sharing a color stay one draw.
+void wren_dbuf_colorrects(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	wrenArray_t *arr = WrenArr_Get(vm, 1, WARR_FLOAT32);
+	if (arr == nullptr) {
+		return;
+	}
+
+	wrenArray_t *pal = WrenArr_Get(vm, 2, WARR_FLOAT32);
+	if (pal == nullptr) {
+		return;
+	}
+
+	const float *src = WrenArr_Data(arr, float);
+	const float *colors = WrenArr_Data(pal, float);
+	int count = arr->count / 6;
+	int colorCount = pal->count / 4;
+	for (int i = 0; i < count; i++) {
+		float c = src[i * 6 + 4];
+		if (!(c >= 0 && c < colorCount) || c != (int)c) {
+			wrenSetSlotString(vm, 0, gtempstr("rect %i has color %g, palette has %i colors", i, c, colorCount));
+			wrenAbortFiber(vm, 0);
+			return;
+		}
+	}
+
+	int argc = drawBufferOpArgs[DBUF_SETCOLOR] + drawBufferOpArgs[DBUF_RECT];
+	if (!DrawBuf_Reserve(buf, (int64_t)count * 2, (int64_t)count * argc)) {
+		wrenSetSlotString(vm, 0, "DrawBuffer is full");
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+
+	uint8_t *ops = &buf->ops[buf->opCount];
+	float *args = &buf->args[buf->argCount];
+	for (int i = 0; i < count; i++, src += 6, args += argc) {
+		*ops++ = DBUF_SETCOLOR;
+		*ops++ = DBUF_RECT;
+		memcpy(args, &colors[(int)src[4] * 4], 4 * sizeof(float));
+		memcpy(&args[4], src, 4 * sizeof(float));
+		args[8] = src[5] != 0 ? 1.0f : 0.0f;
+	}
+	buf->opCount += count * 2;
+	buf->argCount += count * argc;
+}
+
+// sprites(sprId, idxy) records an unscaled, unflipped sprite for every id, x, y triple in a Float32Array
+void wren_dbuf_sprites(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	if (wrenGetSlotType(vm, 1) != WREN_TYPE_NUM) {
+		wrenSetSlotString(vm, 0, "expected a number in parameter 1");
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+
+	float sprId = (float)wrenGetSlotDouble(vm, 1);
+	wrenArray_t *arr = WrenArr_Get(vm, 2, WARR_FLOAT32);
+	if (arr == nullptr) {
+		return;
+	}
+
+	const float *src = WrenArr_Data(arr, float);
+	int count = arr->count / 3;
+	float *args = DrawBuf_Push(buf, DBUF_SPRITE, count);
+	if (args == nullptr) {
+		wrenSetSlotString(vm, 0, "DrawBuffer is full");
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+	for (int i = 0; i < count; i++, src += 3, args += 8) {
+		args[0] = sprId;
+		args[1] = src[0];
+		args[2] = src[1];
+		args[3] = src[2];
+		args[4] = 1.0f;
+		args[5] = 0;
+		args[6] = 1.0f;
+		args[7] = 1.0f;
+	}
+}
+
+void wren_dbuf_flush(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	const float *a = buf->args;
+
+	// color changes are only passed on when they actually change the color
+	uint32_t lastColor = 0;
+	bool haveColor = false;
+
+	for (int i = 0; i < buf->opCount; i++) {
+		switch (buf->ops[i]) {
+		case DBUF_SETCOLOR: {
+			uint8_t r = (uint8_t)a[0], g = (uint8_t)a[1], b = (uint8_t)a[2], al = (uint8_t)a[3];
+			uint32_t color = (uint32_t)r | (uint32_t)g << 8 | (uint32_t)b << 16 | (uint32_t)al << 24;
+			if (!haveColor || color != lastColor) {
+				DC_SetColor(r, g, b, al);
+				lastColor = color;
+				haveColor = true;
 			}
-			wrenInsertInMap(vm, propSlot, s - 2, s - 1);
+			break;
+		}
+		case DBUF_RESETTRANSFORM:
+			DC_ResetTransform();
+			break;
+		case DBUF_TRANSLATE:
+			DC_Translate(a[0], a[1]);
+			break;
+		case DBUF_RECT:
+			DC_DrawRect(a[0], a[1], a[2], a[3], (uint8_t)a[4]);
+			break;
+		case DBUF_IMAGE:
+			DC_DrawImage((AssetHandle)a[0], a[1], a[2], a[3], a[4], a[5], (uint8_t)a[6], a[7], a[8]);
+			break;
+		case DBUF_LINE:
+			DC_DrawLine(a[0], a[1], a[2], a[3]);
+			break;
+		case DBUF_CIRCLE:
+			DC_DrawCircle(a[0], a[1], a[2], a[3] != 0);
+			break;
+		case DBUF_TRI:
+			DC_DrawTri(a[0], a[1], a[2], a[3], a[4], a[5], a[6] != 0);
+			break;
+		case DBUF_SPRITE:
+			DC_DrawSprite((AssetHandle)a[0], (int)a[1], a[2], a[3], a[4], (uint8_t)a[5], (int)a[6], (int)a[7]);
+			break;
+		}
+
+		a += drawBufferOpArgs[buf->ops[i]];
+	}
+
+	drawBufferCmds += buf->opCount;
+}
+
+void wren_dbuf_clear(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	buf->opCount = 0;
+	buf->argCount = 0;
+}
+
+void wren_dbuf_count(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, buf->opCount);
+}
+
+#pragma endregion
+
+#pragma region Map Module
+
+// the map's strings are interned when it loads (see tmxMapInfo_t), so each one only has to be made
+// into a wren string once per call. they're kept in a list in listSlot and copied out of it after that.
+typedef struct {
+	const tmxMapInfo_t *info;
+	int listSlot;
+	int listCount;
+	int *listPos; // position in the list for each string id, -1 until it's been made
+} mapStrings_t;
+
+static void mapStringsInit(WrenVM *vm, mapStrings_t *strs, const tmx_map *map, int listSlot) {
+	strs->info = SLT_TMX_GetInfo(map);
+	strs->listSlot = listSlot;
+	strs->listCount = 0;
+	strs->listPos = (int*)malloc(sizeof(int) * (strs->info->stringCount > 0 ? strs->info->stringCount : 1));
+	memset(strs->listPos, -1, sizeof(int) * strs->info->stringCount);
+	wrenSetSlotNewList(vm, listSlot);
+}
+
+static void setMapString(WrenVM *vm, mapStrings_t *strs, int slot, int id) {
+	if (strs->listPos[id] >= 0) {
+		wrenGetListElement(vm, strs->listSlot, strs->listPos[id], slot);
+		return;
+	}
+
+	wrenSetSlotString(vm, slot, TMX_String(strs->info, id));
+	wrenInsertInList(vm, strs->listSlot, -1, slot);
+	strs->listPos[id] = strs->listCount++;
+}
+
+// inserts the range of properties into the map in mapSlot, keySlot and valSlot are scratch
+static void setMapProperties(WrenVM *vm, mapStrings_t *strs, int mapSlot, int start, int count, int keySlot, int valSlot) {
+	for (int i = start; i < start + count; i++) {
+		const tmxPropInfo_t *prop = &strs->info->props[i];
+		setMapString(vm, strs, keySlot, prop->name);
+
+		switch (prop->type) {
+		case PT_INT:
+		case PT_FLOAT:
+		case PT_COLOR:
+			wrenSetSlotDouble(vm, valSlot, prop->value.number);
+			break;
+		case PT_BOOL:
+			wrenSetSlotBool(vm, valSlot, prop->value.number != 0);
+			break;
+		case PT_NONE:
+		case PT_STRING:
+		case PT_FILE:
+		default:
+			setMapString(vm, strs, valSlot, prop->value.string);
+			break;
 		}
+
+		wrenInsertInMap(vm, mapSlot, keySlot, valSlot);
 	}
 }
 
@@ -690,106 +1219,106 @@ void wren_map_getobjectsinlayer(WrenVM *vm) {
 	CHECK_ARGS(1, WREN_TYPE_NUM);
 
 	int id = (int) wrenGetSlotDouble(vm, 1);
-	int totalSlots = 1; // total num of slots for wrenEnsureSlots
-	int s = 1; // current slot we're on
 
 	static const char *keys[] = { "name", "type", "x", "y", "width", "height", "visible", "rotation", "properties" };
 	static const int keySz = sizeof(keys) / sizeof(*keys);
 
-	// reserve keys
-	totalSlots += keySz;
-	wrenEnsureSlots(vm, totalSlots);
-
-	// return value is a list of map objects
+	// 0 is the returned list, 1 holds the strings, then the keys, then the object being built
+	const int keySlot = 2, objSlot = keySlot + keySz, propSlot = objSlot + 1, tmpKey = propSlot + 1, tmpVal = tmpKey + 1;
+	wrenEnsureSlots(vm, tmpVal + 1);
 	wrenSetSlotNewList(vm, 0);
 
-	// store the keys starting from slot 1 since they can be reused
+	const tmx_map *map = SLT_Get_TMX(mapId);
+	const tmxMapInfo_t *info = SLT_TMX_GetInfo(map);
+	if (id < 0 || id >= info->layerCount) {
+		return;
+	}
+
+	mapStrings_t strs;
+	mapStringsInit(vm, &strs, map, 1);
+
 	for (int i = 0; i < keySz; i++) {
-		wrenSetSlotString(vm, s++, keys[i]);
+		wrenSetSlotString(vm, keySlot + i, keys[i]);
 	}
 
-	const tmx_map *map = SLT_Get_TMX(mapId);
-	tmx_object *obj = Map_LayerObjects(map, id, nullptr);
-	while (obj != nullptr) {
-		// ensure enough slots for map object + map values
-		totalSlots += keySz + 1;
-		wrenEnsureSlots(vm, totalSlots);
+	const tmxLayerInfo_t *layer = &info->layers[id];
+	for (int i = layer->objectStart; i < layer->objectStart + layer->objectCount; i++) {
+		const tmxObjectInfo_t *obj = &info->objects[i];
 
 		// make a new map, push it to the end of the return value list
-		int mapSlot = s++;
-		wrenSetSlotNewMap(vm, mapSlot);
-		wrenInsertInList(vm, 0, -1, mapSlot);
-
-		// slots for property values, same order as keys[]
-		wrenSetSlotString(vm, s++, obj->name == nullptr ? "" : obj->name);
-		const char *defaultedType = Map_GetObjectType(map, obj);
-		wrenSetSlotString(vm, s++, defaultedType == nullptr ? "" : defaultedType);
-		wrenSetSlotDouble(vm, s++, obj->x);
-		wrenSetSlotDouble(vm, s++, obj->y);
-		wrenSetSlotDouble(vm, s++, obj->width);
-		wrenSetSlotDouble(vm, s++, obj->height);
-		wrenSetSlotBool(vm, s++, obj->visible);
-		wrenSetSlotDouble(vm, s++, obj->rotation);
-
-		// properties is a nested map, we'll populate it after we deal with the object
-		int propSlot = s++;
+		wrenSetSlotNewMap(vm, objSlot);
+		wrenInsertInList(vm, 0, -1, objSlot);
+
+		// values go in the same order as keys[]
+		setMapString(vm, &strs, tmpVal, obj->name);
+		wrenInsertInMap(vm, objSlot, keySlot + 0, tmpVal);
+		setMapString(vm, &strs, tmpVal, obj->type);
+		wrenInsertInMap(vm, objSlot, keySlot + 1, tmpVal);
+		wrenSetSlotDouble(vm, tmpVal, obj->x);
+		wrenInsertInMap(vm, objSlot, keySlot + 2, tmpVal);
+		wrenSetSlotDouble(vm, tmpVal, obj->y);
+		wrenInsertInMap(vm, objSlot, keySlot + 3, tmpVal);
+		wrenSetSlotDouble(vm, tmpVal, obj->width);
+		wrenInsertInMap(vm, objSlot, keySlot + 4, tmpVal);
+		wrenSetSlotDouble(vm, tmpVal, obj->height);
+		wrenInsertInMap(vm, objSlot, keySlot + 5, tmpVal);
+		wrenSetSlotBool(vm, tmpVal, obj->visible != 0);
+		wrenInsertInMap(vm, objSlot, keySlot + 6, tmpVal);
+		wrenSetSlotDouble(vm, tmpVal, obj->rotation);
+		wrenInsertInMap(vm, objSlot, keySlot + 7, tmpVal);
+
+		// properties is a nested map, tile defaults were already merged in when the map loaded
 		wrenSetSlotNewMap(vm, propSlot);
-
-		// apply the default properties first if it is a tile
-		if (obj->obj_type == OT_TILE) {
-			tmx_tile *baseTile = Map_GetTileInfo(map, obj->content.gid);
-			if (baseTile != nullptr) {
-				parseProperties(vm, propSlot, &totalSlots, &s, baseTile->properties);
-			}
-		}
-		// add the object
-		parseProperties(vm, propSlot, &totalSlots, &s, obj->properties);
-
-		for (int i = 0; i < keySz; i++) {
-			// i + 1 because 0 is return value. keys are at the top, values are placed after the map
-			wrenInsertInMap(vm, mapSlot, i + 1, mapSlot + 1 + i);
-		}
-
-		obj = Map_LayerObjects(map, id, obj);
+		wrenInsertInMap(vm, objSlot, keySlot + 8, propSlot);
+		setMapProperties(vm, &strs, propSlot, obj->propStart, obj->propCount, tmpKey, tmpVal);
 	}
+
+	free(strs.listPos);
 }
 
 void wren_map_getmapproperties(WrenVM *vm) {
-	static const char *keys[] = { "width", "height", "tileWidth", "tileHeight", "backgroundColor", "properties" };
+	static const char *keys[] = { "width", "height", "tileWidth", "tileHeight", "backgroundColor", "properties", "infinite", "originX", "originY" };
 	static const int keySz = sizeof(keys) / sizeof(*keys);
 
 	const tmx_map *map = SLT_Get_TMX(mapId);
+	const tmxMapInfo_t *info = SLT_TMX_GetInfo(map);
 
-	int totalSlots = 1; // total num of slots for wrenEnsureSlots
-	int s = 1; // current slot we're on
-
-	// reserve keys
-	totalSlots += keySz * 2;
-	wrenEnsureSlots(vm, totalSlots);
-
-	// return value is a map
+	// 0 is the returned map, 1 holds the strings, then the keys
+	const int keySlot = 2, propSlot = keySlot + keySz, tmpKey = propSlot + 1, tmpVal = tmpKey + 1;
+	wrenEnsureSlots(vm, tmpVal + 1);
 	wrenSetSlotNewMap(vm, 0);
 
-	// store the keys starting from slot 1
+	mapStrings_t strs;
+	mapStringsInit(vm, &strs, map, 1);
+
 	for (int i = 0; i < keySz; i++) {
-		wrenSetSlotString(vm, s++, keys[i]);
+		wrenSetSlotString(vm, keySlot + i, keys[i]);
 	}
 
 	// values
-	wrenSetSlotDouble(vm, s++, map->width);
-	wrenSetSlotDouble(vm, s++, map->height);
-	wrenSetSlotDouble(vm, s++, map->tile_width);
-	wrenSetSlotDouble(vm, s++, map->tile_height);
-	wrenSetSlotDouble(vm, s++, map->backgroundcolor);
+	wrenSetSlotDouble(vm, tmpVal, map->width);
+	wrenInsertInMap(vm, 0, keySlot + 0, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, map->height);
+	wrenInsertInMap(vm, 0, keySlot + 1, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, map->tile_width);
+	wrenInsertInMap(vm, 0, keySlot + 2, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, map->tile_height);
+	wrenInsertInMap(vm, 0, keySlot + 3, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, map->backgroundcolor);
+	wrenInsertInMap(vm, 0, keySlot + 4, tmpVal);
 
-	int propSlot = s++;
 	wrenSetSlotNewMap(vm, propSlot);
+	wrenInsertInMap(vm, 0, keySlot + 5, propSlot);
+	setMapProperties(vm, &strs, propSlot, info->mapPropStart, info->mapPropCount, tmpKey, tmpVal);
 
-	parseProperties(vm, propSlot, &totalSlots, &s, map->properties);
+	wrenSetSlotBool(vm, tmpVal, map->infinite != 0);
+	wrenInsertInMap(vm, 0, keySlot + 6, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, info->originX);
+	wrenInsertInMap(vm, 0, keySlot + 7, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, info->originY);
+	wrenInsertInMap(vm, 0, keySlot + 8, tmpVal);
 
-	for (int i = 0; i < keySz; i++) {
-		wrenInsertInMap(vm, 0, 1 + i, 1 + keySz + i);
-	}
+	free(strs.listPos);
 }
 
 void wren_map_getlayerproperties(WrenVM *vm) {
@@ -798,6 +1327,7 @@ void wren_map_getlayerproperties(WrenVM *vm) {
 	int id = (int)wrenGetSlotDouble(vm, 1);
 
 	const tmx_map *map = SLT_Get_TMX(mapId);
+	const tmxMapInfo_t *info = SLT_TMX_GetInfo(map);
 	tmx_layer *layer = Map_GetLayer(map, id);
 
 	if (layer == nullptr) {
@@ -807,66 +1337,62 @@ void wren_map_getlayerproperties(WrenVM *vm) {
 	static const char *keys[] = { "name", "visible", "opacity", "offsetX", "offsetY", "properties" };
 	static const int keySz = sizeof(keys) / sizeof(*keys);
 
-	int totalSlots = 1; // total num of slots for wrenEnsureSlots
-	int s = 1; // current slot we're on
-
-	// reserve keys
-	totalSlots += keySz * 2;
-	wrenEnsureSlots(vm, totalSlots);
-
-	// return value is a map
+	// 0 is the returned map, 1 holds the strings, then the keys
+	const int keySlot = 2, propSlot = keySlot + keySz, tmpKey = propSlot + 1, tmpVal = tmpKey + 1;
+	wrenEnsureSlots(vm, tmpVal + 1);
 	wrenSetSlotNewMap(vm, 0);
 
-	// store the keys starting from slot 1
+	mapStrings_t strs;
+	mapStringsInit(vm, &strs, map, 1);
+
 	for (int i = 0; i < keySz; i++) {
-		wrenSetSlotString(vm, s++, keys[i]);
+		wrenSetSlotString(vm, keySlot + i, keys[i]);
 	}
 
-	wrenSetSlotString(vm, s++, layer->name == nullptr ? "" : layer->name);
-	wrenSetSlotBool(vm, s++, layer->visible);
-	wrenSetSlotDouble(vm, s++, layer->opacity);
-	wrenSetSlotDouble(vm, s++, layer->offsetx);
-	wrenSetSlotDouble(vm, s++, layer->offsety);
-	int propSlot = s++;
-	wrenSetSlotNewMap(vm, propSlot);
+	wrenSetSlotString(vm, tmpVal, layer->name == nullptr ? "" : layer->name);
+	wrenInsertInMap(vm, 0, keySlot + 0, tmpVal);
+	wrenSetSlotBool(vm, tmpVal, layer->visible);
+	wrenInsertInMap(vm, 0, keySlot + 1, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, layer->opacity);
+	wrenInsertInMap(vm, 0, keySlot + 2, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, layer->offsetx);
+	wrenInsertInMap(vm, 0, keySlot + 3, tmpVal);
+	wrenSetSlotDouble(vm, tmpVal, layer->offsety);
+	wrenInsertInMap(vm, 0, keySlot + 4, tmpVal);
 
-	parseProperties(vm, propSlot, &totalSlots, &s, layer->properties);
+	wrenSetSlotNewMap(vm, propSlot);
+	wrenInsertInMap(vm, 0, keySlot + 5, propSlot);
+	setMapProperties(vm, &strs, propSlot, info->layers[id].propStart, info->layers[id].propCount, tmpKey, tmpVal);
 
-	for (int i = 0; i < keySz; i++) {
-		wrenInsertInMap(vm, 0, 1 + i, 1 + keySz + i);
-	}
+	free(strs.listPos);
 }
 
 void wren_map_gettileproperties(WrenVM *vm) {
 	const tmx_map *map = SLT_Get_TMX(mapId);
+	const tmxMapInfo_t *info = SLT_TMX_GetInfo(map);
 
-	int totalSlots = 2; // total num of slots for wrenEnsureSlots
-	int s = 1; // current slot we're on
-
-	// return value is a list of map objects
+	// 0 is the returned list of maps, 1 holds the strings
+	const int typeKey = 2, tileSlot = 3, tmpKey = 4, tmpVal = 5;
+	wrenEnsureSlots(vm, tmpVal + 1);
 	wrenSetSlotNewList(vm, 0);
 
-	wrenEnsureSlots(vm, totalSlots);
-	wrenSetSlotString(vm, s++, "type");
-
-	for (unsigned int gid = 0; gid < map->tilecount; gid++) {
-		tmx_tile *tile = Map_GetTileInfo(map, gid);
-		if (tile == nullptr) {
-			continue;
-		}
+	mapStrings_t strs;
+	mapStringsInit(vm, &strs, map, 1);
+	wrenSetSlotString(vm, typeKey, "type");
 
-		totalSlots += 3;
-		wrenEnsureSlots(vm, totalSlots);
+	for (int i = 0; i < info->tileCount; i++) {
+		const tmxTileInfo_t *tile = &info->tiles[i];
 
-		int propSlot = s++;
-		wrenSetSlotNewMap(vm, propSlot);
-		wrenInsertInList(vm, 0, -1, propSlot);
+		wrenSetSlotNewMap(vm, tileSlot);
+		wrenInsertInList(vm, 0, -1, tileSlot);
 
-		wrenSetSlotString(vm, s++, tile->type == nullptr ? "" : tile->type);
-		wrenInsertInMap(vm, propSlot, 1, s - 1);
+		setMapString(vm, &strs, tmpVal, tile->type);
+		wrenInsertInMap(vm, tileSlot, typeKey, tmpVal);
 
-		parseProperties(vm, propSlot, &totalSlots, &s, tile->properties);
+		setMapProperties(vm, &strs, tileSlot, tile->propStart, tile->propCount, tmpKey, tmpVal);
 	}
+
+	free(strs.listPos);
 }
 
 void wren_map_gettile(WrenVM *vm) {
@@ -882,6 +1408,60 @@ void wren_map_gettile(WrenVM *vm) {
 	wrenSetSlotDouble(vm, 0, gid);
 }
 
+// getTiles(id, x, y, w, h) returns a new Int32Array of the gids in the block, see Map_GetTiles.
+// getTiles(id, x, y, w, h, out) fills and returns an existing one so per frame queries don't allocate.
+static void wren_map_gettiles_common(WrenVM *vm, bool hasOut) {
+	int layer = (int)wrenGetSlotDouble(vm, 1);
+	int x = (int)wrenGetSlotDouble(vm, 2);
+	int y = (int)wrenGetSlotDouble(vm, 3);
+	int w = (int)wrenGetSlotDouble(vm, 4);
+	int h = (int)wrenGetSlotDouble(vm, 5);
+	w = w < 0 ? 0 : w;
+	h = h < 0 ? 0 : h;
+
+	if ((int64_t)w * h > INT32_MAX / (int64_t)sizeof(int32_t)) {
+		wrenSetSlotString(vm, 0, gtempstr("TMX.getTiles: %ix%i tiles is too many", w, h));
+		wrenAbortFiber(vm, 0);
+		return;
+	}
+
+	wrenArray_t *out;
+	if (hasOut) {
+		out = WrenArr_Get(vm, 6, WARR_INT32);
+		if (out == nullptr) {
+			return;
+		}
+
+		if (out->count < w * h) {
+			wrenSetSlotString(vm, 0, gtempstr("TMX.getTiles: array of %i is too small for %ix%i tiles", out->count, w, h));
+			wrenAbortFiber(vm, 0);
+			return;
+		}
+
+		WrenHandle *hnd = wrenGetSlotHandle(vm, 6);
+		wrenSetSlotHandle(vm, 0, hnd);
+		wrenReleaseHandle(vm, hnd);
+	}
+	else {
+		out = WrenArr_New(vm, 0, WARR_INT32, w * h);
+	}
+
+	const tmx_map *map = SLT_Get_TMX(mapId);
+	if (Map_GetTiles(map, layer, x, y, w, h, WrenArr_Data(out, int32_t)) == 0) {
+		memset(WrenArr_Data(out, int32_t), 0, w * h * sizeof(int32_t));
+	}
+}
+
+void wren_map_gettiles(WrenVM *vm) {
+	CHECK_ARGS(5, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM);
+	wren_map_gettiles_common(vm, false);
+}
+
+void wren_map_gettiles_out(WrenVM *vm) {
+	CHECK_ARGS(6, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_NUM, WREN_TYPE_FOREIGN);
+	wren_map_gettiles_common(vm, true);
+}
+
 void wren_map_getlayernames(WrenVM *vm) {
 	int i = 0;
 
@@ -925,6 +1505,35 @@ static void wren_error(WrenVM* vm, WrenErrorType type, const char* module, int l
 	}
 }
 
+// counted so benchmarks can report how much script code allocates, see Wren_ReportStats
+static int64_t allocCount = 0;
+static int64_t gcCount = 0;
+
+static void* wren_reallocate(void* memory, size_t newSize) {
+	if (newSize == 0) {
+		free(memory);
+		return nullptr;
+	}
+
+	if (memory == nullptr) {
+		allocCount++;
+	}
+
+	return realloc(memory, newSize);
+}
+
+static void wren_gc(WrenVM* vm, bool starting) {
+	NOTUSED(vm);
+
+	if (starting) {
+		gcCount++;
+		SLT_Prof_Begin("wren gc");
+	}
+	else {
+		SLT_Prof_End();
+	}
+}
+
 char* wren_loadModuleFn(WrenVM* vm, const char* name) {
 	NOTUSED(vm);
 
@@ -964,6 +1573,8 @@ static const wrenMethodDef methods[] = {
 	{ "engine", "Trap", true, "getResolution()", wren_trap_get_resolution },
 	{ "engine", "Trap", true, "setWindowTitle(_)", wren_trap_set_window_title },
 	{ "engine", "Trap", true, "getPlatform()", wren_trap_get_platform },
+	{ "engine", "Trap", true, "readFileAsync(_,_,_)", wren_trap_read_async },
+	{ "engine", "Trap", true, "cancelRead(_)", wren_trap_cancel_read },
 
 	{ "engine", "CVar", false, "bool()", wren_cvar_bool },
 	{ "engine", "CVar", false, "number()", wren_cvar_number },
@@ -1005,6 +1616,52 @@ static const wrenMethodDef methods[] = {
 	{ "engine", "Draw", true, "submit()", wren_dc_submit },
 	{ "engine", "Draw", true, "clear(_,_,_,_)", wren_dc_clear },
 
+	{ "engine", "DrawBuffer", false, "setColor(_,_,_,_)", wren_dbuf_setcolor },
+	{ "engine", "DrawBuffer", false, "resetTransform()", wren_dbuf_reset_transform },
+	{ "engine", "DrawBuffer", false, "translate(_,_)", wren_dbuf_translate },
+	{ "engine", "DrawBuffer", false, "rect(_,_,_,_,_)", wren_dbuf_rect },
+	{ "engine", "DrawBuffer", false, "image(_,_,_,_,_,_,_,_,_)", wren_dbuf_image },
+	{ "engine", "DrawBuffer", false, "line(_,_,_,_)", wren_dbuf_line },
+	{ "engine", "DrawBuffer", false, "circle(_,_,_,_)", wren_dbuf_circle },
+	{ "engine", "DrawBuffer", false, "tri(_,_,_,_,_,_,_)", wren_dbuf_tri },
+	{ "engine", "DrawBuffer", false, "sprite(_,_,_,_,_,_,_,_)", wren_dbuf_sprite },
+	{ "engine", "DrawBuffer", false, "rects(_,_)", wren_dbuf_rects },
+	{ "engine", "DrawBuffer", false, "sprites(_,_)", wren_dbuf_sprites },
+	{ "engine", "DrawBuffer", false, "colorRects(_,_)", wren_dbuf_colorrects },
+	{ "engine", "DrawBuffer", false, "flush()", wren_dbuf_flush },
+	{ "engine", "DrawBuffer", false, "clear()", wren_dbuf_clear },
+	{ "engine", "DrawBuffer", false, "count", wren_dbuf_count },
+
+	{ "engine", "Float32Array", false, "copyList_(_)", wren_arr_copylist },
+	{ "engine", "Float32Array", false, "count", wren_arr_count },
+	{ "engine", "Float32Array", false, "[_]", wren_arr_get },
+	{ "engine", "Float32Array", false, "[_]=(_)", wren_arr_set },
+	{ "engine", "Float32Array", false, "fill(_)", wren_arr_fill },
+	{ "engine", "Float32Array", false, "fill(_,_,_)", wren_arr_fill_range },
+	{ "engine", "Float32Array", false, "copy(_,_,_,_)", wren_arr_copy },
+	{ "engine", "Float32Array", false, "slice(_,_)", wren_arr_slice },
+	{ "engine", "Float32Array", false, "toList", wren_arr_tolist },
+
+	{ "engine", "Int32Array", false, "copyList_(_)", wren_arr_copylist },
+	{ "engine", "Int32Array", false, "count", wren_arr_count },
+	{ "engine", "Int32Array", false, "[_]", wren_arr_get },
+	{ "engine", "Int32Array", false, "[_]=(_)", wren_arr_set },
+	{ "engine", "Int32Array", false, "fill(_)", wren_arr_fill },
+	{ "engine", "Int32Array", false, "fill(_,_,_)", wren_arr_fill_range },
+	{ "engine", "Int32Array", false, "copy(_,_,_,_)", wren_arr_copy },
+	{ "engine", "Int32Array", false, "slice(_,_)", wren_arr_slice },
+	{ "engine", "Int32Array", false, "toList", wren_arr_tolist },
+
+	{ "engine", "ByteArray", false, "copyList_(_)", wren_arr_copylist },
+	{ "engine", "ByteArray", false, "count", wren_arr_count },
+	{ "engine", "ByteArray", false, "[_]", wren_arr_get },
+	{ "engine", "ByteArray", false, "[_]=(_)", wren_arr_set },
+	{ "engine", "ByteArray", false, "fill(_)", wren_arr_fill },
+	{ "engine", "ByteArray", false, "fill(_,_,_)", wren_arr_fill_range },
+	{ "engine", "ByteArray", false, "copy(_,_,_,_)", wren_arr_copy },
+	{ "engine", "ByteArray", false, "slice(_,_)", wren_arr_slice },
+	{ "engine", "ByteArray", false, "toList", wren_arr_tolist },
+
 	{ "engine", "TMX", true, "setCurrent(_)", wren_map_setcurrent },
 	{ "engine", "TMX", true, "layerByName(_)", wren_map_getlayerbyname },
 	{ "engine", "TMX", true, "layerNames()", wren_map_getlayernames },
@@ -1013,6 +1670,22 @@ static const wrenMethodDef methods[] = {
 	{ "engine", "TMX", true, "getLayerProperties(_)", wren_map_getlayerproperties },
 	{ "engine", "TMX", true, "getTileProperties()", wren_map_gettileproperties },
 	{ "engine", "TMX", true, "getTile(_,_,_)", wren_map_gettile },
+	{ "engine", "TMX", true, "getTiles(_,_,_,_,_)", wren_map_gettiles },
+	{ "engine", "TMX", true, "getTiles(_,_,_,_,_,_)", wren_map_gettiles_out },
+
+	{ "engine", "TileCollider", false, "query(_,_,_,_,_,_,_)", wren_tilecol_query },
+	{ "engine", "TileCollider", false, "setFlags(_,_,_)", wren_tilecol_setflags },
+	{ "engine", "TileCollider", false, "setBorder(_,_)", wren_tilecol_setborder },
+	{ "engine", "TileCollider", false, "side", wren_tilecol_side },
+	{ "engine", "TileCollider", false, "tile", wren_tilecol_tile },
+	{ "engine", "TileCollider", false, "tileX", wren_tilecol_tilex },
+	{ "engine", "TileCollider", false, "tileY", wren_tilecol_tiley },
+
+	{ "engine", "SpatialHash", false, "insert(_,_,_,_,_)", wren_shash_insert },
+	{ "engine", "SpatialHash", false, "move(_,_,_,_,_)", wren_shash_insert },
+	{ "engine", "SpatialHash", false, "remove(_)", wren_shash_remove },
+	{ "engine", "SpatialHash", false, "query(_,_,_,_,_)", wren_shash_query },
+	{ "engine", "SpatialHash", false, "count", wren_shash_count },
 };
 static const int methodsCount = sizeof(methods) / sizeof(wrenMethodDef);
 
@@ -1061,6 +1734,51 @@ void cvarFinalize(void *data) {
 
 }
 
+// new(layer) builds the grid from a tile layer of the current TMX
+void tileColliderAllocate(WrenVM *vm) {
+	tileCollider_t *tc = (tileCollider_t*)wrenSetSlotNewForeign(vm, 0, 0, sizeof(tileCollider_t));
+	int layer = wrenGetSlotType(vm, 1) == WREN_TYPE_NUM ? (int)wrenGetSlotDouble(vm, 1) : -1;
+
+	if (!TileCol_Init(tc, SLT_Get_TMX(mapId), layer)) {
+		SLT_Print("TileCollider: layer %i isn't a tile layer\n", layer);
+		wrenDebugPrintStackTrace(vm);
+	}
+}
+
+void tileColliderFinalize(void *data) {
+	TileCol_Free((tileCollider_t*)data);
+}
+
+// new(cellSize), cellSize should be a bit bigger than most of the boxes going in
+void spatialHashAllocate(WrenVM *vm) {
+	spatialHash_t *hash = (spatialHash_t*)wrenSetSlotNewForeign(vm, 0, 0, sizeof(spatialHash_t));
+	SHash_Init(hash, wrenGetSlotType(vm, 1) == WREN_TYPE_NUM ? wrenGetSlotDouble(vm, 1) : 0);
+}
+
+void spatialHashFinalize(void *data) {
+	SHash_Free((spatialHash_t*)data);
+}
+
+void drawBufferAllocate(WrenVM *vm) {
+	drawBuffer_t *buf = (drawBuffer_t*)wrenSetSlotNewForeign(vm, 0, 0, sizeof(drawBuffer_t));
+	memset(buf, 0, sizeof(drawBuffer_t));
+
+	// capacity is a command count hint, the buffer still grows past it
+	int capacity = wrenGetSlotCount(vm) > 1 && wrenGetSlotType(vm, 1) == WREN_TYPE_NUM ? (int)wrenGetSlotDouble(vm, 1) : 0;
+	if (capacity > 0) {
+		buf->opCapacity = capacity;
+		buf->ops = (uint8_t*)malloc(capacity);
+		buf->argCapacity = capacity * 5;
+		buf->args = (float*)malloc(buf->argCapacity * sizeof(float));
+	}
+}
+
+void drawBufferFinalize(void *data) {
+	drawBuffer_t *buf = (drawBuffer_t*)data;
+	free(buf->ops);
+	free(buf->args);
+}
+
 WrenForeignClassMethods wren_bindForeignClassFn(WrenVM* vm, const char* module, const char* className) {
 	NOTUSED(vm);
 	NOTUSED(module);
@@ -1071,6 +1789,30 @@ WrenForeignClassMethods wren_bindForeignClassFn(WrenVM* vm, const char* module,
 		fnMethods.allocate = cvarAllocate;
 		fnMethods.finalize = cvarFinalize;
 	}
+	else if (strcmp(className, "TileCollider") == 0) {
+		fnMethods.allocate = tileColliderAllocate;
+		fnMethods.finalize = tileColliderFinalize;
+	}
+	else if (strcmp(className, "SpatialHash") == 0) {
+		fnMethods.allocate = spatialHashAllocate;
+		fnMethods.finalize = spatialHashFinalize;
+	}
+	else if (strcmp(className, "DrawBuffer") == 0) {
+		fnMethods.allocate = drawBufferAllocate;
+		fnMethods.finalize = drawBufferFinalize;
+	}
+	else if (strcmp(className, "Float32Array") == 0) {
+		fnMethods.allocate = WrenArr_AllocateFloat32;
+		fnMethods.finalize = NULL;
+	}
+	else if (strcmp(className, "Int32Array") == 0) {
+		fnMethods.allocate = WrenArr_AllocateInt32;
+		fnMethods.finalize = NULL;
+	}
+	else if (strcmp(className, "ByteArray") == 0) {
+		fnMethods.allocate = WrenArr_AllocateByte;
+		fnMethods.finalize = NULL;
+	}
 	else {
 		fnMethods.allocate = NULL;
 		fnMethods.finalize = NULL;
@@ -1085,6 +1827,8 @@ WrenForeignClassMethods wren_bindForeignClassFn(WrenVM* vm, const char* module,
 WrenVM *Wren_Init(const char *mainScriptName, const char *constructorStr) {
 	WrenConfiguration config;
 	wrenInitConfiguration(&config);
+	config.reallocateFn = wren_reallocate;
+	config.gcFn = wren_gc;
 	config.errorFn = wren_error;
 	config.bindForeignMethodFn = wren_bindForeignMethodFn;
 	config.loadModuleFn = wren_loadModuleFn;
@@ -1123,7 +1867,7 @@ WrenVM *Wren_Init(const char *mainScriptName, const char *constructorStr) {
 	wrenHandles_t *hnd = new wrenHandles_t();
 	hnd->instanceHnd = gameClass;
 	hnd->updateHnd = wrenMakeCallHandle(vm, "update(_)");
-	hnd->drawHnd = wrenMakeCallHandle(vm, "draw(_,_)");
+	hnd->drawHnd = wrenMakeCallHandle(vm, "draw(_,_,_)");
 	hnd->shutdownHnd = wrenMakeCallHandle(vm, "shutdown()");
 	hnd->consoleHnd = wrenMakeCallHandle(vm, "console(_)");
 
@@ -1134,7 +1878,7 @@ WrenVM *Wren_Init(const char *mainScriptName, const char *constructorStr) {
 	}
 
 	if (hnd->drawHnd == nullptr) {
-		SLT_Error(ERR_GAME, "%s: couldn't find static draw(_,_) on Main", __func__);
+		SLT_Error(ERR_GAME, "%s: couldn't find static draw(_,_,_) on Main", __func__);
 		Wren_FreeVM(vm);
 		return nullptr;
 	}
@@ -1172,12 +1916,13 @@ bool Wren_Update(WrenVM *vm, double dt) {
 	return wrenGetSlotType(vm, 0) == WREN_TYPE_BOOL ? wrenGetSlotBool(vm, 0) : true;
 }
 
-void Wren_Draw(WrenVM *vm, int w, int h) {
+void Wren_Draw(WrenVM *vm, int w, int h, double alpha) {
 	wrenHandles_t* hnd = (wrenHandles_t*)wrenGetUserData(vm);
-	wrenEnsureSlots(vm, 3);
+	wrenEnsureSlots(vm, 4);
 	wrenSetSlotHandle(vm, 0, hnd->instanceHnd);
 	wrenSetSlotDouble(vm, 1, w);
 	wrenSetSlotDouble(vm, 2, h);
+	wrenSetSlotDouble(vm, 3, alpha);
 	wrenCall(vm, hnd->drawHnd);
 }
 
@@ -1189,6 +1934,15 @@ void Wren_Console(WrenVM *vm, const char *str) {
 	wrenCall(vm, hnd->consoleHnd);
 }
 
+void Wren_ReportStats() {
+	SLT_Bench_AddStat("wren allocs", (double)allocCount);
+	SLT_Bench_AddStat("wren gcs", (double)gcCount);
+	SLT_Bench_AddStat("draw buffer cmds", (double)drawBufferCmds);
+	allocCount = 0;
+	gcCount = 0;
+	drawBufferCmds = 0;
+}
+
 void Wren_Eval(WrenVM *vm, const char *code) {
 	wrenInterpret(vm, code);
 }
@@ -1203,6 +1957,13 @@ void Wren_Scene_Shutdown(WrenVM *vm) {
 void Wren_FreeVM(WrenVM *vm) {
 	wrenHandles_t* hnd = (wrenHandles_t*)wrenGetUserData(vm);
 
+	// reads still in flight would call back into the freed vm
+	for (size_t i = asyncReads.size(); i > 0; i--) {
+		if (asyncReads[i - 1]->vm == vm) {
+			wren_trap_cancel_read_at(i - 1);
+		}
+	}
+
 	if (hnd->drawHnd) wrenReleaseHandle(vm, hnd->drawHnd);
 	if (hnd->updateHnd)	wrenReleaseHandle(vm, hnd->updateHnd);
 	if (hnd->shutdownHnd) wrenReleaseHandle(vm, hnd->shutdownHnd);
@@ -2,7 +2,9 @@
 
 struct WrenVM *Wren_Init(const char *mainScriptName, const char *constructorStr);
 bool Wren_Update(WrenVM *vm, double dt);
-void Wren_Draw(struct WrenVM *vm, int w, int h);
+void Wren_Draw(struct WrenVM *vm, int w, int h, double alpha);
+// sends allocation and gc counts since the last call to the benchmark stats
+void Wren_ReportStats();
 void Wren_Eval(WrenVM *vm, const char *code);
 void Wren_Console(WrenVM *vm, const char *str);
 void Wren_Scene_Shutdown(WrenVM *vm);
@@ -0,0 +1,300 @@
+#include "wrenarray.h"
+#include "wren/wren.hpp"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <math.h>
+
+#define WARR_MAGIC 0x52524157 // "WARR"
+
+static const char *arrayClassNames[WARR_TYPE_COUNT] = { "Float32Array", "Int32Array", "ByteArray" };
+static const size_t arrayElemSizes[WARR_TYPE_COUNT] = { sizeof(float), sizeof(int32_t), sizeof(uint8_t) };
+
+static void WrenArr_Abort(WrenVM *vm, const char *msg) {
+	wrenSetSlotString(vm, 0, msg);
+	wrenAbortFiber(vm, 0);
+}
+
+static double WrenArr_At(const wrenArray_t *arr, int i) {
+	switch (arr->type) {
+	case WARR_FLOAT32: return WrenArr_Data(arr, const float)[i];
+	case WARR_INT32: return WrenArr_Data(arr, const int32_t)[i];
+	default: return WrenArr_Data(arr, const uint8_t)[i];
+	}
+}
+
+// numbers are truncated for the integer types, bytes wrap around
+static void WrenArr_SetAt(wrenArray_t *arr, int i, double value) {
+	switch (arr->type) {
+	case WARR_FLOAT32: WrenArr_Data(arr, float)[i] = (float)value; break;
+	case WARR_INT32: WrenArr_Data(arr, int32_t)[i] = (int32_t)value; break;
+	default: WrenArr_Data(arr, uint8_t)[i] = (uint8_t)(int32_t)value; break;
+	}
+}
+
+static bool WrenArr_CheckRange(WrenVM *vm, const wrenArray_t *arr, int start, int count) {
+	if (start < 0 || count < 0 || (int64_t)start + count > arr->count) {
+		char msg[128];
+		snprintf(msg, sizeof(msg), "range %i..%lld is out of bounds for %s of %i", start, (long long)start + count, arrayClassNames[arr->type], arr->count);
+		WrenArr_Abort(vm, msg);
+		return false;
+	}
+
+	return true;
+}
+
+static bool WrenArr_Number(WrenVM *vm, int slot, double *out) {
+	if (wrenGetSlotType(vm, slot) != WREN_TYPE_NUM) {
+		char msg[64];
+		snprintf(msg, sizeof(msg), "expected a number in parameter %i", slot);
+		WrenArr_Abort(vm, msg);
+		return false;
+	}
+
+	*out = wrenGetSlotDouble(vm, slot);
+	return true;
+}
+
+// truncates like the other integer arguments, anything that doesn't fit in an int is an error
+// rather than undefined behavior in the cast
+static bool WrenArr_Int(WrenVM *vm, int slot, int *out) {
+	double value;
+	if (!WrenArr_Number(vm, slot, &value)) {
+		return false;
+	}
+
+	if (!(value > INT32_MIN - 1.0 && value < INT32_MAX + 1.0)) {
+		char msg[64];
+		snprintf(msg, sizeof(msg), "parameter %i is out of range", slot);
+		WrenArr_Abort(vm, msg);
+		return false;
+	}
+
+	*out = (int)value;
+	return true;
+}
+
+static wrenArray_t* WrenArr_Init(void *data, wrenArrayType_t type, int count) {
+	wrenArray_t *arr = (wrenArray_t*)data;
+	arr->magic = WARR_MAGIC;
+	arr->type = type;
+	arr->count = count;
+	arr->pad = 0;
+	memset(arr + 1, 0, arrayElemSizes[type] * count);
+	return arr;
+}
+
+wrenArray_t* WrenArr_Get(WrenVM *vm, int slot, wrenArrayType_t type) {
+	wrenArray_t *arr = wrenGetSlotType(vm, slot) == WREN_TYPE_FOREIGN ? (wrenArray_t*)wrenGetSlotForeign(vm, slot) : nullptr;
+
+	if (arr == nullptr || arr->magic != WARR_MAGIC || (type != WARR_TYPE_COUNT && arr->type != type)) {
+		char msg[128];
+		snprintf(msg, sizeof(msg), "expected %s in parameter %i", type == WARR_TYPE_COUNT ? "a typed array" : arrayClassNames[type], slot);
+		WrenArr_Abort(vm, msg);
+		return nullptr;
+	}
+
+	return arr;
+}
+
+wrenArray_t* WrenArr_New(WrenVM *vm, int slot, wrenArrayType_t type, int count) {
+	wrenEnsureSlots(vm, slot + 2);
+	wrenGetVariable(vm, "engine", arrayClassNames[type], slot + 1);
+	void *data = wrenSetSlotNewForeign(vm, slot, slot + 1, sizeof(wrenArray_t) + arrayElemSizes[type] * count);
+	return WrenArr_Init(data, type, count);
+}
+
+// new(count) makes a zero filled array. new(list) sizes it to the list here and the
+// constructor copies the values in with copyList_, allocators can't use any slots past
+// their arguments.
+static void WrenArr_Allocate(WrenVM *vm, wrenArrayType_t type) {
+	// the size in bytes has to fit in an int, and NaN fails every comparison
+	int maxCount = (int)(INT_MAX / arrayElemSizes[type]);
+	WrenType argType = wrenGetSlotType(vm, 1);
+	double size = argType == WREN_TYPE_LIST ? wrenGetListCount(vm, 1) : (argType == WREN_TYPE_NUM ? wrenGetSlotDouble(vm, 1) : -1);
+	bool valid = size >= 0 && size <= maxCount && size == floor(size);
+	int count = valid ? (int)size : 0;
+
+	void *data = wrenSetSlotNewForeign(vm, 0, 0, sizeof(wrenArray_t) + arrayElemSizes[type] * count);
+	WrenArr_Init(data, type, count);
+
+	if (!valid) {
+		// the error goes in slot 1 so the new array stays in slot 0
+		char msg[128];
+		snprintf(msg, sizeof(msg), "array size must be a whole number from 0 to %i, or a list", maxCount);
+		wrenSetSlotString(vm, 1, msg);
+		wrenAbortFiber(vm, 1);
+	}
+}
+
+void WrenArr_AllocateFloat32(WrenVM *vm) { WrenArr_Allocate(vm, WARR_FLOAT32); }
+void WrenArr_AllocateInt32(WrenVM *vm) { WrenArr_Allocate(vm, WARR_INT32); }
+void WrenArr_AllocateByte(WrenVM *vm) { WrenArr_Allocate(vm, WARR_BYTE); }
+
+void wren_arr_copylist(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	int count = wrenGetListCount(vm, 1);
+	count = count < arr->count ? count : arr->count;
+
+	wrenEnsureSlots(vm, 3);
+	for (int i = 0; i < count; i++) {
+		wrenGetListElement(vm, 1, i, 2);
+		WrenArr_SetAt(arr, i, wrenGetSlotType(vm, 2) == WREN_TYPE_NUM ? wrenGetSlotDouble(vm, 2) : 0);
+	}
+}
+
+void wren_arr_count(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	wrenSetSlotDouble(vm, 0, arr->count);
+}
+
+static bool WrenArr_Index(WrenVM *vm, const wrenArray_t *arr, int *index) {
+	if (wrenGetSlotType(vm, 1) != WREN_TYPE_NUM) {
+		WrenArr_Abort(vm, "array index must be a number");
+		return false;
+	}
+
+	// negative indices count back from the end, same as List. checked before the cast, since
+	// converting a double that doesn't fit in an int is undefined
+	double d = wrenGetSlotDouble(vm, 1);
+	if (!(d > -arr->count - 1.0 && d < arr->count)) {
+		WrenArr_Abort(vm, "array index out of bounds");
+		return false;
+	}
+
+	int i = (int)d;
+	i = i < 0 ? arr->count + i : i;
+	if (i < 0 || i >= arr->count) {
+		WrenArr_Abort(vm, "array index out of bounds");
+		return false;
+	}
+
+	*index = i;
+	return true;
+}
+
+void wren_arr_get(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	int i;
+	if (WrenArr_Index(vm, arr, &i)) {
+		wrenSetSlotDouble(vm, 0, WrenArr_At(arr, i));
+	}
+}
+
+void wren_arr_set(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	int i;
+	if (wrenGetSlotType(vm, 2) != WREN_TYPE_NUM) {
+		WrenArr_Abort(vm, "array value must be a number");
+		return;
+	}
+
+	if (WrenArr_Index(vm, arr, &i)) {
+		double value = wrenGetSlotDouble(vm, 2);
+		WrenArr_SetAt(arr, i, value);
+		wrenSetSlotDouble(vm, 0, value);
+	}
+}
+
+static void WrenArr_Fill(wrenArray_t *arr, int start, int count, double value) {
+	switch (arr->type) {
+	case WARR_FLOAT32: {
+		float *f = WrenArr_Data(arr, float) + start;
+		for (int i = 0; i < count; i++) {
+			f[i] = (float)value;
+		}
+		break;
+	}
+	case WARR_INT32: {
+		int32_t *n = WrenArr_Data(arr, int32_t) + start;
+		for (int i = 0; i < count; i++) {
+			n[i] = (int32_t)value;
+		}
+		break;
+	}
+	default:
+		memset(WrenArr_Data(arr, uint8_t) + start, (uint8_t)(int32_t)value, count);
+		break;
+	}
+}
+
+void wren_arr_fill(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	double value;
+	if (WrenArr_Number(vm, 1, &value)) {
+		WrenArr_Fill(arr, 0, arr->count, value);
+	}
+}
+
+void wren_arr_fill_range(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	double value;
+	int start, count;
+
+	if (WrenArr_Number(vm, 1, &value) && WrenArr_Int(vm, 2, &start) && WrenArr_Int(vm, 3, &count) && WrenArr_CheckRange(vm, arr, start, count)) {
+		WrenArr_Fill(arr, start, count, value);
+	}
+}
+
+// copy(src, srcStart, dstStart, count). arrays of the same type are a straight memmove, otherwise
+// each element is converted.
+void wren_arr_copy(WrenVM *vm) {
+	wrenArray_t *dst = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	wrenArray_t *src = WrenArr_Get(vm, 1, WARR_TYPE_COUNT);
+	if (src == nullptr) {
+		return;
+	}
+
+	int srcStart, dstStart, count;
+	if (!WrenArr_Int(vm, 2, &srcStart) || !WrenArr_Int(vm, 3, &dstStart) || !WrenArr_Int(vm, 4, &count)) {
+		return;
+	}
+
+	if (!WrenArr_CheckRange(vm, src, srcStart, count) || !WrenArr_CheckRange(vm, dst, dstStart, count)) {
+		return;
+	}
+
+	if (src->type == dst->type) {
+		size_t sz = arrayElemSizes[dst->type];
+		memmove((uint8_t*)(dst + 1) + dstStart * sz, (uint8_t*)(src + 1) + srcStart * sz, count * sz);
+	}
+	else {
+		for (int i = 0; i < count; i++) {
+			WrenArr_SetAt(dst, dstStart + i, WrenArr_At(src, srcStart + i));
+		}
+	}
+}
+
+// slice(start, count) returns a new array of the same type holding a copy of the range
+void wren_arr_slice(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	int start, count;
+
+	if (!WrenArr_Int(vm, 1, &start) || !WrenArr_Int(vm, 2, &count) || !WrenArr_CheckRange(vm, arr, start, count)) {
+		return;
+	}
+
+	// the source stays in slot 0 until the new array is allocated over it, and nothing can
+	// collect it between that and the copy
+	wrenArray_t *slice = WrenArr_New(vm, 0, (wrenArrayType_t)arr->type, count);
+	size_t sz = arrayElemSizes[arr->type];
+	memcpy(slice + 1, (uint8_t*)(arr + 1) + start * sz, count * sz);
+}
+
+void wren_arr_tolist(WrenVM *vm) {
+	wrenArray_t *arr = (wrenArray_t*)wrenGetSlotForeign(vm, 0);
+	int count = arr->count;
+
+	// keep the array alive while the list growing can trigger a collection
+	WrenHandle *hnd = wrenGetSlotHandle(vm, 0);
+
+	wrenEnsureSlots(vm, 2);
+	wrenSetSlotNewList(vm, 0);
+	for (int i = 0; i < count; i++) {
+		wrenSetSlotDouble(vm, 1, WrenArr_At(arr, i));
+		wrenInsertInList(vm, 0, -1, 1);
+	}
+
+	wrenReleaseHandle(vm, hnd);
+}
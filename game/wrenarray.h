@@ -0,0 +1,48 @@
+#pragma once
+
+// wrenarray.h - fixed size typed arrays for wren (Float32Array, Int32Array, ByteArray). elements
+// are stored unboxed right after the header in the foreign object, so engine functions can read
+// and write them directly instead of going through a slot per element.
+
+#include <stdint.h>
+
+struct WrenVM;
+
+typedef enum {
+	WARR_FLOAT32,
+	WARR_INT32,
+	WARR_BYTE,
+	WARR_TYPE_COUNT
+} wrenArrayType_t;
+
+typedef struct {
+	uint32_t magic; // tells typed arrays apart from other foreign objects
+	int32_t type;
+	int32_t count;
+	int32_t pad;
+} wrenArray_t;
+
+#define WrenArr_Data(arr, T) ((T*)((arr) + 1))
+
+// returns the typed array in slot, or aborts the fiber and returns nullptr if the slot isn't a typed array
+// of the given type. pass WARR_TYPE_COUNT to accept any type.
+wrenArray_t* WrenArr_Get(WrenVM *vm, int slot, wrenArrayType_t type);
+
+// creates a zero filled array in slot. uses slot + 1 to hold the class while allocating.
+wrenArray_t* WrenArr_New(WrenVM *vm, int slot, wrenArrayType_t type, int count);
+
+// foreign class allocators, see wren_bindForeignClassFn
+void WrenArr_AllocateFloat32(WrenVM *vm);
+void WrenArr_AllocateInt32(WrenVM *vm);
+void WrenArr_AllocateByte(WrenVM *vm);
+
+// methods shared by all three classes, the element type comes from the header
+void wren_arr_copylist(WrenVM *vm);
+void wren_arr_count(WrenVM *vm);
+void wren_arr_get(WrenVM *vm);
+void wren_arr_set(WrenVM *vm);
+void wren_arr_fill(WrenVM *vm);
+void wren_arr_fill_range(WrenVM *vm);
+void wren_arr_copy(WrenVM *vm);
+void wren_arr_slice(WrenVM *vm);
+void wren_arr_tolist(WrenVM *vm);
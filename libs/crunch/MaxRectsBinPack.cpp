@@ -117,6 +117,25 @@ void MaxRectsBinPack::Insert(std::vector<RectSize> &rects, std::vector<Rect> &ds
 	}
 }
 
+void MaxRectsBinPack::Restore(const std::vector<Rect> &used, const std::vector<Rect> &free)
+{
+	usedRectangles = used;
+	freeRectangles = free;
+}
+
+void MaxRectsBinPack::FreeRect(const Rect &node)
+{
+	for(size_t i = 0; i < usedRectangles.size(); ++i)
+		if (usedRectangles[i].x == node.x && usedRectangles[i].y == node.y && usedRectangles[i].width == node.width && usedRectangles[i].height == node.height)
+		{
+			usedRectangles.erase(usedRectangles.begin() + i);
+			break;
+		}
+
+	freeRectangles.push_back(node);
+	PruneFreeList();
+}
+
 void MaxRectsBinPack::PlaceRect(const Rect &node)
 {
 	size_t numRectanglesToProcess = freeRectangles.size();
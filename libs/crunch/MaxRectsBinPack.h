@@ -50,6 +50,15 @@ public:
 	/// Computes the ratio of used surface area to the total bin area.
 	float Occupancy() const;
 
+	/// Returns the free rectangles. Saving these along with the used ones is enough to Restore the bin later.
+	const std::vector<Rect> &FreeRectangles() const { return freeRectangles; }
+
+	/// Restores the bin to a previous state, with the rectangles that were placed and what FreeRectangles returned.
+	void Restore(const std::vector<Rect> &used, const std::vector<Rect> &free);
+
+	/// Makes a placed rectangle free space again.
+	void FreeRect(const Rect &node);
+
 private:
 	int binWidth;
 	int binHeight;
@@ -26,100 +26,155 @@
 
 #include "bitmap.hpp"
 #include <iostream>
-#define LODEPNG_NO_COMPILE_CPP
+//No LODEPNG_NO_COMPILE_CPP here, it changes LodePNGState from how lodepng.cpp sees it
 #include "lodepng.h"
 #include <algorithm>
+#include <string.h>
 #include "hash.hpp"
 #include "console.h"
-#include "files.h"
+#include "rawimage.h"
+#include <fstream>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITMAP_SSE2
+#endif
 
 using namespace std;
 
-Bitmap::Bitmap(const string& file, const string& name, bool premultiply, bool trim)
-: name(name)
+//Premultiplies the pixels by their alpha. The SSE2 path does the same float math as the scalar one,
+//so the atlas comes out identical either way
+static void Premultiply(uint32_t* pixels, int count)
+{
+    int i = 0;
+#ifdef BITMAP_SSE2
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128 div = _mm_set1_ps(255.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        __m128i a = _mm_srli_epi32(c, 24);
+        __m128 m = _mm_div_ps(_mm_cvtepi32_ps(a), div);
+        __m128i r = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(c, mask)), m));
+        __m128i g = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 8), mask)), m));
+        __m128i b = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(c, 16), mask)), m));
+        c = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(b, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i), c);
+    }
+#endif
+    uint32_t c,a,r,g,b;
+    float m;
+    for (; i < count; ++i)
+    {
+        c = pixels[i];
+        a = c >> 24;
+        m = static_cast<float>(a) / 255.0f;
+        r = static_cast<uint32_t>((c & 0xff) * m);
+        g = static_cast<uint32_t>(((c >> 8) & 0xff) * m);
+        b = static_cast<uint32_t>(((c >> 16) & 0xff) * m);
+        pixels[i] = (a << 24) | (b << 16) | (g << 8) | r;
+    }
+}
+
+//Returns the index of the first pixel with any alpha, or count if there isn't one
+static int FirstAlpha(const uint32_t* p, int count)
+{
+    int i = 0;
+#ifdef BITMAP_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i a = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), 24);
+        int empty = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, zero)));
+        if (empty != 0xf)
+            break;
+    }
+#endif
+    for (; i < count; ++i)
+        if ((p[i] >> 24) > 0)
+            return i;
+    return count;
+}
+
+//Returns the index of the last pixel with any alpha, or -1 if there isn't one
+static int LastAlpha(const uint32_t* p, int count)
+{
+    int i = count;
+#ifdef BITMAP_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i - 4 >= 0; i -= 4)
+    {
+        __m128i a = _mm_srli_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i - 4)), 24);
+        int empty = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, zero)));
+        if (empty != 0xf)
+            break;
+    }
+#endif
+    for (--i; i >= 0; --i)
+        if ((p[i] >> 24) > 0)
+            return i;
+    return -1;
+}
+
+Bitmap::Bitmap(const string& name, const void* png, size_t size, bool premultiply, bool trim)
+: name(name), error(nullptr), transparent(false)
 {
     //Load the png file
     unsigned char* pdata;
     unsigned int pw, ph;
 
-	unsigned char *buf;
-	auto sz = FS_ReadFile(file.c_str(), (void **)&buf);
-
-	if (sz <= 0) {
-		Con_Printf("failed to read png: %s\n", file.c_str());
-		exit(EXIT_FAILURE);
-	}
-
-    if (lodepng_decode_memory(&pdata, &pw, &ph, buf, sz, LCT_RGBA, 8))
+    unsigned err = lodepng_decode_memory(&pdata, &pw, &ph, reinterpret_cast<const unsigned char*>(png), size, LCT_RGBA, 8);
+    if (err)
     {
-		Con_Printf("failed to load png: %s\n", file.c_str());
-        exit(EXIT_FAILURE);
+        error = lodepng_error_text(err);
+        width = height = frameX = frameY = frameW = frameH = 0;
+        data = nullptr;
+        hashValue = 0;
+        return;
     }
 
-	free(buf);
-
     int w = static_cast<int>(pw);
     int h = static_cast<int>(ph);
     uint32_t* pixels = reinterpret_cast<uint32_t*>(pdata);
     
     //Premultiply all the pixels by their alpha
     if (premultiply)
-    {
-        int count = w * h;
-        uint32_t c,a,r,g,b;
-        float m;
-        for (int i = 0; i < count; ++i)
-        {
-			c = pixels[i];
-			a = c >> 24;
-			m = static_cast<float>(a) / 255.0f;
-			r = static_cast<uint32_t>((c & 0xff) * m);
-			g = static_cast<uint32_t>(((c >> 8) & 0xff) * m);
-			b = static_cast<uint32_t>(((c >> 16) & 0xff) * m);
-			pixels[i] = (a << 24) | (b << 16) | (g << 8) | r;
-        }
-    }
-    
-    //TODO: skip if all corners contain opaque pixels?
+        Premultiply(pixels, w * h);
     
-    //Get pixel bounds
-    int minX = w - 1;
-    int minY = h - 1;
-    int maxX = 0;
-    int maxY = 0;
+    //Get pixel bounds. Rows are skipped whole from the top and bottom, then each remaining
+    //row only needs checking outside of the columns already known to have alpha
+    int minX = 0;
+    int minY = 0;
+    int maxX = w - 1;
+    int maxY = h - 1;
     if (trim)
     {
-        uint32_t p;
-        for (int y = 0; y < h; ++y)
+        while (minY < h && FirstAlpha(pixels + minY * w, w) == w)
+            ++minY;
+
+        if (minY == h)
         {
-            for (int x = 0; x < w; ++x)
-            {
-                p = pixels[y * w + x];
-                if ((p >> 24) > 0)
-                {
-                    minX = min(x, minX);
-                    minY = min(y, minY);
-                    maxX = max(x, maxX);
-                    maxY = max(y, maxY);
-                }
-            }
+            minY = 0;
+            transparent = true;
         }
-        if (maxX < minX || maxY < minY)
+        else
         {
-            minX = 0;
-            minY = 0;
-            maxX = w - 1;
-            maxY = h - 1;
-			Con_Printf("image is completely transparent: %s\n", file.c_str());
+            while (LastAlpha(pixels + maxY * w, w) < 0)
+                --maxY;
+
+            minX = w;
+            maxX = -1;
+            for (int y = minY; y <= maxY; ++y)
+            {
+                const uint32_t* row = pixels + y * w;
+                minX = FirstAlpha(row, minX);
+                int last = LastAlpha(row + maxX + 1, w - maxX - 1);
+                if (last >= 0)
+                    maxX += last + 1;
+            }
         }
     }
-    else
-    {
-        minX = 0;
-        minY = 0;
-        maxX = w - 1;
-        maxY = h - 1;
-    }
     
     //Calculate our trimmed size
     width = (maxX - minX) + 1;
@@ -137,14 +192,13 @@ Bitmap::Bitmap(const string& file, const string& name, bool premultiply, bool tr
     else
     {
         //Create the trimmed image data
-        data = reinterpret_cast<uint32_t*>(calloc(width * height, sizeof(uint32_t)));
+        data = reinterpret_cast<uint32_t*>(malloc(width * height * sizeof(uint32_t)));
         frameX = -minX;
         frameY = -minY;
         
         //Copy trimmed pixels over to the trimmed pixel array
         for (int y = minY; y <= maxY; ++y)
-            for (int x = minX; x <= maxX; ++x)
-                data[(y - minY) * width + (x - minX)] = pixels[y * w + x];
+            memcpy(data + (y - minY) * width, pixels + y * w + minX, width * sizeof(uint32_t));
         
         //Free the untrimmed pixels
         free(pixels);
@@ -158,7 +212,7 @@ Bitmap::Bitmap(const string& file, const string& name, bool premultiply, bool tr
 }
 
 Bitmap::Bitmap(int width, int height)
-: width(width), height(height)
+: width(width), height(height), error(nullptr), transparent(false)
 {
     data = reinterpret_cast<uint32_t*>(calloc(width * height, sizeof(uint32_t)));
 }
@@ -168,18 +222,103 @@ Bitmap::~Bitmap()
     free(data);
 }
 
+//Encodes the pixels as a palette png if there are 256 colors or less. lodepng can pick a palette
+//itself, but it looks every pixel up in a color tree twice to do it, which is most of the time it
+//spends on a page of pixel art. Runs of the same color are common enough to skip the lookups for.
+static unsigned EncodePalette(unsigned char** png, size_t* size, const uint32_t* data, unsigned int width, unsigned int height, bool* encoded)
+{
+    *encoded = false;
+    unordered_map<uint32_t, uint8_t> index;
+    vector<uint32_t> colors;
+    size_t count = static_cast<size_t>(width) * height;
+    if (count == 0)
+        return 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i > 0 && data[i] == data[i - 1])
+            continue;
+        if (index.find(data[i]) != index.end())
+            continue;
+        if (colors.size() == 256)
+            return 0;
+        index[data[i]] = static_cast<uint8_t>(colors.size());
+        colors.push_back(data[i]);
+    }
+    
+    //Use the same bit depth lodepng would, rows of less than 8 bits aren't padded
+    unsigned int bits = colors.size() <= 2 ? 1 : colors.size() <= 4 ? 2 : colors.size() <= 16 ? 4 : 8;
+    size_t stride = (static_cast<size_t>(width) * bits + 7) / 8;
+    vector<unsigned char> indices(stride * height, 0);
+    uint8_t current = 0;
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        unsigned char* out = indices.data() + y * stride;
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            size_t i = static_cast<size_t>(y) * width + x;
+            if (i == 0 || data[i] != data[i - 1])
+                current = index[data[i]];
+            size_t bit = static_cast<size_t>(x) * bits;
+            out[bit >> 3] |= static_cast<unsigned char>(current << (8 - bits - (bit & 7)));
+        }
+    }
+    
+    //The raw pixels are already in the png's format, so lodepng doesn't convert them
+    LodePNGState state;
+    lodepng_state_init(&state);
+    state.encoder.auto_convert = 0;
+    unsigned error = 0;
+    for (LodePNGColorMode* mode : { &state.info_raw, &state.info_png.color })
+    {
+        mode->colortype = LCT_PALETTE;
+        mode->bitdepth = bits;
+        for (size_t i = 0; i < colors.size() && !error; ++i)
+        {
+            const unsigned char* rgba = reinterpret_cast<const unsigned char*>(&colors[i]);
+            error = lodepng_palette_add(mode, rgba[0], rgba[1], rgba[2], rgba[3]);
+        }
+    }
+    if (!error)
+        error = lodepng_encode(png, size, indices.data(), width, height, &state);
+    lodepng_state_cleanup(&state);
+    *encoded = true;
+    return error;
+}
+
 void Bitmap::SaveAs(const string& file)
 {
     unsigned char* pdata = reinterpret_cast<unsigned char*>(data);
     unsigned int pw = static_cast<unsigned int>(width);
     unsigned int ph = static_cast<unsigned int>(height);
-    if (lodepng_encode32_file(file.data(), pdata, pw, ph))
+    unsigned char* png = nullptr;
+    size_t size = 0;
+    bool encoded;
+    unsigned error = EncodePalette(&png, &size, data, pw, ph, &encoded);
+    if (!encoded)
+        error = lodepng_encode32(&png, &size, pdata, pw, ph);
+    if (!error)
+        error = lodepng_save_file(png, size, file.c_str());
+    free(png);
+    if (error)
     {
 		Con_Printf("failed to save png: %s\n", file.c_str());
         exit(EXIT_FAILURE);
     }
 }
 
+void Bitmap::SaveRaw(const string& file, bool lz4)
+{
+    size_t size;
+    uint8_t* buffer = RawImg_Encode(reinterpret_cast<uint8_t*>(data), width, height, lz4 ? RAWIMAGE_LZ4 : RAWIMAGE_NONE, &size);
+    ofstream stream(file, ios::binary);
+    if (buffer == nullptr || !stream.write(reinterpret_cast<char*>(buffer), size))
+    {
+        Con_Printf("failed to save raw image: %s\n", file.c_str());
+        exit(EXIT_FAILURE);
+    }
+    free(buffer);
+}
+
 void Bitmap::CopyPixels(const Bitmap* src, int tx, int ty)
 {
     for (int y = 0; y < src->height; ++y)
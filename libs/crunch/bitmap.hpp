@@ -36,6 +36,7 @@ using namespace std;
 struct Bitmap
 {
     string name;
+    string file;
     int width;
     int height;
     int frameX;
@@ -44,10 +45,15 @@ struct Bitmap
     int frameH;
     uint32_t* data;
     size_t hashValue;
-    Bitmap(const string& file, const string& name, bool premultiply, bool trim);
+    const char* error;
+    bool transparent;
+    //Decodes a png that's already in memory. Doesn't print or exit so it can run on any thread,
+    //error is set if the png couldn't be decoded, and transparent if trimming found nothing to keep
+    Bitmap(const string& name, const void* png, size_t size, bool premultiply, bool trim);
     Bitmap(int width, int height);
     ~Bitmap();
     void SaveAs(const string& file);
+    void SaveRaw(const string& file, bool lz4);
     void CopyPixels(const Bitmap* src, int tx, int ty);
     void CopyPixelsRot(const Bitmap* src, int tx, int ty);
     bool Equals(const Bitmap* other) const;
@@ -30,6 +30,7 @@
 #include <iostream>
 #include <sstream>
 #include <physfs.h>
+#include <string.h>
 #include "str.hpp"
 
 #include "console.h"
@@ -51,24 +52,50 @@ void HashString(size_t& hash, const string& str)
     HashCombine(hash, str);
 }
 
-void HashFile(size_t& hash, const string& file)
+//Collapses repeated slashes and drops the leading one, so the same file is always keyed the same way
+string NormalizePath(const string& path)
 {
+    string out;
+    for (char c : path)
+        if (c != '/' || (!out.empty() && out.back() != '/'))
+            out += c;
+    return out;
+}
 
-	char *contents;
-	int sz = FS_ReadFile(file.c_str(), (void**)&contents);
+void HashFile(size_t& hash, const string& file, const FileHashes& cache, FileHashes& hashes)
+{
+	string path = NormalizePath(file);
 
-	if (sz == -1) {
-		Con_Printf("failed to read file: %s", file.c_str());
+	PHYSFS_Stat stat;
+	if (PHYSFS_stat(path.c_str(), &stat) == 0) {
+		Con_Printf("failed to stat file: %s", path.c_str());
 		exit(EXIT_FAILURE);
 	}
 
-	string fileStr = string(contents, sz);
-	HashCombine(hash, fileStr);
+	FileHash entry;
+	entry.size = stat.filesize;
+	entry.modtime = stat.modtime;
 
-	free(contents);
+	auto cached = cache.find(path);
+	if (cached != cache.end() && cached->second.size == entry.size && cached->second.modtime == entry.modtime) {
+		entry.hash = cached->second.hash;
+	}
+	else {
+		fileMapping_t contents;
+		if (FS_MapFile(path.c_str(), &contents) < 0) {
+			Con_Printf("failed to read file: %s", path.c_str());
+			exit(EXIT_FAILURE);
+		}
+		entry.hash = HashBytes(contents.data, contents.size);
+		FS_UnmapFile(&contents);
+	}
+
+	hashes[path] = entry;
+	HashCombine(hash, path);
+	HashCombine(hash, static_cast<size_t>(entry.hash));
 }
 
-void HashFiles(size_t& hash, const string& root)
+void HashFiles(size_t& hash, const string& root, const FileHashes& cache, FileHashes& hashes)
 {   
 	char **list = FS_List(root.c_str());
 
@@ -83,10 +110,10 @@ void HashFiles(size_t& hash, const string& root)
 			continue;
 		}
 		if (stat.filetype == PHYSFS_FILETYPE_DIRECTORY) {
-			HashFiles(hash, fullPath.c_str());
+			HashFiles(hash, fullPath.c_str(), cache, hashes);
 		}
 		else if (stat.filetype == PHYSFS_FILETYPE_REGULAR) {
-			HashFile(hash, fullPath.c_str());
+			HashFile(hash, fullPath.c_str(), cache, hashes);
 		}
 	}
 
@@ -95,8 +122,106 @@ void HashFiles(size_t& hash, const string& root)
 
 void HashData(size_t& hash, const char* data, size_t size)
 {
-    string str(data, size);
-    HashCombine(hash, str);
+    HashCombine(hash, static_cast<size_t>(HashBytes(data, size)));
+}
+
+//xxHash64 with a seed of 0
+static const uint64_t XXH_PRIME1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t XXH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t XXH_PRIME3 = 0x165667B19E3779F9ULL;
+static const uint64_t XXH_PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t XXH_PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t XXH_Rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t XXH_Read64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t XXH_Read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t XXH_Round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME2;
+    acc = XXH_Rotl(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+static inline uint64_t XXH_MergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= XXH_Round(0, val);
+    return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+uint64_t HashBytes(const void* data, size_t size)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32)
+    {
+        uint64_t v1 = XXH_PRIME1 + XXH_PRIME2;
+        uint64_t v2 = XXH_PRIME2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - XXH_PRIME1;
+        do
+        {
+            v1 = XXH_Round(v1, XXH_Read64(p));
+            v2 = XXH_Round(v2, XXH_Read64(p + 8));
+            v3 = XXH_Round(v3, XXH_Read64(p + 16));
+            v4 = XXH_Round(v4, XXH_Read64(p + 24));
+            p += 32;
+        }
+        while (p + 32 <= end);
+
+        h = XXH_Rotl(v1, 1) + XXH_Rotl(v2, 7) + XXH_Rotl(v3, 12) + XXH_Rotl(v4, 18);
+        h = XXH_MergeRound(h, v1);
+        h = XXH_MergeRound(h, v2);
+        h = XXH_MergeRound(h, v3);
+        h = XXH_MergeRound(h, v4);
+    }
+    else
+    {
+        h = XXH_PRIME5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= XXH_Round(0, XXH_Read64(p));
+        h = XXH_Rotl(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= static_cast<uint64_t>(XXH_Read32(p)) * XXH_PRIME1;
+        h = XXH_Rotl(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        h ^= (*p) * XXH_PRIME5;
+        h = XXH_Rotl(h, 11) * XXH_PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME2;
+    h ^= h >> 29;
+    h *= XXH_PRIME3;
+    h ^= h >> 32;
+    return h;
 }
 
 bool LoadHash(size_t& hash, const string& file)
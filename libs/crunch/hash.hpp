@@ -28,15 +28,29 @@
 #define hash_hpp
 
 #include <string>
+#include <cstdint>
+#include <unordered_map>
 using namespace std;
 
+//Size, modification time and contents hash of an input file, from the manifest of the last run.
+//Files with the same size and modification time reuse the hash instead of being read again
+struct FileHash
+{
+    int64_t size;
+    int64_t modtime;
+    uint64_t hash;
+};
+typedef unordered_map<string, FileHash> FileHashes;
+
 template <class T>
 void HashCombine(std::size_t& hash, const T& v);
 void HashCombine(std::size_t& hash, size_t v);
 void HashString(size_t& hash, const string& str);
-void HashFile(size_t& hash, const string& file);
-void HashFiles(size_t& hash, const string& root);
+void HashFile(size_t& hash, const string& file, const FileHashes& cache, FileHashes& hashes);
+void HashFiles(size_t& hash, const string& root, const FileHashes& cache, FileHashes& hashes);
 void HashData(size_t& hash, const char* data, size_t size);
+uint64_t HashBytes(const void* data, size_t size);
+string NormalizePath(const string& path);
 bool LoadHash(size_t& hash, const string& file);
 void SaveHash(size_t hash, const string& file);
 
@@ -40,6 +40,9 @@
     -r  --rotate            enabled rotating bitmaps 90 degrees clockwise when packing
     -s# --size#             max atlas size (# can be 4096, 2048, 1024, 512, 256, 128, or 64)
     -p# --pad#              padding between images (# can be from 0 to 16)
+    -j# --jobs#             threads used to decode the bitmaps (# can be from 0 to 64, 0 uses every core)
+    -w  --warm              keep the last atlas layout, only packing bitmaps that changed into its free space
+    -i# --image#            atlas page format (# can be png, raw or lz4, raw and lz4 pages are saved as .rgba)
  
  binary format:
     [int16] num_textures (below block is repeated this many times)
@@ -64,15 +67,24 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <string.h>
 #include <physfs.h>
+#include <SDL/SDL.h>
 #include "bitmap.hpp"
 #include "packer.hpp"
 #include "binary.hpp"
 #include "hash.hpp"
 #include "str.hpp"
+#include "manifest.hpp"
+#define LODEPNG_NO_COMPILE_CPP
+#include "lodepng.h"
 
 #include "console.h"
 #include "files.h"
+#include "rawimage.h"
 
 using namespace std;
 
@@ -84,9 +96,24 @@ static bool optVerbose;
 static bool optForce;
 static bool optUnique;
 static bool optRotate;
+static int optJobs;
+static bool optWarm;
+static string optImage;
 static vector<Bitmap*> bitmaps;
 static vector<Packer*> packers;
 
+//A png found in the inputs. They're all read on the main thread first, then decoded by
+//DecodeBitmaps in any order, and added to bitmaps in the order they were found
+struct BitmapJob
+{
+    string path;
+    string name;
+    fileMapping_t file;
+    Bitmap* bitmap;
+};
+static vector<BitmapJob> jobs;
+static atomic<size_t> nextJob;
+
 static void SplitFileName(const string& path, string* dir, string* name, string* ext)
 {
     size_t si = path.rfind('/') + 1;
@@ -125,10 +152,6 @@ static string GetFileName(const string& path)
 
 static void LoadBitmap(const string& prefix, const string& path)
 {
-    if (optVerbose) {
-        Con_Printf("\t %s\n", path.c_str());
-    }
-    
 	string name, dir;
 	SplitFileName(path, &dir, &name, nullptr);
 
@@ -139,7 +162,78 @@ static void LoadBitmap(const string& prefix, const string& path)
 	std::replace(bitmapName.begin(), bitmapName.end(), '/', '_');
 	std::replace(bitmapName.begin(), bitmapName.end(), ' ', '_');
 
-    bitmaps.push_back(new Bitmap(prefix + "/" + path, bitmapName, optPremultiply, optTrim));
+    BitmapJob job;
+    job.path = NormalizePath(prefix + "/" + path);
+    job.name = bitmapName;
+    job.bitmap = nullptr;
+    jobs.push_back(job);
+}
+
+static int DecodeThread(void* ptr)
+{
+    (void)ptr;
+    for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+    {
+        BitmapJob& job = jobs[i];
+        job.bitmap = new Bitmap(job.name, job.file.data, job.file.size, optPremultiply, optTrim);
+    }
+    return 0;
+}
+
+//Decodes every queued png into bitmaps. Reading stays on this thread since the filesystem and
+//console aren't thread safe, the decode, premultiply and trim are spread over optJobs threads
+static void DecodeBitmaps()
+{
+    auto start = chrono::steady_clock::now();
+
+    for (auto& job : jobs)
+    {
+        if (optVerbose)
+            Con_Printf("\t %s\n", job.path.c_str());
+        if (FS_MapFile(job.path.c_str(), &job.file) <= 0)
+        {
+            Con_Printf("failed to read png: %s\n", job.path.c_str());
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int threadCount = optJobs > 0 ? optJobs : SDL_GetCPUCount();
+#if defined(__EMSCRIPTEN__)
+    threadCount = 1;
+#endif
+    if ((size_t)threadCount > jobs.size())
+        threadCount = max((int)jobs.size(), 1);
+
+    //The calling thread decodes too, so only threadCount - 1 are started
+    nextJob = 0;
+    vector<SDL_Thread*> threads;
+    for (int i = 1; i < threadCount; ++i)
+    {
+        SDL_Thread* thread = SDL_CreateThread(&DecodeThread, "crunch", nullptr);
+        if (thread != nullptr)
+            threads.push_back(thread);
+    }
+    DecodeThread(nullptr);
+    for (auto thread : threads)
+        SDL_WaitThread(thread, nullptr);
+
+    for (auto& job : jobs)
+    {
+        FS_UnmapFile(&job.file);
+        if (job.bitmap->error != nullptr)
+        {
+            Con_Printf("failed to load png: %s (%s)\n", job.path.c_str(), job.bitmap->error);
+            exit(EXIT_FAILURE);
+        }
+        if (job.bitmap->transparent)
+            Con_Printf("image is completely transparent: %s\n", job.path.c_str());
+        job.bitmap->file = job.path;
+        bitmaps.push_back(job.bitmap);
+    }
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    Con_Printf("decoded %i images in %.1f ms (%i threads)\n", (int)jobs.size(), ms, (int)threads.size() + 1);
+    jobs.clear();
 }
 
 static void LoadBitmaps(const string& root, const string& prefix)
@@ -208,10 +302,308 @@ static int GetPadding(const string& str)
     return 1;
 }
 
+static int GetJobs(const string& str)
+{
+    for (int i = 0; i <= 64; ++i)
+        if (str == to_string(i))
+            return i;
+    Con_Printf("invalid jobs value: %s\n", str.c_str());
+    exit(EXIT_FAILURE);
+    return 0;
+}
+
+static string GetImageFormat(const string& str)
+{
+    if (str == "png" || str == "raw" || str == "lz4")
+        return str;
+    Con_Printf("invalid image format: %s\n", str.c_str());
+    exit(EXIT_FAILURE);
+    return "png";
+}
+
+static string PageExtension()
+{
+    return optImage == "png" ? ".png" : ".rgba";
+}
+
+static void SortBitmaps()
+{
+    sort(bitmaps.begin(), bitmaps.end(), [](const Bitmap* a, const Bitmap* b) {
+        return (a->width * a->height) < (b->width * b->height);
+    });
+}
+
+//A page of the last atlas, only loaded if something on it is kept
+struct AtlasPage
+{
+    unsigned char* data;
+    unsigned int width;
+    unsigned int height;
+};
+
+//Loads a page of the last atlas, in the format it was saved in
+static bool LoadAtlasPage(AtlasPage& page, const string& file)
+{
+    if (optImage == "png")
+        return lodepng_decode32_file(&page.data, &page.width, &page.height, file.c_str()) == 0;
+    
+    ifstream stream(file, ios::binary | ios::ate);
+    if (!stream)
+        return false;
+    vector<char> buffer(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    stream.read(buffer.data(), buffer.size());
+    
+    rawImage_t raw;
+    if (!stream || !RawImg_Parse(buffer.data(), buffer.size(), &raw))
+        return false;
+    page.width = raw.width;
+    page.height = raw.height;
+    page.data = static_cast<unsigned char*>(malloc(page.width * page.height * 4));
+    return page.data != nullptr && RawImg_Decode(&raw, page.data);
+}
+
+//Updates the last atlas in place instead of packing from scratch. Bitmaps whose png hasn't changed
+//are cut back out of the old pages at the same spot, and the rest are decoded and packed into the
+//free space. Returns false if that can't be done, without having written anything, and leaves the
+//jobs queued for a full pack
+static bool WarmStart(const Manifest& old, const FileHashes& files, const string& atlas, vector<bool>& dirty)
+{
+    if (optRotate || old.pages <= 0 || old.pages > 16 || old.free.empty())
+        return false;
+
+    //Match the old sprites up with the pngs that are still there with the same contents
+    unordered_map<string, vector<size_t>> found;
+    for (size_t i = jobs.size(); i-- > 0; )
+        found[jobs[i].path].push_back(i);
+
+    vector<int> keptJob(old.sprites.size(), -1);
+    vector<bool> jobKept(jobs.size(), false);
+    int keptCount = 0;
+    for (size_t i = 0; i < old.sprites.size(); ++i)
+    {
+        const ManifestSprite& sprite = old.sprites[i];
+        auto job = found.find(sprite.file);
+        auto before = old.files.find(sprite.file);
+        auto now = files.find(sprite.file);
+        if (job == found.end() || job->second.empty() || before == old.files.end() || now == files.end() || before->second.hash != now->second.hash)
+            continue;
+        keptJob[i] = (int)job->second.back();
+        jobKept[keptJob[i]] = true;
+        job->second.pop_back();
+        keptCount++;
+    }
+    if (keptCount == 0)
+        return false;
+
+    dirty.assign(old.pages, false);
+    vector<AtlasPage> pages(old.pages, AtlasPage { nullptr, 0, 0 });
+    vector<Packer*> warm;
+    for (int i = 0; i < old.pages; ++i)
+        warm.push_back(new Packer(optSize, optSize, optPadding));
+
+    auto fail = [&]() {
+        for (auto& page : pages)
+            free(page.data);
+        for (auto packer : warm)
+        {
+            for (auto bitmap : packer->bitmaps)
+                delete bitmap;
+            delete packer;
+        }
+        for (auto bitmap : bitmaps)
+            delete bitmap;
+        bitmaps.clear();
+        return false;
+    };
+
+    //Cut the kept bitmaps out of the old pages. dupID is an index into old.sprites, where
+    //points want one into their page, so duplicates are remapped as they're added. If what
+    //a duplicate pointed at is gone it takes over the spot, the pixels there are the same.
+    vector<int> newIndex(old.sprites.size(), -1);
+    for (size_t i = 0; i < old.sprites.size(); ++i)
+    {
+        const ManifestSprite& sprite = old.sprites[i];
+        if (keptJob[i] < 0)
+        {
+            dirty[sprite.page] = true;
+            continue;
+        }
+
+        AtlasPage& page = pages[sprite.page];
+        if (page.data == nullptr && !LoadAtlasPage(page, atlas + to_string(sprite.page) + PageExtension()))
+            return fail();
+        if (sprite.x < 0 || sprite.y < 0 || sprite.width <= 0 || sprite.height <= 0 || sprite.x + sprite.width > (int)page.width || sprite.y + sprite.height > (int)page.height)
+            return fail();
+
+        Bitmap* bitmap = new Bitmap(sprite.width, sprite.height);
+        const uint32_t* src = reinterpret_cast<const uint32_t*>(page.data);
+        for (int y = 0; y < sprite.height; ++y)
+            memcpy(bitmap->data + y * sprite.width, src + (sprite.y + y) * page.width + sprite.x, sprite.width * sizeof(uint32_t));
+        bitmap->name = jobs[keptJob[i]].name;
+        bitmap->file = sprite.file;
+        bitmap->frameX = sprite.frameX;
+        bitmap->frameY = sprite.frameY;
+        bitmap->frameW = sprite.frameW;
+        bitmap->frameH = sprite.frameH;
+        bitmap->hashValue = sprite.hashValue;
+
+        Packer* packer = warm[sprite.page];
+        Point point;
+        point.x = sprite.x;
+        point.y = sprite.y;
+        point.dupID = -1;
+        point.rot = false;
+        if (sprite.dupID >= 0 && sprite.dupID < (int)i)
+        {
+            if (newIndex[sprite.dupID] >= 0)
+                point.dupID = newIndex[sprite.dupID];
+            else
+                newIndex[sprite.dupID] = (int)packer->bitmaps.size();
+        }
+        newIndex[i] = (int)packer->bitmaps.size();
+        packer->Place(bitmap, point, optUnique);
+    }
+    
+    //Give the packers back the free space they had, plus the spots of removed bitmaps that no
+    //duplicate took over, so they don't have to place every kept bitmap again
+    vector<vector<rbp::Rect>> freeRects(old.pages), dropped(old.pages);
+    for (auto& rect : old.free)
+        freeRects[rect.page].push_back(rbp::Rect { rect.x, rect.y, rect.width, rect.height });
+    for (size_t i = 0; i < old.sprites.size(); ++i)
+    {
+        const ManifestSprite& sprite = old.sprites[i];
+        if (keptJob[i] < 0 && sprite.dupID < 0 && newIndex[i] < 0)
+            dropped[sprite.page].push_back(rbp::Rect { sprite.x, sprite.y, sprite.width + optPadding, sprite.height + optPadding });
+    }
+    for (int i = 0; i < old.pages; ++i)
+        warm[i]->Restore(freeRects[i], dropped[i]);
+
+    //Decode everything else and pack it into the free space, in the same order a full pack uses
+    vector<BitmapJob> all = jobs;
+    vector<BitmapJob> changed;
+    for (size_t i = 0; i < jobs.size(); ++i)
+        if (!jobKept[i])
+            changed.push_back(jobs[i]);
+    jobs = changed;
+    int changedCount = (int)jobs.size();
+    if (changedCount > 0)
+        DecodeBitmaps();
+    jobs = all;
+
+    SortBitmaps();
+    while (!bitmaps.empty())
+    {
+        Bitmap* bitmap = bitmaps.back();
+        size_t i = 0;
+        while (i < warm.size() && !warm[i]->Insert(bitmap, optUnique, optRotate))
+            ++i;
+        if (i == warm.size())
+        {
+            Con_Printf("%s doesn't fit in the last atlas, repacking everything\n", bitmap->name.c_str());
+            return fail();
+        }
+        dirty[i] = true;
+        bitmaps.pop_back();
+    }
+
+    for (size_t i = 0; i < warm.size(); ++i)
+    {
+        if (warm[i]->bitmaps.empty())
+            return fail();
+        warm[i]->Shrink();
+        if (!dirty[i] && (warm[i]->width != (int)pages[i].width || warm[i]->height != (int)pages[i].height))
+            dirty[i] = true;
+    }
+
+    for (auto& page : pages)
+        free(page.data);
+    packers = warm;
+    jobs.clear();
+    Con_Printf("warm start: kept %i images, packed %i\n", keptCount, changedCount);
+    return true;
+}
+
+//Packs every bitmap from scratch, replacing the last atlas
+static bool PackBitmaps(const string& atlas, const string& name)
+{
+    //Remove old files
+    RemoveFile(atlas + ".hash");
+    RemoveFile(atlas + ".manifest");
+    RemoveFile(atlas + ".bin");
+    RemoveFile(atlas + ".xml");
+    RemoveFile(atlas + ".json");
+    for (size_t i = 0; i < 16; ++i)
+    {
+        RemoveFile(atlas + to_string(i) + ".png");
+        RemoveFile(atlas + to_string(i) + ".rgba");
+    }
+    
+    DecodeBitmaps();
+    
+    //Sort the bitmaps by area
+    SortBitmaps();
+    
+    //Pack the bitmaps
+    while (!bitmaps.empty())
+    {
+        if (optVerbose)
+            Con_Printf("packing %i images...\n", bitmaps.size());
+        auto packer = new Packer(optSize, optSize, optPadding);
+        packer->Pack(bitmaps, optVerbose, optUnique, optRotate);
+        packers.push_back(packer);
+        if (optVerbose) {
+            Con_Printf("finished packing: %s%s (%i x %i)\n", name.c_str(), to_string(packers.size() - 1).c_str(), packer->width, packer->height);
+        }
+
+        if (packer->bitmaps.empty())
+        {
+            Con_Printf("packing failed, could not fit bitmap: %s\n", (bitmaps.back())->name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SaveAtlasManifest(Manifest& manifest, const string& file)
+{
+    manifest.pages = (int)packers.size();
+    manifest.sprites.clear();
+    manifest.free.clear();
+    for (size_t i = 0; i < packers.size(); ++i)
+    {
+        //dupIDs are saved as an index into all of the sprites, not just the ones on this page
+        int first = (int)manifest.sprites.size();
+        for (size_t j = 0; j < packers[i]->bitmaps.size(); ++j)
+        {
+            const Bitmap* bitmap = packers[i]->bitmaps[j];
+            const Point& point = packers[i]->points[j];
+            ManifestSprite sprite;
+            sprite.file = bitmap->file;
+            sprite.page = (int)i;
+            sprite.x = point.x;
+            sprite.y = point.y;
+            sprite.width = bitmap->width;
+            sprite.height = bitmap->height;
+            sprite.frameX = bitmap->frameX;
+            sprite.frameY = bitmap->frameY;
+            sprite.frameW = bitmap->frameW;
+            sprite.frameH = bitmap->frameH;
+            sprite.dupID = point.dupID >= 0 ? first + point.dupID : -1;
+            sprite.hashValue = bitmap->hashValue;
+            manifest.sprites.push_back(sprite);
+        }
+        for (auto& rect : packers[i]->bin.FreeRectangles())
+            manifest.free.push_back(ManifestRect { (int)i, rect.x, rect.y, rect.width, rect.height });
+    }
+    SaveManifest(manifest, file);
+}
+
 int crunch_main(int argc, const char* argv[])
 {
     packers.clear();
     bitmaps.clear();
+    jobs.clear();
 
     if (argc < 3)
     {
@@ -256,6 +648,9 @@ int crunch_main(int argc, const char* argv[])
     optVerbose = false;
     optForce = false;
     optUnique = false;
+    optJobs = 0;
+    optWarm = false;
+    optImage = "png";
     if (argc <= 3) {
         optPremultiply = optTrim = optUnique = true;
     }
@@ -273,6 +668,12 @@ int crunch_main(int argc, const char* argv[])
                 optForce = true;
             else if (arg == "-u" || arg == "--unique")
                 optUnique = true;
+            else if (arg == "-w" || arg == "--warm")
+                optWarm = true;
+            else if (arg.find("--image") == 0)
+                optImage = GetImageFormat(arg.substr(7));
+            else if (arg.find("-i") == 0)
+                optImage = GetImageFormat(arg.substr(2));
             //else if (arg == "-r" || arg == "--rotate")
             //    optRotate = true;
             else if (arg.find("--size") == 0)
@@ -283,6 +684,10 @@ int crunch_main(int argc, const char* argv[])
                 optPadding = GetPadding(arg.substr(5));
             else if (arg.find("-p") == 0)
                 optPadding = GetPadding(arg.substr(2));
+            else if (arg.find("--jobs") == 0)
+                optJobs = GetJobs(arg.substr(6));
+            else if (arg.find("-j") == 0)
+                optJobs = GetJobs(arg.substr(2));
             else
             {
                 Con_Printf("unexpected argument: %s\n", arg.c_str());
@@ -292,6 +697,26 @@ int crunch_main(int argc, const char* argv[])
     }
 
     
+    //Load the manifest from the last run, files that haven't been touched since then reuse its hashes
+    Manifest oldManifest;
+    if (!LoadManifest(oldManifest, outputDir + name + ".manifest"))
+    {
+        oldManifest.pages = 0;
+        oldManifest.files.clear();
+        oldManifest.sprites.clear();
+    }
+
+    //The options that change the layout, warm starting is only possible if they're the same as last time
+    Manifest manifest;
+    manifest.options = 0;
+    HashCombine(manifest.options, static_cast<size_t>(optSize));
+    HashCombine(manifest.options, static_cast<size_t>(optPadding));
+    HashCombine(manifest.options, static_cast<size_t>(optPremultiply));
+    HashCombine(manifest.options, static_cast<size_t>(optTrim));
+    HashCombine(manifest.options, static_cast<size_t>(optUnique));
+    HashCombine(manifest.options, static_cast<size_t>(optRotate));
+    HashString(manifest.options, optImage);
+
     //Hash the arguments and input directories
     size_t newHash = 0;
     for (int i = 1; i < argc; ++i)
@@ -299,9 +724,9 @@ int crunch_main(int argc, const char* argv[])
     for (size_t i = 0; i < inputs.size(); ++i)
     {
         if (inputs[i].rfind('.') == string::npos)
-            HashFiles(newHash, inputs[i]);
+            HashFiles(newHash, inputs[i], oldManifest.files, manifest.files);
         else
-            HashFile(newHash, inputs[i]);
+            HashFile(newHash, inputs[i], oldManifest.files, manifest.files);
     }
     
     //Load the old hash
@@ -336,18 +761,12 @@ int crunch_main(int argc, const char* argv[])
         //Con_Printf("\t--rotate: %s\n", optRotate ? "true" : "false");
         Con_Printf("\t--size: %i\n", optSize);
         Con_Printf("\t--pad: %i\n", optPadding);
+        Con_Printf("\t--jobs: %i\n", optJobs);
+        Con_Printf("\t--warm: %s\n", optWarm ? "true" : "false");
+        Con_Printf("\t--image: %s\n", optImage.c_str());
     }
     
-    //Remove old files
-
-    RemoveFile(outputDir + name + ".hash");
-    RemoveFile(outputDir + name + ".bin");
-    RemoveFile(outputDir + name + ".xml");
-    RemoveFile(outputDir + name + ".json");
-    for (size_t i = 0; i < 16; ++i)
-        RemoveFile(outputDir + name + to_string(i) + ".png");
-    
-    //Load the bitmaps from all the input files and directories
+    //Find the bitmaps in all the input files and directories
     if (optVerbose)
         Con_Printf("loading images...\n");
     for (size_t i = 0; i < inputs.size(); ++i)
@@ -358,35 +777,28 @@ int crunch_main(int argc, const char* argv[])
 			LoadBitmaps("", inputs[i]);
     }
     
-    //Sort the bitmaps by area
-    sort(bitmaps.begin(), bitmaps.end(), [](const Bitmap* a, const Bitmap* b) {
-        return (a->width * a->height) < (b->width * b->height);
-    });
+    //Try to update the last atlas, -f always packs from scratch
+    vector<bool> dirty;
+    bool warm = optWarm && !optForce && oldManifest.options == manifest.options && WarmStart(oldManifest, manifest.files, outputDir + name, dirty);
     
-    //Pack the bitmaps
-    while (!bitmaps.empty())
+    if (!warm)
     {
-        if (optVerbose)
-            Con_Printf("packing %i images...\n", bitmaps.size());
-        auto packer = new Packer(optSize, optSize, optPadding);
-        packer->Pack(bitmaps, optVerbose, optUnique, optRotate);
-        packers.push_back(packer);
-        if (optVerbose) {
-            Con_Printf("finished packing: %s%s (%i x %i)\n", name.c_str(), to_string(packers.size() - 1).c_str(), packer->width, packer->height);
-        }
-
-        if (packer->bitmaps.empty())
-        {
-            Con_Printf("packing failed, could not fit bitmap: %s\n", (bitmaps.back())->name.c_str());
+        if (!PackBitmaps(outputDir + name, name))
             return EXIT_FAILURE;
-        }
+        dirty.assign(packers.size(), true);
     }
     
-    //Save the atlas image
+    //Save the atlas image, a warm start only rewrites the pages that changed
     for (size_t i = 0; i < packers.size(); ++i)
     {
-        Con_Printf("writing png: %s%s%s.png\n", outputDir.c_str(), name.c_str(), to_string(i).c_str());
-        packers[i]->SavePng(outputDir + name + to_string(i) + ".png");
+        if (!dirty[i])
+            continue;
+        string page = outputDir + name + to_string(i) + PageExtension();
+        Con_Printf("writing %s: %s\n", optImage.c_str(), page.c_str());
+        if (optImage == "png")
+            packers[i]->SavePng(page);
+        else
+            packers[i]->SaveRaw(page, optImage == "lz4");
     }
     
     //Save the atlas binary
@@ -405,7 +817,7 @@ int crunch_main(int argc, const char* argv[])
 	WriteShort(bin, numImages);
 
     for (size_t i = 0; i < packers.size(); ++i)
-        packers[i]->SaveBin(argv[2] + to_string(i) + ".png", bin, optTrim, optRotate);
+        packers[i]->SaveBin(argv[2] + to_string(i) + PageExtension(), bin, optTrim, optRotate);
     bin.close();
 
     //Save the atlas binary
@@ -427,8 +839,12 @@ int crunch_main(int argc, const char* argv[])
     wren << "}" << endl;
     wren.close();
 
-    //Save the new hash
+    //Save the new hash and the manifest for the next run
+    SaveAtlasManifest(manifest, outputDir + name + ".manifest");
     SaveHash(newHash, outputDir + name + ".hash");
+
+    //Pick up the files we just wrote
+    FS_RebuildIndex();
     
     return EXIT_SUCCESS;
 }
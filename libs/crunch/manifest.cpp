@@ -0,0 +1,92 @@
+#include "manifest.hpp"
+#include <fstream>
+
+/*
+ text format, paths go last since they can have spaces:
+    crunch_manifest [version] [options] [pages]
+    f [size] [modtime] [hash] [path]     (every input file)
+    s [page] [x] [y] [width] [height] [frame_x] [frame_y] [frame_width] [frame_height] [dup_id] [hash] [path]
+    r [page] [x] [y] [width] [height]    (free space the packer had left on each page)
+ */
+
+#define MANIFEST_VERSION 1
+
+static bool ReadPath(ifstream& stream, string& path)
+{
+    stream.get();
+    getline(stream, path);
+    return !path.empty();
+}
+
+bool LoadManifest(Manifest& manifest, const string& file)
+{
+    ifstream stream(file);
+    if (!stream)
+        return false;
+    
+    string magic;
+    int version;
+    stream >> magic >> version >> manifest.options >> manifest.pages;
+    if (!stream || magic != "crunch_manifest" || version != MANIFEST_VERSION)
+        return false;
+    
+    manifest.files.clear();
+    manifest.sprites.clear();
+    manifest.free.clear();
+    
+    string type;
+    while (stream >> type)
+    {
+        if (type == "f")
+        {
+            FileHash entry;
+            string path;
+            stream >> entry.size >> entry.modtime >> entry.hash;
+            if (!stream || !ReadPath(stream, path))
+                return false;
+            manifest.files[path] = entry;
+        }
+        else if (type == "s")
+        {
+            ManifestSprite sprite;
+            stream >> sprite.page >> sprite.x >> sprite.y >> sprite.width >> sprite.height;
+            stream >> sprite.frameX >> sprite.frameY >> sprite.frameW >> sprite.frameH;
+            stream >> sprite.dupID >> sprite.hashValue;
+            if (!stream || !ReadPath(stream, sprite.file))
+                return false;
+            if (sprite.page < 0 || sprite.page >= manifest.pages)
+                return false;
+            manifest.sprites.push_back(sprite);
+        }
+        else if (type == "r")
+        {
+            ManifestRect rect;
+            stream >> rect.page >> rect.x >> rect.y >> rect.width >> rect.height;
+            if (!stream || rect.page < 0 || rect.page >= manifest.pages)
+                return false;
+            manifest.free.push_back(rect);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+void SaveManifest(const Manifest& manifest, const string& file)
+{
+    ofstream stream(file);
+    stream << "crunch_manifest " << MANIFEST_VERSION << " " << manifest.options << " " << manifest.pages << "\n";
+    for (auto& entry : manifest.files)
+        stream << "f " << entry.second.size << " " << entry.second.modtime << " " << entry.second.hash << " " << entry.first << "\n";
+    for (auto& sprite : manifest.sprites)
+    {
+        stream << "s " << sprite.page << " " << sprite.x << " " << sprite.y << " " << sprite.width << " " << sprite.height << " ";
+        stream << sprite.frameX << " " << sprite.frameY << " " << sprite.frameW << " " << sprite.frameH << " ";
+        stream << sprite.dupID << " " << sprite.hashValue << " " << sprite.file << "\n";
+    }
+    for (auto& rect : manifest.free)
+        stream << "r " << rect.page << " " << rect.x << " " << rect.y << " " << rect.width << " " << rect.height << "\n";
+}
@@ -0,0 +1,51 @@
+#ifndef manifest_hpp
+#define manifest_hpp
+
+#include <string>
+#include <vector>
+#include "hash.hpp"
+
+using namespace std;
+
+//A bitmap as it was packed last run, enough to cut it back out of the old atlas
+struct ManifestSprite
+{
+    string file;
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+    int frameX;
+    int frameY;
+    int frameW;
+    int frameH;
+    int dupID;
+    size_t hashValue;
+};
+
+//Space that was left free on a page
+struct ManifestRect
+{
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+//Saved next to the atlas, so the next run only has to read the inputs that changed and can
+//keep everything else where it was
+struct Manifest
+{
+    size_t options;
+    int pages;
+    FileHashes files;
+    vector<ManifestSprite> sprites;
+    vector<ManifestRect> free;
+};
+
+bool LoadManifest(Manifest& manifest, const string& file);
+void SaveManifest(const Manifest& manifest, const string& file);
+
+#endif
@@ -38,17 +38,13 @@ using namespace std;
 using namespace rbp;
 
 Packer::Packer(int width, int height, int pad)
-: width(width), height(height), pad(pad)
+: width(width), height(height), pad(pad), usedWidth(0), usedHeight(0), bin(width, height)
 {
     
 }
 
 void Packer::Pack(vector<Bitmap*>& bitmaps, bool verbose, bool unique, bool rotate)
 {
-    MaxRectsBinPack packer(width, height);
-    
-    int ww = 0;
-    int hh = 0;
     while (!bitmaps.empty())
     {
         auto bitmap = bitmaps.back();
@@ -56,56 +52,101 @@ void Packer::Pack(vector<Bitmap*>& bitmaps, bool verbose, bool unique, bool rota
 		if (verbose)
 			Con_Printf("\t%i: %s\n", bitmaps.size(), bitmap->name.c_str());
         
-        //Check to see if this is a duplicate of an already packed bitmap
-        if (unique)
-        {
-            auto di = dupLookup.find(bitmap->hashValue);
-            if (di != dupLookup.end() && bitmap->Equals(this->bitmaps[di->second]))
-            {
-                Point p = points[di->second];
-                p.dupID = di->second;
-                points.push_back(p);
-                this->bitmaps.push_back(bitmap);
-                bitmaps.pop_back();
-                continue;
-            }
-        }
+        if (!Insert(bitmap, unique, rotate))
+            break;
         
-        //If it's not a duplicate, pack it into the atlas
+        bitmaps.pop_back();
+    }
+    
+    Shrink();
+}
+
+bool Packer::Insert(Bitmap* bitmap, bool unique, bool rotate)
+{
+    //Check to see if this is a duplicate of an already packed bitmap
+    if (unique)
+    {
+        auto di = dupLookup.find(bitmap->hashValue);
+        if (di != dupLookup.end() && bitmap->Equals(this->bitmaps[di->second]))
         {
-            Rect rect = packer.Insert(bitmap->width + pad, bitmap->height + pad, rotate, MaxRectsBinPack::RectBestShortSideFit);
-            
-            if (rect.width == 0 || rect.height == 0)
-                break;
-            
-            if (unique)
-                dupLookup[bitmap->hashValue] = static_cast<int>(points.size());
-            
-            //Check if we rotated it
-            Point p;
-            p.x = rect.x;
-            p.y = rect.y;
-            p.dupID = -1;
-            p.rot = rotate && bitmap->width != (rect.width - pad);
-            
+            Point p = points[di->second];
+            p.dupID = di->second;
             points.push_back(p);
             this->bitmaps.push_back(bitmap);
-            bitmaps.pop_back();
-            
-            ww = max(rect.x + rect.width, ww);
-            hh = max(rect.y + rect.height, hh);
+            return true;
         }
     }
     
-    while (width / 2 >= ww)
+    //If it's not a duplicate, pack it into the atlas
+    Rect rect = bin.Insert(bitmap->width + pad, bitmap->height + pad, rotate, MaxRectsBinPack::RectBestShortSideFit);
+    
+    if (rect.width == 0 || rect.height == 0)
+        return false;
+    
+    if (unique)
+        dupLookup[bitmap->hashValue] = static_cast<int>(points.size());
+    
+    //Check if we rotated it
+    Point p;
+    p.x = rect.x;
+    p.y = rect.y;
+    p.dupID = -1;
+    p.rot = rotate && bitmap->width != (rect.width - pad);
+    
+    points.push_back(p);
+    this->bitmaps.push_back(bitmap);
+    
+    usedWidth = max(rect.x + rect.width, usedWidth);
+    usedHeight = max(rect.y + rect.height, usedHeight);
+    return true;
+}
+
+void Packer::Place(Bitmap* bitmap, const Point& point, bool unique)
+{
+    if (point.dupID < 0)
+    {
+        if (unique)
+            dupLookup[bitmap->hashValue] = static_cast<int>(points.size());
+        
+        usedWidth = max(point.x + (point.rot ? bitmap->height : bitmap->width) + pad, usedWidth);
+        usedHeight = max(point.y + (point.rot ? bitmap->width : bitmap->height) + pad, usedHeight);
+    }
+    
+    points.push_back(point);
+    this->bitmaps.push_back(bitmap);
+}
+
+void Packer::Restore(const vector<Rect>& free, const vector<Rect>& dropped)
+{
+    vector<Rect> used;
+    for (size_t i = 0, j = bitmaps.size(); i < j; ++i)
+    {
+        if (points[i].dupID >= 0)
+            continue;
+        Rect rect;
+        rect.x = points[i].x;
+        rect.y = points[i].y;
+        rect.width = (points[i].rot ? bitmaps[i]->height : bitmaps[i]->width) + pad;
+        rect.height = (points[i].rot ? bitmaps[i]->width : bitmaps[i]->height) + pad;
+        used.push_back(rect);
+    }
+    used.insert(used.end(), dropped.begin(), dropped.end());
+    bin.Restore(used, free);
+    
+    for (auto& rect : dropped)
+        bin.FreeRect(rect);
+}
+
+void Packer::Shrink()
+{
+    while (width / 2 >= usedWidth && width > 1)
         width /= 2;
-    while( height / 2 >= hh)
+    while (height / 2 >= usedHeight && height > 1)
         height /= 2;
 }
 
-void Packer::SavePng(const string& file)
+void Packer::CopyPixels(Bitmap& bitmap)
 {
-    Bitmap bitmap(width, height);
     for (size_t i = 0, j = bitmaps.size(); i < j; ++i)
     {
         if (points[i].dupID < 0)
@@ -116,9 +157,22 @@ void Packer::SavePng(const string& file)
                 bitmap.CopyPixels(bitmaps[i], points[i].x, points[i].y);
         }
     }
+}
+
+void Packer::SavePng(const string& file)
+{
+    Bitmap bitmap(width, height);
+    CopyPixels(bitmap);
     bitmap.SaveAs(file);
 }
 
+void Packer::SaveRaw(const string& file, bool lz4)
+{
+    Bitmap bitmap(width, height);
+    CopyPixels(bitmap);
+    bitmap.SaveRaw(file, lz4);
+}
+
 void Packer::SaveBin(const string& name, ofstream& bin, bool trim, bool rotate)
 {
     WriteString(bin, name);
@@ -31,6 +31,7 @@
 #include <fstream>
 #include <unordered_map>
 #include "bitmap.hpp"
+#include "MaxRectsBinPack.h"
 
 using namespace std;
 
@@ -47,14 +48,29 @@ struct Packer
     int width;
     int height;
     int pad;
+    int usedWidth;
+    int usedHeight;
     
+    rbp::MaxRectsBinPack bin;
     vector<Bitmap*> bitmaps;
     vector<Point> points;
     unordered_map<size_t, int> dupLookup;
     
     Packer(int width, int height, int pad);
     void Pack(vector<Bitmap*>& bitmaps, bool verbose, bool unique, bool rotate);
+    //Packs one bitmap into the free space, returns false if it doesn't fit
+    bool Insert(Bitmap* bitmap, bool unique, bool rotate);
+    //Puts a bitmap back at the spot it had in a previous pack, call Restore once they're all placed
+    void Place(Bitmap* bitmap, const Point& point, bool unique);
+    //Restores the free space a previous pack left, and frees the space of bitmaps dropped since then
+    void Restore(const vector<rbp::Rect>& free, const vector<rbp::Rect>& dropped);
+    //Shrinks the atlas to the smallest power of two that fits everything packed so far
+    void Shrink();
+    //Draws every packed bitmap into a page sized bitmap
+    void CopyPixels(Bitmap& bitmap);
     void SavePng(const string& file);
+    //Saves the page as rgba pixels that can be uploaded without decoding, see rawimage.h
+    void SaveRaw(const string& file, bool lz4);
     void SaveBin(const string& name, ofstream& bin, bool trim, bool rotate);
 };
 
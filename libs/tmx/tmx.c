@@ -78,6 +78,39 @@ tmx_tile* tmx_get_tile(tmx_map *map, unsigned int gid) {
 	return NULL;
 }
 
+int tmx_chunk_decode(tmx_chunk *chunk) {
+	int32_t *gids = NULL;
+
+	if (!chunk) {
+		tmx_err(E_INVAL, "tmx_chunk_decode: invalid argument: chunk is NULL");
+		return 0;
+	}
+
+	if (chunk->gids) return 1;
+
+	if (!chunk->data || (chunk->encoding != CE_CSV && chunk->encoding != CE_BASE64)) {
+		tmx_err(E_ENCCMP, "tmx_chunk_decode: chunk at %d,%d has no data", chunk->x, chunk->y);
+		return 0;
+	}
+
+	set_alloc_functions();
+
+	if (!data_decode(chunk->data, chunk->encoding == CE_CSV ? CSV : B64Z, (size_t)chunk->width * chunk->height, &gids)) {
+		tmx_free_func(gids);
+		return 0;
+	}
+
+	chunk->gids = gids;
+	return 1;
+}
+
+void tmx_chunk_evict(tmx_chunk *chunk) {
+	if (chunk && chunk->gids) {
+		tmx_free_func(chunk->gids);
+		chunk->gids = NULL;
+	}
+}
+
 tmx_property* tmx_get_property(tmx_properties *hash, const char *key) {
 	if (hash == NULL) {
 		return NULL;
@@ -57,6 +57,7 @@ enum tmx_obj_type {OT_NONE, OT_SQUARE, OT_POLYGON, OT_POLYLINE, OT_ELLIPSE, OT_T
 enum tmx_property_type {PT_NONE, PT_INT, PT_FLOAT, PT_BOOL, PT_STRING, PT_COLOR, PT_FILE};
 enum tmx_horizontal_align {HA_NONE, HA_LEFT, HA_CENTER, HA_RIGHT};
 enum tmx_vertical_align {VA_NONE, VA_TOP, VA_CENTER, VA_BOTTOM};
+enum tmx_chunk_encoding {CE_NONE, CE_CSV, CE_BASE64}; /* base64 is zlib or gzip compressed */
 
 /* Typedefs of the structures below */
 typedef struct _tmx_prop tmx_property;
@@ -69,6 +70,7 @@ typedef struct _tmx_shape tmx_shape;
 typedef struct _tmx_text tmx_text;
 typedef struct _tmx_obj tmx_object;
 typedef struct _tmx_objgr tmx_object_group;
+typedef struct _tmx_chunk tmx_chunk;
 typedef struct _tmx_layer tmx_layer;
 typedef struct _tmx_map tmx_map;
 typedef void tmx_properties; /* hashtable, use function tmx_get_property(...) */
@@ -196,6 +198,17 @@ struct _tmx_objgr { /* <objectgroup> */
 	tmx_object *head;
 };
 
+struct _tmx_chunk { /* <chunk> in the <data> of an infinite map's layer */
+	int x, y; /* in tiles, can be negative */
+	unsigned int width, height;
+
+	enum tmx_chunk_encoding encoding;
+	char *data; /* the chunk's text as it is in the file, kept until the map is freed */
+	int32_t *gids; /* width*height gids, NULL until tmx_chunk_decode is called */
+
+	tmx_user_data user_data;
+};
+
 struct _tmx_layer { /* <layer> or <imagelayer> or <objectgroup> */
 	char *name;
 	double opacity;
@@ -210,6 +223,9 @@ struct _tmx_layer { /* <layer> or <imagelayer> or <objectgroup> */
 		tmx_layer *group_head;
 	} content;
 
+	tmx_chunk *chunks; /* layers of infinite maps have these instead of content.gids */
+	int chunk_count;
+
 	tmx_user_data user_data;
 	tmx_properties *properties;
 	tmx_layer *next;
@@ -227,6 +243,7 @@ struct _tmx_map { /* <map> (Head of the data structure) */
 
 	unsigned int backgroundcolor; /* bytes : RGB */
 	enum tmx_map_renderorder renderorder;
+	int infinite; /* tile layers are stored in chunks */
 
 	tmx_properties *properties;
 	tmx_tileset_list *ts_head;
@@ -264,12 +281,40 @@ typedef int (*tmx_read_functor)(void *userdata, char *buffer, int len);
    returns NULL if an error occurred and set tmx_errno */
 TMXEXPORT tmx_map* tmx_load_callback(tmx_read_functor callback, void *userdata);
 
+/* Loads a map from a buffer holding a .tmxb file, see tmx_bin.cpp for the layout
+   returns NULL if an error occurred and set tmx_errno */
+TMXEXPORT tmx_map* tmx_load_binary(const void *buffer, int len);
+
+/* Returns 1 if the buffer starts like a .tmxb file */
+TMXEXPORT int tmx_is_binary(const void *buffer, int len);
+
+/* Writes the map in the .tmxb format, len gets the size of the returned buffer
+   free the buffer with tmx_free_func, returns NULL if an error occurred and set tmx_errno */
+TMXEXPORT void* tmx_save_binary(tmx_map *map, int *len);
+
+/* Same as tmx_save_binary, also storing the paths of the other files the map was loaded from
+   (external tilesets), which can be read back with tmx_binary_dependencies */
+TMXEXPORT void* tmx_save_binary_deps(tmx_map *map, const char **deps, int dep_count, int *len);
+
+/* Callback used by tmx_binary_dependencies, path is only valid during the call */
+typedef void (*tmx_dep_functor)(const char *path, void *userdata);
+/* Calls callback for each dependency stored in a .tmxb without loading the map
+   returns how many there are, or -1 if an error occurred and set tmx_errno */
+TMXEXPORT int tmx_binary_dependencies(const void *buffer, int len, tmx_dep_functor callback, void *userdata);
+
 /* Frees the map data structure */
 TMXEXPORT void tmx_map_free(tmx_map *map);
 
 /* Returns the tile associated with this gid, returns NULL if it fails */
 TMXEXPORT tmx_tile* tmx_get_tile(tmx_map *map, unsigned int gid);
 
+/* Decodes chunk->data into chunk->gids if they aren't decoded already
+   returns 0 if an error occurred and set tmx_errno */
+TMXEXPORT int tmx_chunk_decode(tmx_chunk *chunk);
+
+/* Frees chunk->gids, tmx_chunk_decode can decode them again later */
+TMXEXPORT void tmx_chunk_evict(tmx_chunk *chunk);
+
 /* Returns the tmx_property from given hashtable and key, returns NULL if not found */
 TMXEXPORT tmx_property* tmx_get_property(tmx_properties *hash, const char *key);
 
@@ -0,0 +1,1140 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include "tmx.h"
+#include "tsx.h"
+#include "tmx_utils.h"
+}
+
+/*
+	.tmxb binary maps
+
+	Layout, everything is little endian:
+		tmxb_header
+		tmxb_section[section_count]
+		section data, each section starts on an 8 byte boundary
+
+	Every section is an array of fixed size records. Records are only ever extended at the end, a
+	reader copies the fields it knows and zero fills the rest, and sections with an unknown id are
+	skipped, so older code can read files written by newer code. TMXB_VERSION only changes when a
+	file can't be read that way anymore.
+
+	References between records are index + 1 (string references are offset + 1 into the strings
+	section), so 0 always means none, and zero filled fields default to nothing.
+
+	Image sources are stored exactly as they were passed to tmx_img_load_func when the map was
+	written, see tmx_save_binary.
+
+	The dependencies section lists the other files the map was built from (external tilesets),
+	so whoever decides if a .tmxb is still up to date can check them without loading it, see
+	tmx_binary_dependencies.
+*/
+
+#define TMXB_MAGIC 0x42584d54 /* "TMXB" */
+#define TMXB_VERSION 1
+
+enum {
+	TMXB_STRINGS = 1,
+	TMXB_PROPS,
+	TMXB_MAP,
+	TMXB_IMAGES,
+	TMXB_TILESETS,
+	TMXB_TILES,
+	TMXB_FRAMES,
+	TMXB_LAYERS,
+	TMXB_GIDS,
+	TMXB_OBJECTS,
+	TMXB_POINTS,
+	TMXB_TEXTS,
+	TMXB_CHUNKS,
+	TMXB_DEPENDENCIES, /* string references */
+	TMXB_SECTION_MAX
+};
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size; /* offset of the section table */
+	uint32_t section_count;
+} tmxb_header;
+
+typedef struct {
+	uint32_t id;
+	uint32_t count;
+	uint32_t record_size;
+	uint32_t offset;
+} tmxb_section;
+
+typedef struct {
+	int32_t name;
+	int32_t type;
+	int32_t value; /* integer, boolean, color or string reference */
+	float decimal;
+} tmxb_prop;
+
+typedef struct {
+	int32_t orient;
+	uint32_t width, height;
+	uint32_t tile_width, tile_height;
+	int32_t stagger_index, stagger_axis, hexsidelength;
+	uint32_t backgroundcolor;
+	int32_t renderorder;
+	int32_t prop_start, prop_count;
+	int32_t infinite;
+} tmxb_map;
+
+typedef struct {
+	int32_t source;
+	uint32_t trans;
+	int32_t uses_trans;
+	uint32_t width, height;
+} tmxb_image;
+
+typedef struct {
+	uint32_t firstgid;
+	int32_t name;
+	uint32_t tile_width, tile_height;
+	uint32_t spacing, margin;
+	int32_t x_offset, y_offset;
+	uint32_t tilecount;
+	int32_t image;
+	int32_t prop_start, prop_count;
+	int32_t tile_start, tile_count; /* only tiles that have something set are stored */
+} tmxb_tileset;
+
+typedef struct {
+	uint32_t index; /* position in tileset->tiles */
+	uint32_t id;
+	int32_t type;
+	int32_t image;
+	int32_t prop_start, prop_count;
+	int32_t frame_start, frame_count;
+	int32_t collision_start, collision_count;
+} tmxb_tile;
+
+typedef struct {
+	uint32_t tile_id;
+	uint32_t duration;
+} tmxb_frame;
+
+typedef struct {
+	double opacity;
+	int32_t name;
+	int32_t type;
+	int32_t parent; /* group layer this is in, layers come after their group */
+	int32_t visible;
+	int32_t offsetx, offsety;
+	int32_t prop_start, prop_count;
+	int32_t content_start, content_count; /* gids or objects, or the image in content_start */
+	uint32_t color; /* object groups */
+	int32_t draworder;
+	int32_t chunk_start, chunk_count; /* tile layers of infinite maps, which have no gids */
+} tmxb_layer;
+
+typedef struct {
+	double x, y, width, height, rotation;
+	uint32_t id;
+	int32_t obj_type;
+	int32_t visible;
+	int32_t name, type;
+	int32_t prop_start, prop_count;
+	int32_t content; /* gid, first point or text */
+	int32_t point_count;
+	int32_t pad;
+} tmxb_object;
+
+typedef struct {
+	int32_t fontfamily;
+	int32_t pixelsize;
+	uint32_t color;
+	int32_t wrap, bold, italic, underline, strikeout, kerning;
+	int32_t halign, valign;
+	int32_t text;
+} tmxb_text;
+
+typedef struct {
+	int32_t x, y;
+	uint32_t width, height;
+	int32_t encoding;
+	int32_t data; /* string reference, chunks stay encoded like they were in the xml */
+} tmxb_chunk;
+
+/*
+	Writer
+*/
+
+typedef struct {
+	std::unordered_map<std::string, int32_t> string_refs;
+	std::vector<char> strings;
+	std::vector<tmxb_prop> props;
+	std::vector<tmxb_image> images;
+	std::vector<tmxb_tileset> tilesets;
+	std::vector<tmxb_tile> tiles;
+	std::vector<tmxb_frame> frames;
+	std::vector<tmxb_layer> layers;
+	std::vector<int32_t> gids;
+	std::vector<tmxb_object> objects;
+	std::vector<double> points;
+	std::vector<tmxb_text> texts;
+	std::vector<tmxb_chunk> chunks;
+} tmxb_writer;
+
+static int32_t write_string(tmxb_writer *w, const char *str) {
+	if (str == NULL) {
+		return 0;
+	}
+
+	auto found = w->string_refs.find(str);
+	if (found != w->string_refs.end()) {
+		return found->second;
+	}
+
+	int32_t ref = (int32_t)w->strings.size() + 1;
+	w->strings.insert(w->strings.end(), str, str + strlen(str) + 1);
+	w->string_refs[str] = ref;
+	return ref;
+}
+
+static void write_property(tmx_property *prop, void *userdata) {
+	tmxb_writer *w = (tmxb_writer*)userdata;
+	tmxb_prop rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.name = write_string(w, prop->name);
+	rec.type = prop->type;
+
+	switch (prop->type) {
+	case PT_INT: rec.value = prop->value.integer; break;
+	case PT_BOOL: rec.value = prop->value.boolean; break;
+	case PT_COLOR: rec.value = (int32_t)prop->value.color; break;
+	case PT_FLOAT: rec.decimal = prop->value.decimal; break;
+	default: rec.value = write_string(w, prop->value.string); break;
+	}
+
+	w->props.push_back(rec);
+}
+
+static void write_properties(tmxb_writer *w, tmx_properties *props, int32_t *start, int32_t *count) {
+	*start = (int32_t)w->props.size();
+	if (props) {
+		tmx_property_foreach(props, write_property, w);
+	}
+	*count = (int32_t)w->props.size() - *start;
+}
+
+static int32_t write_image(tmxb_writer *w, tmx_image *img) {
+	if (img == NULL) {
+		return 0;
+	}
+
+	tmxb_image rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.source = write_string(w, img->source);
+	rec.trans = img->trans;
+	rec.uses_trans = img->uses_trans;
+	rec.width = (uint32_t)img->width;
+	rec.height = (uint32_t)img->height;
+
+	w->images.push_back(rec);
+	return (int32_t)w->images.size();
+}
+
+/* writes the objects in list order, returns how many there were */
+static int32_t write_objects(tmxb_writer *w, tmx_object *obj) {
+	int32_t count = 0;
+	for (; obj != NULL; obj = obj->next, count++) {
+		tmxb_object rec;
+		memset(&rec, 0, sizeof(rec));
+		rec.x = obj->x;
+		rec.y = obj->y;
+		rec.width = obj->width;
+		rec.height = obj->height;
+		rec.rotation = obj->rotation;
+		rec.id = obj->id;
+		rec.obj_type = obj->obj_type;
+		rec.visible = obj->visible;
+		rec.name = write_string(w, obj->name);
+		rec.type = write_string(w, obj->type);
+		write_properties(w, obj->properties, &rec.prop_start, &rec.prop_count);
+
+		if (obj->obj_type == OT_TILE) {
+			rec.content = obj->content.gid;
+		}
+		else if ((obj->obj_type == OT_POLYGON || obj->obj_type == OT_POLYLINE) && obj->content.shape) {
+			tmx_shape *shape = obj->content.shape;
+			rec.content = (int32_t)(w->points.size() / 2);
+			rec.point_count = shape->points_len;
+			for (int i = 0; i < shape->points_len; i++) {
+				w->points.push_back(shape->points[i][0]);
+				w->points.push_back(shape->points[i][1]);
+			}
+		}
+		else if (obj->obj_type == OT_TEXT && obj->content.text) {
+			tmx_text *text = obj->content.text;
+			tmxb_text trec;
+			memset(&trec, 0, sizeof(trec));
+			trec.fontfamily = write_string(w, text->fontfamily);
+			trec.pixelsize = text->pixelsize;
+			trec.color = text->color;
+			trec.wrap = text->wrap;
+			trec.bold = text->bold;
+			trec.italic = text->italic;
+			trec.underline = text->underline;
+			trec.strikeout = text->strikeout;
+			trec.kerning = text->kerning;
+			trec.halign = text->halign;
+			trec.valign = text->valign;
+			trec.text = write_string(w, text->text);
+			w->texts.push_back(trec);
+			rec.content = (int32_t)w->texts.size();
+		}
+
+		w->objects.push_back(rec);
+	}
+
+	return count;
+}
+
+static void write_tileset(tmxb_writer *w, tmx_tileset_list *tsl) {
+	tmx_tileset *ts = tsl->tileset;
+	tmxb_tileset rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.firstgid = tsl->firstgid;
+	rec.name = write_string(w, ts->name);
+	rec.tile_width = ts->tile_width;
+	rec.tile_height = ts->tile_height;
+	rec.spacing = ts->spacing;
+	rec.margin = ts->margin;
+	rec.x_offset = ts->x_offset;
+	rec.y_offset = ts->y_offset;
+	rec.tilecount = ts->tilecount;
+	rec.image = write_image(w, ts->image);
+	write_properties(w, ts->properties, &rec.prop_start, &rec.prop_count);
+
+	rec.tile_start = (int32_t)w->tiles.size();
+	for (unsigned int i = 0; i < ts->tilecount; i++) {
+		tmx_tile *tile = &ts->tiles[i];
+		if (tile->id == i && !tile->type && !tile->properties && !tile->image && !tile->animation_len && !tile->collision) {
+			continue;
+		}
+
+		tmxb_tile trec;
+		memset(&trec, 0, sizeof(trec));
+		trec.index = i;
+		trec.id = tile->id;
+		trec.type = write_string(w, tile->type);
+		trec.image = write_image(w, tile->image);
+		write_properties(w, tile->properties, &trec.prop_start, &trec.prop_count);
+
+		trec.frame_start = (int32_t)w->frames.size();
+		trec.frame_count = (int32_t)tile->animation_len;
+		for (unsigned int f = 0; f < tile->animation_len; f++) {
+			tmxb_frame frec = { tile->animation[f].tile_id, tile->animation[f].duration };
+			w->frames.push_back(frec);
+		}
+
+		trec.collision_start = (int32_t)w->objects.size();
+		trec.collision_count = write_objects(w, tile->collision);
+
+		w->tiles.push_back(trec);
+	}
+	rec.tile_count = (int32_t)w->tiles.size() - rec.tile_start;
+
+	w->tilesets.push_back(rec);
+}
+
+static void write_layers(tmxb_writer *w, tmx_map *map, tmx_layer *layer, int32_t parent) {
+	for (; layer != NULL; layer = layer->next) {
+		tmxb_layer rec;
+		memset(&rec, 0, sizeof(rec));
+		rec.opacity = layer->opacity;
+		rec.name = write_string(w, layer->name);
+		rec.type = layer->type;
+		rec.parent = parent;
+		rec.visible = layer->visible;
+		rec.offsetx = layer->offsetx;
+		rec.offsety = layer->offsety;
+		write_properties(w, layer->properties, &rec.prop_start, &rec.prop_count);
+
+		if (layer->type == L_LAYER && layer->chunks) {
+			rec.chunk_start = (int32_t)w->chunks.size();
+			rec.chunk_count = layer->chunk_count;
+			for (int i = 0; i < layer->chunk_count; i++) {
+				tmx_chunk *chunk = &layer->chunks[i];
+				tmxb_chunk crec;
+				memset(&crec, 0, sizeof(crec));
+				crec.x = chunk->x;
+				crec.y = chunk->y;
+				crec.width = chunk->width;
+				crec.height = chunk->height;
+				crec.encoding = chunk->encoding;
+				crec.data = write_string(w, chunk->data);
+				w->chunks.push_back(crec);
+			}
+		}
+		else if (layer->type == L_LAYER && layer->content.gids) {
+			rec.content_start = (int32_t)w->gids.size();
+			rec.content_count = (int32_t)(map->width * map->height);
+			w->gids.insert(w->gids.end(), layer->content.gids, layer->content.gids + rec.content_count);
+		}
+		else if (layer->type == L_OBJGR && layer->content.objgr) {
+			rec.color = layer->content.objgr->color;
+			rec.draworder = layer->content.objgr->draworder;
+			rec.content_start = (int32_t)w->objects.size();
+			rec.content_count = write_objects(w, layer->content.objgr->head);
+		}
+		else if (layer->type == L_IMAGE) {
+			rec.content_start = write_image(w, layer->content.image);
+		}
+
+		w->layers.push_back(rec);
+
+		if (layer->type == L_GROUP) {
+			write_layers(w, map, layer->content.group_head, (int32_t)w->layers.size());
+		}
+	}
+}
+
+template <typename T>
+static void add_section(std::vector<tmxb_section> &sections, uint32_t id, const std::vector<T> &v) {
+	tmxb_section s;
+	s.id = id;
+	s.count = (uint32_t)v.size();
+	s.record_size = sizeof(T);
+	s.offset = 0;
+	sections.push_back(s);
+}
+
+template <typename T>
+static void copy_section(char *buf, const tmxb_section &s, const std::vector<T> &v) {
+	if (v.size() > 0) {
+		memcpy(buf + s.offset, v.data(), v.size() * sizeof(T));
+	}
+}
+
+void* tmx_save_binary(tmx_map *map, int *len) {
+	return tmx_save_binary_deps(map, NULL, 0, len);
+}
+
+void* tmx_save_binary_deps(tmx_map *map, const char **deps, int dep_count, int *len) {
+	if (!map || !len || (dep_count > 0 && !deps)) {
+		tmx_err(E_INVAL, "tmx_save_binary: invalid argument: map, len or deps is NULL");
+		return NULL;
+	}
+
+	set_alloc_functions();
+
+	tmxb_writer w;
+
+	std::vector<tmxb_map> map_rec(1);
+	memset(&map_rec[0], 0, sizeof(tmxb_map));
+	map_rec[0].orient = map->orient;
+	map_rec[0].width = map->width;
+	map_rec[0].height = map->height;
+	map_rec[0].tile_width = map->tile_width;
+	map_rec[0].tile_height = map->tile_height;
+	map_rec[0].stagger_index = map->stagger_index;
+	map_rec[0].stagger_axis = map->stagger_axis;
+	map_rec[0].hexsidelength = map->hexsidelength;
+	map_rec[0].backgroundcolor = map->backgroundcolor;
+	map_rec[0].renderorder = map->renderorder;
+	map_rec[0].infinite = map->infinite;
+	write_properties(&w, map->properties, &map_rec[0].prop_start, &map_rec[0].prop_count);
+
+	for (tmx_tileset_list *tsl = map->ts_head; tsl != NULL; tsl = tsl->next) {
+		write_tileset(&w, tsl);
+	}
+
+	write_layers(&w, map, map->ly_head, 0);
+
+	std::vector<int32_t> dep_refs;
+	for (int i = 0; i < dep_count; i++) {
+		dep_refs.push_back(write_string(&w, deps[i]));
+	}
+
+	std::vector<tmxb_section> sections;
+	add_section(sections, TMXB_STRINGS, w.strings);
+	add_section(sections, TMXB_PROPS, w.props);
+	add_section(sections, TMXB_MAP, map_rec);
+	add_section(sections, TMXB_IMAGES, w.images);
+	add_section(sections, TMXB_TILESETS, w.tilesets);
+	add_section(sections, TMXB_TILES, w.tiles);
+	add_section(sections, TMXB_FRAMES, w.frames);
+	add_section(sections, TMXB_LAYERS, w.layers);
+	add_section(sections, TMXB_GIDS, w.gids);
+	add_section(sections, TMXB_OBJECTS, w.objects);
+	add_section(sections, TMXB_POINTS, w.points);
+	add_section(sections, TMXB_TEXTS, w.texts);
+	add_section(sections, TMXB_CHUNKS, w.chunks);
+	add_section(sections, TMXB_DEPENDENCIES, dep_refs);
+
+	size_t size = sizeof(tmxb_header) + sections.size() * sizeof(tmxb_section);
+	for (size_t i = 0; i < sections.size(); i++) {
+		size = (size + 7) & ~(size_t)7;
+		sections[i].offset = (uint32_t)size;
+		size += (size_t)sections[i].count * sections[i].record_size;
+	}
+
+	char *buf = (char*)tmx_alloc_func(NULL, size);
+	if (!buf) {
+		tmx_errno = E_ALLOC;
+		return NULL;
+	}
+	memset(buf, 0, size);
+
+	tmxb_header header;
+	header.magic = TMXB_MAGIC;
+	header.version = TMXB_VERSION;
+	header.header_size = sizeof(tmxb_header);
+	header.section_count = (uint32_t)sections.size();
+	memcpy(buf, &header, sizeof(header));
+	memcpy(buf + sizeof(header), sections.data(), sections.size() * sizeof(tmxb_section));
+
+	copy_section(buf, sections[0], w.strings);
+	copy_section(buf, sections[1], w.props);
+	copy_section(buf, sections[2], map_rec);
+	copy_section(buf, sections[3], w.images);
+	copy_section(buf, sections[4], w.tilesets);
+	copy_section(buf, sections[5], w.tiles);
+	copy_section(buf, sections[6], w.frames);
+	copy_section(buf, sections[7], w.layers);
+	copy_section(buf, sections[8], w.gids);
+	copy_section(buf, sections[9], w.objects);
+	copy_section(buf, sections[10], w.points);
+	copy_section(buf, sections[11], w.texts);
+	copy_section(buf, sections[12], w.chunks);
+	copy_section(buf, sections[13], dep_refs);
+
+	*len = (int)size;
+	return buf;
+}
+
+/*
+	Reader
+*/
+
+typedef struct {
+	const char *buf;
+	size_t len;
+	tmxb_section sections[TMXB_SECTION_MAX]; /* indexed by id, count is 0 for missing ones */
+} tmxb_reader;
+
+/* copies record i of a section into out, zero filling fields the file doesn't have */
+static int read_record(const tmxb_reader *r, int id, int64_t i, void *out, size_t out_size) {
+	const tmxb_section *s = &r->sections[id];
+	if (i < 0 || i >= s->count) {
+		tmx_err(E_UNKN, "binary parser: record %lld out of range in section %d", (long long)i, id);
+		return 0;
+	}
+
+	size_t n = s->record_size < out_size ? s->record_size : out_size;
+	memcpy(out, r->buf + s->offset + (size_t)i * s->record_size, n);
+	memset((char*)out + n, 0, out_size - n);
+	return 1;
+}
+
+static int check_range(const tmxb_reader *r, int id, int64_t start, int64_t count) {
+	if (start < 0 || count < 0 || start + count > r->sections[id].count) {
+		tmx_err(E_UNKN, "binary parser: range %lld+%lld out of bounds in section %d", (long long)start, (long long)count, id);
+		return 0;
+	}
+	return 1;
+}
+
+/* returns 1 and sets *out to a copy of the string, or NULL for a 0 reference */
+static int read_string(const tmxb_reader *r, int32_t ref, char **out) {
+	*out = NULL;
+	if (ref == 0) {
+		return 1;
+	}
+
+	if (ref < 0 || (uint32_t)ref > r->sections[TMXB_STRINGS].count) {
+		tmx_err(E_UNKN, "binary parser: bad string reference %d", ref);
+		return 0;
+	}
+
+	*out = tmx_strdup(r->buf + r->sections[TMXB_STRINGS].offset + ref - 1);
+	return *out != NULL;
+}
+
+static int read_properties(const tmxb_reader *r, int32_t start, int32_t count, tmx_properties **out) {
+	if (count == 0) {
+		return 1;
+	}
+
+	if (!check_range(r, TMXB_PROPS, start, count)) {
+		return 0;
+	}
+
+	if (!(*out = (tmx_properties*)mk_hashtable(count))) {
+		return 0;
+	}
+
+	for (int32_t i = start; i < start + count; i++) {
+		tmxb_prop rec;
+		read_record(r, TMXB_PROPS, i, &rec, sizeof(rec));
+
+		if (rec.type < PT_NONE || rec.type > PT_FILE) {
+			tmx_err(E_UNKN, "binary parser: unknown property type %d", rec.type);
+			return 0;
+		}
+
+		tmx_property *prop = alloc_prop();
+		if (!prop) {
+			return 0;
+		}
+
+		prop->type = (enum tmx_property_type)rec.type;
+		int ok = read_string(r, rec.name, &prop->name);
+		switch (prop->type) {
+		case PT_INT: prop->value.integer = rec.value; break;
+		case PT_BOOL: prop->value.boolean = rec.value; break;
+		case PT_COLOR: prop->value.color = (unsigned int)rec.value; break;
+		case PT_FLOAT: prop->value.decimal = rec.decimal; break;
+		default: ok = ok && read_string(r, rec.value, &prop->value.string); break;
+		}
+
+		if (!ok || prop->name == NULL) {
+			free_property(prop);
+			return 0;
+		}
+
+		hashtable_set((void*)*out, prop->name, (void*)prop, property_deallocator);
+	}
+
+	return 1;
+}
+
+static int read_image(const tmxb_reader *r, int32_t ref, tmx_image **out) {
+	if (ref == 0) {
+		return 1;
+	}
+
+	tmxb_image rec;
+	if (!read_record(r, TMXB_IMAGES, (int64_t)ref - 1, &rec, sizeof(rec))) {
+		return 0;
+	}
+
+	tmx_image *img = alloc_image();
+	if (!img) {
+		return 0;
+	}
+	*out = img;
+
+	img->trans = rec.trans;
+	img->uses_trans = rec.uses_trans;
+	img->width = rec.width;
+	img->height = rec.height;
+
+	if (!read_string(r, rec.source, &img->source) || img->source == NULL) {
+		return 0;
+	}
+
+	if (!load_image(&img->resource_image, NULL, img->source)) {
+		tmx_err(E_UNKN, "binary parser: an error occured in the delegated image loading function");
+		return 0;
+	}
+
+	return 1;
+}
+
+/* reads count objects starting at start, keeping their order */
+static int read_objects(const tmxb_reader *r, int32_t start, int32_t count, tmx_object **head) {
+	if (!check_range(r, TMXB_OBJECTS, start, count)) {
+		return 0;
+	}
+
+	tmx_object **next = head;
+	for (int32_t i = start; i < start + count; i++) {
+		tmxb_object rec;
+		read_record(r, TMXB_OBJECTS, i, &rec, sizeof(rec));
+		if (rec.obj_type < OT_NONE || rec.obj_type > OT_TEXT) {
+			tmx_err(E_UNKN, "binary parser: unknown object type %d", rec.obj_type);
+			return 0;
+		}
+
+		tmx_object *obj = alloc_object();
+		if (!obj) {
+			return 0;
+		}
+		*next = obj;
+		next = &obj->next;
+
+		obj->id = rec.id;
+		obj->obj_type = (enum tmx_obj_type)rec.obj_type;
+		obj->x = rec.x;
+		obj->y = rec.y;
+		obj->width = rec.width;
+		obj->height = rec.height;
+		obj->rotation = rec.rotation;
+		obj->visible = rec.visible;
+
+		if (!read_string(r, rec.name, &obj->name) || !read_string(r, rec.type, &obj->type)) {
+			return 0;
+		}
+
+		if (!read_properties(r, rec.prop_start, rec.prop_count, &obj->properties)) {
+			return 0;
+		}
+
+		if (obj->obj_type == OT_TILE) {
+			obj->content.gid = rec.content;
+		}
+		else if ((obj->obj_type == OT_POLYGON || obj->obj_type == OT_POLYLINE) && rec.point_count > 0) {
+			if (!check_range(r, TMXB_POINTS, (int64_t)rec.content * 2, (int64_t)rec.point_count * 2)) {
+				return 0;
+			}
+
+			tmx_shape *shape = alloc_shape();
+			if (!shape) {
+				return 0;
+			}
+			obj->content.shape = shape;
+
+			shape->points = (double**)tmx_alloc_func(NULL, rec.point_count * sizeof(double*));
+			if (!shape->points) {
+				tmx_errno = E_ALLOC;
+				return 0;
+			}
+
+			shape->points[0] = (double*)tmx_alloc_func(NULL, rec.point_count * 2 * sizeof(double));
+			if (!shape->points[0]) {
+				tmx_free_func(shape->points);
+				shape->points = NULL;
+				tmx_errno = E_ALLOC;
+				return 0;
+			}
+
+			shape->points_len = rec.point_count;
+			memcpy(shape->points[0], r->buf + r->sections[TMXB_POINTS].offset + (size_t)rec.content * 2 * sizeof(double), rec.point_count * 2 * sizeof(double));
+			for (int p = 1; p < rec.point_count; p++) {
+				shape->points[p] = shape->points[0] + (p * 2);
+			}
+		}
+		else if (obj->obj_type == OT_TEXT && rec.content != 0) {
+			tmxb_text trec;
+			if (!read_record(r, TMXB_TEXTS, (int64_t)rec.content - 1, &trec, sizeof(trec))) {
+				return 0;
+			}
+
+			tmx_text *text = alloc_text();
+			if (!text) {
+				return 0;
+			}
+			obj->content.text = text;
+
+			text->pixelsize = trec.pixelsize;
+			text->color = trec.color;
+			text->wrap = trec.wrap;
+			text->bold = trec.bold;
+			text->italic = trec.italic;
+			text->underline = trec.underline;
+			text->strikeout = trec.strikeout;
+			text->kerning = trec.kerning;
+			text->halign = (enum tmx_horizontal_align)trec.halign;
+			text->valign = (enum tmx_vertical_align)trec.valign;
+
+			if (!read_string(r, trec.fontfamily, &text->fontfamily) || !read_string(r, trec.text, &text->text)) {
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+static int read_tileset(const tmxb_reader *r, int32_t i, tmx_tileset_list *tsl) {
+	tmxb_tileset rec;
+	read_record(r, TMXB_TILESETS, i, &rec, sizeof(rec));
+
+	tmx_tileset *ts = tsl->tileset;
+	ts->is_embedded = 1;
+	tsl->firstgid = rec.firstgid;
+
+	ts->tile_width = rec.tile_width;
+	ts->tile_height = rec.tile_height;
+	ts->spacing = rec.spacing;
+	ts->margin = rec.margin;
+	ts->x_offset = rec.x_offset;
+	ts->y_offset = rec.y_offset;
+
+	if (!read_string(r, rec.name, &ts->name) || !read_properties(r, rec.prop_start, rec.prop_count, &ts->properties)) {
+		return 0;
+	}
+
+	if (rec.tilecount == 0 || rec.tilecount > INT32_MAX / sizeof(tmx_tile) || !(ts->tiles = alloc_tiles(rec.tilecount))) {
+		tmx_err(E_UNKN, "binary parser: couldn't allocate %u tiles", rec.tilecount);
+		return 0;
+	}
+	ts->tilecount = rec.tilecount;
+
+	if (!read_image(r, rec.image, &ts->image) || !check_range(r, TMXB_TILES, rec.tile_start, rec.tile_count)) {
+		return 0;
+	}
+
+	/* tiles that weren't written have nothing set and an id matching their index */
+	for (unsigned int t = 0; t < ts->tilecount; t++) {
+		ts->tiles[t].id = t;
+	}
+
+	for (int32_t t = rec.tile_start; t < rec.tile_start + rec.tile_count; t++) {
+		tmxb_tile trec;
+		read_record(r, TMXB_TILES, t, &trec, sizeof(trec));
+		if (trec.index >= ts->tilecount || ts->tiles[trec.index].tileset != NULL) {
+			tmx_err(E_UNKN, "binary parser: bad tile %u in tileset '%s'", trec.index, ts->name);
+			return 0;
+		}
+
+		tmx_tile *tile = &ts->tiles[trec.index];
+		tile->id = trec.id;
+		tile->tileset = ts;
+
+		if (!read_string(r, trec.type, &tile->type) || !read_image(r, trec.image, &tile->image)) {
+			return 0;
+		}
+
+		if (!read_properties(r, trec.prop_start, trec.prop_count, &tile->properties)) {
+			return 0;
+		}
+
+		if (trec.frame_count > 0) {
+			if (!check_range(r, TMXB_FRAMES, trec.frame_start, trec.frame_count)) {
+				return 0;
+			}
+
+			tile->animation = (tmx_anim_frame*)tmx_alloc_func(NULL, trec.frame_count * sizeof(tmx_anim_frame));
+			if (!tile->animation) {
+				tmx_errno = E_ALLOC;
+				return 0;
+			}
+			tile->animation_len = trec.frame_count;
+
+			for (int32_t f = 0; f < trec.frame_count; f++) {
+				tmxb_frame frec;
+				read_record(r, TMXB_FRAMES, trec.frame_start + f, &frec, sizeof(frec));
+				tile->animation[f].tile_id = frec.tile_id;
+				tile->animation[f].duration = frec.duration;
+			}
+		}
+
+		if (trec.collision_count > 0 && !read_objects(r, trec.collision_start, trec.collision_count, &tile->collision)) {
+			return 0;
+		}
+	}
+
+	/* mk_map_tile_array indexes map->tiles with these ids, image tilesets have one per tile and
+	   collections are sorted */
+	for (unsigned int t = 0; t < ts->tilecount; t++) {
+		unsigned int id = ts->tiles[t].id;
+		if (ts->image ? id != t : (t > 0 && id <= ts->tiles[t - 1].id)) {
+			tmx_err(E_UNKN, "binary parser: bad tile ids in tileset '%s'", ts->name);
+			return 0;
+		}
+	}
+
+	if (ts->image) {
+		/* same math set_tiles_runtime_props divides by */
+		unsigned int ts_w = ts->image->width - 2 * ts->margin + ts->spacing;
+		if (ts->tile_width + ts->spacing == 0 || ts_w / (ts->tile_width + ts->spacing) == 0) {
+			tmx_err(E_UNKN, "binary parser: tileset '%s' has no columns", ts->name);
+			return 0;
+		}
+
+		if (!set_tiles_runtime_props(ts)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* each tileset's gids have to fit in the tile array mk_map_tile_array makes */
+static int check_tileset_ranges(tmx_map *map) {
+	tmx_tileset_list *last = map->ts_head;
+	for (tmx_tileset_list *tsl = map->ts_head; tsl != NULL; tsl = tsl->next) {
+		if (tsl->firstgid > last->firstgid) {
+			last = tsl;
+		}
+	}
+
+	for (tmx_tileset_list *tsl = map->ts_head; tsl != NULL; tsl = tsl->next) {
+		tmx_tileset *ts = tsl->tileset;
+		uint64_t end = (uint64_t)tsl->firstgid + ts->tiles[ts->tilecount - 1].id + 1;
+		uint64_t last_end = (uint64_t)last->firstgid + (last->tileset->image ? last->tileset->tilecount : last->tileset->tiles[last->tileset->tilecount - 1].id + 1);
+		if (tsl->firstgid == 0 || end > last_end || last_end > INT32_MAX) {
+			tmx_err(E_UNKN, "binary parser: tileset '%s' has bad gids", ts->name);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int read_chunks(const tmxb_reader *r, int32_t start, int32_t count, tmx_layer *layer) {
+	if (count == 0) {
+		return 1;
+	}
+
+	if (!check_range(r, TMXB_CHUNKS, start, count) || !(layer->chunks = alloc_chunks(count))) {
+		return 0;
+	}
+	layer->chunk_count = count;
+
+	for (int32_t i = 0; i < count; i++) {
+		tmxb_chunk rec;
+		read_record(r, TMXB_CHUNKS, start + i, &rec, sizeof(rec));
+		if (rec.encoding != CE_CSV && rec.encoding != CE_BASE64) {
+			tmx_err(E_UNKN, "binary parser: unknown chunk encoding %d", rec.encoding);
+			return 0;
+		}
+
+		tmx_chunk *chunk = &layer->chunks[i];
+		chunk->x = rec.x;
+		chunk->y = rec.y;
+		chunk->width = rec.width;
+		chunk->height = rec.height;
+		chunk->encoding = (enum tmx_chunk_encoding)rec.encoding;
+		if (chunk->width == 0 || chunk->height == 0 || !read_string(r, rec.data, &chunk->data) || chunk->data == NULL) {
+			tmx_err(E_UNKN, "binary parser: bad chunk at %d,%d in layer '%s'", rec.x, rec.y, layer->name);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int read_layers(const tmxb_reader *r, tmx_map *map) {
+	uint32_t count = r->sections[TMXB_LAYERS].count;
+	tmx_layer **layers = (tmx_layer**)tmx_alloc_func(NULL, (count > 0 ? count : 1) * sizeof(tmx_layer*));
+	if (!layers) {
+		tmx_errno = E_ALLOC;
+		return 0;
+	}
+
+	int ok = 1;
+	for (uint32_t i = 0; ok && i < count; i++) {
+		tmxb_layer rec;
+		read_record(r, TMXB_LAYERS, i, &rec, sizeof(rec));
+		if (rec.type < L_NONE || rec.type > L_GROUP) {
+			tmx_err(E_UNKN, "binary parser: unknown layer type %d", rec.type);
+			ok = 0;
+			break;
+		}
+
+		/* groups always come before their layers */
+		tmx_layer **next = &map->ly_head;
+		if (rec.parent != 0) {
+			if (rec.parent < 0 || (uint32_t)rec.parent > i || layers[rec.parent - 1]->type != L_GROUP) {
+				tmx_err(E_UNKN, "binary parser: bad parent for layer %u", i);
+				ok = 0;
+				break;
+			}
+			next = &layers[rec.parent - 1]->content.group_head;
+		}
+		while (*next) {
+			next = &(*next)->next;
+		}
+
+		tmx_layer *layer = alloc_layer();
+		if (!layer) {
+			ok = 0;
+			break;
+		}
+		*next = layer;
+		layers[i] = layer;
+
+		layer->type = (enum tmx_layer_type)rec.type;
+		layer->opacity = rec.opacity;
+		layer->visible = rec.visible;
+		layer->offsetx = rec.offsetx;
+		layer->offsety = rec.offsety;
+
+		ok = read_string(r, rec.name, &layer->name) && read_properties(r, rec.prop_start, rec.prop_count, &layer->properties);
+		if (!ok) {
+			break;
+		}
+
+		if (layer->type == L_LAYER && map->infinite) {
+			ok = read_chunks(r, rec.chunk_start, rec.chunk_count, layer);
+		}
+		else if (layer->type == L_LAYER) {
+			int64_t cells = (int64_t)map->width * map->height;
+			if (rec.content_count != cells || !check_range(r, TMXB_GIDS, rec.content_start, cells)) {
+				tmx_err(E_UNKN, "binary parser: layer '%s' doesn't have %lld gids", layer->name, (long long)cells);
+				ok = 0;
+				break;
+			}
+
+			layer->content.gids = (int32_t*)tmx_alloc_func(NULL, cells * sizeof(int32_t));
+			if (!layer->content.gids) {
+				tmx_errno = E_ALLOC;
+				ok = 0;
+				break;
+			}
+			memcpy(layer->content.gids, r->buf + r->sections[TMXB_GIDS].offset + (size_t)rec.content_start * sizeof(int32_t), cells * sizeof(int32_t));
+		}
+		else if (layer->type == L_OBJGR) {
+			tmx_object_group *objgr = alloc_objgr();
+			if (!objgr) {
+				ok = 0;
+				break;
+			}
+			layer->content.objgr = objgr;
+			objgr->color = rec.color;
+			objgr->draworder = (enum tmx_objgr_draworder)rec.draworder;
+			ok = read_objects(r, rec.content_start, rec.content_count, &objgr->head);
+		}
+		else if (layer->type == L_IMAGE) {
+			ok = read_image(r, rec.content_start, &layer->content.image);
+		}
+	}
+
+	tmx_free_func(layers);
+	return ok;
+}
+
+int tmx_is_binary(const void *buffer, int len) {
+	uint32_t magic;
+	if (buffer == NULL || len < (int)sizeof(magic)) {
+		return 0;
+	}
+
+	memcpy(&magic, buffer, sizeof(magic));
+	return magic == TMXB_MAGIC;
+}
+
+/* fills in the section table, returns 0 and sets tmx_errno if the file is corrupt */
+static int read_header(tmxb_reader *r, const void *buffer, int len) {
+	if (!tmx_is_binary(buffer, len) || len < (int)sizeof(tmxb_header)) {
+		tmx_errno = E_FORMAT;
+		return 0;
+	}
+
+	memset(r, 0, sizeof(*r));
+	r->buf = (const char*)buffer;
+	r->len = (size_t)len;
+
+	tmxb_header header;
+	memcpy(&header, buffer, sizeof(header));
+	if (header.version != TMXB_VERSION) {
+		tmx_err(E_UNKN, "binary parser: unsupported version %u, expected %u", header.version, TMXB_VERSION);
+		return 0;
+	}
+
+	if (header.header_size < sizeof(header) || header.header_size + (size_t)header.section_count * sizeof(tmxb_section) > r->len) {
+		tmx_err(E_UNKN, "binary parser: truncated header");
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < header.section_count; i++) {
+		tmxb_section s;
+		memcpy(&s, r->buf + header.header_size + i * sizeof(tmxb_section), sizeof(s));
+		if (s.id == 0 || s.id >= TMXB_SECTION_MAX) {
+			continue;
+		}
+
+		if ((uint64_t)s.offset + (uint64_t)s.count * s.record_size > r->len) {
+			tmx_err(E_UNKN, "binary parser: section %u runs past the end of the file", s.id);
+			return 0;
+		}
+		r->sections[s.id] = s;
+	}
+
+	/* strings have to end in a terminator for read_string to be safe */
+	const tmxb_section *strings = &r->sections[TMXB_STRINGS];
+	if (strings->count > 0 && (strings->record_size != 1 || r->buf[strings->offset + strings->count - 1] != '\0')) {
+		tmx_err(E_UNKN, "binary parser: corrupted string table");
+		return 0;
+	}
+
+	return 1;
+}
+
+int tmx_binary_dependencies(const void *buffer, int len, tmx_dep_functor callback, void *userdata) {
+	tmxb_reader r;
+	if (!read_header(&r, buffer, len)) {
+		return -1;
+	}
+
+	const tmxb_section *strings = &r.sections[TMXB_STRINGS];
+	for (uint32_t i = 0; i < r.sections[TMXB_DEPENDENCIES].count; i++) {
+		int32_t ref;
+		read_record(&r, TMXB_DEPENDENCIES, i, &ref, sizeof(ref));
+		if (ref <= 0 || (uint32_t)ref > strings->count) {
+			tmx_err(E_UNKN, "binary parser: bad string reference %d", ref);
+			return -1;
+		}
+
+		if (callback) {
+			callback(r.buf + strings->offset + ref - 1, userdata);
+		}
+	}
+
+	return (int)r.sections[TMXB_DEPENDENCIES].count;
+}
+
+tmx_map* tmx_load_binary(const void *buffer, int len) {
+	set_alloc_functions();
+
+	tmxb_reader r;
+	if (!read_header(&r, buffer, len)) {
+		return NULL;
+	}
+
+	tmxb_map rec;
+	if (!read_record(&r, TMXB_MAP, 0, &rec, sizeof(rec))) {
+		return NULL;
+	}
+
+	tmx_map *map = alloc_map();
+	if (!map) {
+		return NULL;
+	}
+
+	map->orient = (enum tmx_map_orient)rec.orient;
+	map->width = rec.width;
+	map->height = rec.height;
+	map->tile_width = rec.tile_width;
+	map->tile_height = rec.tile_height;
+	map->stagger_index = (enum tmx_stagger_index)rec.stagger_index;
+	map->stagger_axis = (enum tmx_stagger_axis)rec.stagger_axis;
+	map->hexsidelength = rec.hexsidelength;
+	map->backgroundcolor = rec.backgroundcolor;
+	map->renderorder = (enum tmx_map_renderorder)rec.renderorder;
+	map->infinite = rec.infinite != 0;
+
+	int ok = read_properties(&r, rec.prop_start, rec.prop_count, &map->properties);
+
+	/* keep the tileset list in the same order it was written */
+	tmx_tileset_list **next = &map->ts_head;
+	for (uint32_t i = 0; ok && i < r.sections[TMXB_TILESETS].count; i++) {
+		/* free_ts_list expects every entry to have a tileset */
+		tmx_tileset_list *tsl = alloc_tileset_list();
+		tmx_tileset *ts = tsl ? alloc_tileset() : NULL;
+		if (!ts) {
+			tmx_free_func(tsl);
+			ok = 0;
+			break;
+		}
+		tsl->tileset = ts;
+		*next = tsl;
+		next = &tsl->next;
+
+		ok = read_tileset(&r, (int32_t)i, tsl);
+	}
+
+	ok = ok && check_tileset_ranges(map) && read_layers(&r, map);
+
+	if (!ok) {
+		tmx_map_free(map);
+		return NULL;
+	}
+
+	map_post_parsing(&map);
+	return map;
+}
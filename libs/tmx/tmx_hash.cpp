@@ -1,6 +1,6 @@
 #include <assert.h>
-#include <map>
-#include <string>
+#include <stdint.h>
+#include <string.h>
 
 extern "C" {
 #include "tmx.h"
@@ -8,46 +8,254 @@ extern "C" {
 #include "tmx_utils.h"
 }
 
+/*
+	Open addressing hashtable, used for properties and the tileset manager.
+	Entries are kept in insertion order in a dense array, the slot table only holds indices into it.
+	Keys are copied into an arena that lives as long as the table, so entries just point at them.
+*/
 
-typedef std::map<std::string, void *> tmx_hash;
+#define HASH_EMPTY -1
+#define HASH_REMOVED -2
+#define HASH_ARENA_BLOCK 1024
+
+typedef struct {
+	const char *key; /* NULL once removed */
+	size_t len;
+	uint32_t hash;
+	void *val;
+} tmx_hash_entry;
+
+typedef struct _tmx_hash_block {
+	struct _tmx_hash_block *next;
+	size_t used, size;
+	/* keys follow */
+} tmx_hash_block;
+
+typedef struct {
+	tmx_hash_entry *entries;
+	int count, capacity; /* count includes removed entries, they're dropped when the table grows */
+	int live;
+
+	int32_t *slots; /* power of 2 size, HASH_EMPTY, HASH_REMOVED or an index into entries */
+	int slot_count;
+
+	tmx_hash_block *keys;
+} tmx_hash;
+
+static uint32_t hash_key(const char *key, size_t len) {
+	/* FNV-1a */
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		h ^= (uint8_t)key[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static const char* arena_copy(tmx_hash *h, const char *key, size_t len) {
+	tmx_hash_block *block = h->keys;
+	if (block == NULL || block->used + len + 1 > block->size) {
+		size_t size = len + 1 > HASH_ARENA_BLOCK ? len + 1 : HASH_ARENA_BLOCK;
+		block = (tmx_hash_block*)tmx_alloc_func(NULL, sizeof(tmx_hash_block) + size);
+		if (!block) {
+			return NULL;
+		}
+		block->next = h->keys;
+		block->used = 0;
+		block->size = size;
+		h->keys = block;
+	}
+
+	char *dst = (char*)(block + 1) + block->used;
+	memcpy(dst, key, len + 1);
+	block->used += len + 1;
+	return dst;
+}
+
+/* returns the slot holding key, or -1 if it isn't in the table */
+static int find_slot(const tmx_hash *h, const char *key, size_t len, uint32_t hash) {
+	uint32_t mask = (uint32_t)h->slot_count - 1;
+	for (uint32_t i = hash & mask; ; i = (i + 1) & mask) {
+		int32_t idx = h->slots[i];
+		if (idx == HASH_EMPTY) {
+			return -1;
+		}
+
+		if (idx >= 0) {
+			const tmx_hash_entry *e = &h->entries[idx];
+			if (e->hash == hash && e->len == len && memcmp(e->key, key, len) == 0) {
+				return (int)i;
+			}
+		}
+	}
+}
+
+/* rebuilds the slots, and drops removed entries from the entry array */
+static int rehash(tmx_hash *h, int slot_count) {
+	int32_t *slots = (int32_t*)tmx_alloc_func(NULL, sizeof(int32_t) * slot_count);
+	if (!slots) {
+		return 0;
+	}
+	memset(slots, 0xFF, sizeof(int32_t) * slot_count); /* HASH_EMPTY */
+
+	int live = 0;
+	uint32_t mask = (uint32_t)slot_count - 1;
+	for (int i = 0; i < h->count; i++) {
+		if (h->entries[i].key == NULL) {
+			continue;
+		}
+
+		h->entries[live] = h->entries[i];
+		uint32_t s = h->entries[live].hash & mask;
+		while (slots[s] != HASH_EMPTY) {
+			s = (s + 1) & mask;
+		}
+		slots[s] = live++;
+	}
+
+	tmx_free_func(h->slots);
+	h->slots = slots;
+	h->slot_count = slot_count;
+	h->count = live;
+	return 1;
+}
 
 void* mk_hashtable(unsigned int initial_size) {
-	return new tmx_hash();
+	set_alloc_functions();
+
+	tmx_hash *h = (tmx_hash*)tmx_alloc_func(NULL, sizeof(tmx_hash));
+	if (!h) {
+		return NULL;
+	}
+	memset(h, 0, sizeof(tmx_hash));
+
+	int slot_count = 8;
+	while ((unsigned int)slot_count < initial_size * 2) {
+		slot_count *= 2;
+	}
+
+	if (!rehash(h, slot_count)) {
+		tmx_free_func(h);
+		return NULL;
+	}
+
+	return h;
 }
 
 void hashtable_set(void *hashtable, const char *key, void *val, hashtable_entry_deallocator deallocator) {
-	assert(deallocator == NULL);
-	tmx_hash &map = *((tmx_hash*)hashtable);
-	std::string strKey = key;
-	map[strKey] = val;
+	tmx_hash *h = (tmx_hash*)hashtable;
+	size_t len = strlen(key);
+	uint32_t hash = hash_key(key, len);
+
+	int slot = find_slot(h, key, len, hash);
+	if (slot >= 0) {
+		tmx_hash_entry *e = &h->entries[h->slots[slot]];
+		if (deallocator && e->val != val) {
+			deallocator(e->val, e->key);
+		}
+		e->val = val;
+		return;
+	}
+
+	/* keep the slots under 3/4 full, counting removed ones since they still take up a slot */
+	if ((h->count + 1) * 4 > h->slot_count * 3) {
+		int slot_count = (h->live + 1) * 4 > h->slot_count * 2 ? h->slot_count * 2 : h->slot_count;
+		if (!rehash(h, slot_count)) {
+			assert(false); return;
+		}
+	}
+
+	if (h->count == h->capacity) {
+		int capacity = h->capacity ? h->capacity * 2 : 8;
+		tmx_hash_entry *entries = (tmx_hash_entry*)tmx_alloc_func(h->entries, sizeof(tmx_hash_entry) * capacity);
+		if (!entries) {
+			assert(false); return;
+		}
+		h->entries = entries;
+		h->capacity = capacity;
+	}
+
+	tmx_hash_entry *e = &h->entries[h->count];
+	e->key = arena_copy(h, key, len);
+	if (!e->key) {
+		assert(false); return;
+	}
+	e->len = len;
+	e->hash = hash;
+	e->val = val;
+
+	uint32_t mask = (uint32_t)h->slot_count - 1;
+	uint32_t s = hash & mask;
+	while (h->slots[s] >= 0) {
+		s = (s + 1) & mask;
+	}
+	h->slots[s] = h->count++;
+	h->live++;
 }
 
 void* hashtable_get(void *hashtable, const char *key) {
-	tmx_hash map = *((tmx_hash*)hashtable);
-	std::string strKey = key;
-	return map.at(strKey);
+	tmx_hash *h = (tmx_hash*)hashtable;
+	size_t len = strlen(key);
+	int slot = find_slot(h, key, len, hash_key(key, len));
+	return slot >= 0 ? h->entries[h->slots[slot]].val : NULL;
 }
 
 void hashtable_rm(void *hashtable, const char *key, hashtable_entry_deallocator deallocator) {
-	tmx_hash map = *((tmx_hash*)hashtable);
-	std::string strKey = key;
-	map.erase(strKey);
+	tmx_hash *h = (tmx_hash*)hashtable;
+	size_t len = strlen(key);
+	int slot = find_slot(h, key, len, hash_key(key, len));
+	if (slot < 0) {
+		return;
+	}
+
+	tmx_hash_entry *e = &h->entries[h->slots[slot]];
+	if (deallocator) {
+		deallocator(e->val, e->key);
+	}
+
+	/* the key stays in the arena until the table is freed */
+	e->key = NULL;
+	e->val = NULL;
+	h->slots[slot] = HASH_REMOVED;
+	h->live--;
 }
 
 void free_hashtable(void *hashtable, hashtable_entry_deallocator deallocator) {
-	tmx_hash* map = (tmx_hash*)hashtable;
-	delete map;
+	tmx_hash *h = (tmx_hash*)hashtable;
+	if (h == NULL) {
+		return;
+	}
+
+	if (deallocator) {
+		for (int i = 0; i < h->count; i++) {
+			if (h->entries[i].key) {
+				deallocator(h->entries[i].val, h->entries[i].key);
+			}
+		}
+	}
+
+	tmx_hash_block *block = h->keys;
+	while (block) {
+		tmx_hash_block *next = block->next;
+		tmx_free_func(block);
+		block = next;
+	}
+
+	tmx_free_func(h->entries);
+	tmx_free_func(h->slots);
+	tmx_free_func(h);
 }
 
 void hashtable_foreach(void *hashtable, hashtable_foreach_functor functor, void *userdata) {
-	if (hashtable == nullptr) {
+	tmx_hash *h = (tmx_hash*)hashtable;
+	if (h == NULL) {
 		return;
 	}
 
-	tmx_hash* map = (tmx_hash*)hashtable;
-
-	for (auto item = map->begin(); item != map->end(); ++item) {
-		functor(item->second, userdata, item->first.c_str());
+	for (int i = 0; i < h->count; i++) {
+		if (h->entries[i].key) {
+			functor(h->entries[i].val, userdata, h->entries[i].key);
+		}
 	}
 }
 
@@ -73,6 +73,10 @@ tmx_layer* alloc_layer(void) {
 	return res;
 }
 
+tmx_chunk* alloc_chunks(int count) {
+	return (tmx_chunk*)node_alloc(count * sizeof(tmx_chunk));
+}
+
 tmx_tile* alloc_tiles(int count) {
 	return (tmx_tile*)node_alloc(count * sizeof(tmx_tile));
 }
@@ -156,6 +160,7 @@ void free_layers(tmx_layer *l) {
 		tmx_free_func(l->name);
 		if (l->type == L_LAYER) {
 			tmx_free_func(l->content.gids);
+			free_chunks(l->chunks, l->chunk_count);
 		}
 		else if (l->type == L_OBJGR) {
 			free_objgr(l->content.objgr);
@@ -171,6 +176,17 @@ void free_layers(tmx_layer *l) {
 	}
 }
 
+void free_chunks(tmx_chunk *c, int count) {
+	int i;
+	if (c) {
+		for (i=0; i<count; i++) {
+			tmx_free_func(c[i].data);
+			tmx_free_func(c[i].gids);
+		}
+		tmx_free_func(c);
+	}
+}
+
 void free_tiles(tmx_tile *t, int tilecount) {
 	int i;
 	if (t) {
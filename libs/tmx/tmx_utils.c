@@ -94,7 +94,7 @@ char* b64_decode(const char *source, unsigned int *rlength) { /* NULL terminated
 		return NULL;
 	}
 
-	if (src_len%4) {
+	if (src_len == 0 || src_len%4) {
 		tmx_err(E_BDATA, "Base64: invalid source");
 		return NULL; /* invalid source */
 	}
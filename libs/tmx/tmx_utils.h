@@ -40,6 +40,7 @@ tmx_text*         alloc_text(void);
 tmx_object*       alloc_object(void);
 tmx_object_group* alloc_objgr(void);
 tmx_layer*        alloc_layer(void);
+tmx_chunk*        alloc_chunks(int count);
 tmx_tile*         alloc_tiles(int count);
 tmx_tileset*      alloc_tileset(void);
 tmx_tileset_list* alloc_tileset_list(void);
@@ -52,6 +53,7 @@ void free_obj(tmx_object *o);
 void free_objgr(tmx_object_group *o);
 void free_image(tmx_image *i);
 void free_layers(tmx_layer *l);
+void free_chunks(tmx_chunk *c, int count);
 void free_tiles(tmx_tile *t, int tilecount);
 void free_ts(tmx_tileset *ts);
 void free_ts_list(tmx_tileset_list *tsl);
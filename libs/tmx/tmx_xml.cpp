@@ -326,49 +326,112 @@ static int parse_object(XMLElement *ele, tmx_object *obj) {
 	return 1;
 }
 
-static int parse_data(XMLElement *ele, int32_t **gidsadr, size_t gidscount) {
-	const char *value, *inner_xml;
-
-	value = ele->Attribute("encoding");
+/* checks the encoding and compression of a 'data' element, returns CE_NONE if they aren't supported */
+static enum tmx_chunk_encoding parse_data_encoding(XMLElement *ele) {
+	const char *value = ele->Attribute("encoding");
 	if (!value) { /* encoding */
 		tmx_err(E_MISSEL, "xml parser: missing 'encoding' attribute in the 'data' element");
-		assert(false); return 0;
-	}
-
-	inner_xml = ele->GetText();
-	if (!value) {
-		tmx_err(E_XDATA, "xml parser: missing content in the 'data' element");
-		assert(false); return 0;
+		return CE_NONE;
 	}
 
 	if (!strcmp(value, "base64")) {
 		auto compression = ele->Attribute("compression");
 		if (!compression) { /* compression */
 			tmx_err(E_MISSEL, "xml parser: missing 'compression' attribute in the 'data' element");
-			assert(false); return 0;
+			return CE_NONE;
 		}
 		if (strcmp(compression, "zlib") && strcmp(compression, "gzip")) {
-			tmx_err(E_ENCCMP, "xml parser: unsupported data compression: '%s'", value); /* unsupported compression */
-			assert(false); return 0;
+			tmx_err(E_ENCCMP, "xml parser: unsupported data compression: '%s'", compression); /* unsupported compression */
+			return CE_NONE;
 		}
-		if (!data_decode(inner_xml, B64Z, gidscount, gidsadr)) {
-			assert(false); return 0;
-		};
-
+		return CE_BASE64;
 	}
 	else if (!strcmp(value, "xml")) {
 		tmx_err(E_ENCCMP, "xml parser: unimplemented data encoding: XML");
-		assert(false); return 0;
+		return CE_NONE;
 	}
 	else if (!strcmp(value, "csv")) {
-		if (!data_decode(inner_xml, CSV, gidscount, gidsadr)) {
-			assert(false); return 0;
-		}
+		return CE_CSV;
 	}
-	else {
-		tmx_err(E_ENCCMP, "xml parser: unknown data encoding: %s", value);
+
+	tmx_err(E_ENCCMP, "xml parser: unknown data encoding: %s", value);
+	return CE_NONE;
+}
+
+static int parse_data(XMLElement *ele, int32_t **gidsadr, size_t gidscount) {
+	enum tmx_chunk_encoding encoding = parse_data_encoding(ele);
+	if (encoding == CE_NONE) {
+		assert(false); return 0;
+	}
+
+	const char *inner_xml = ele->GetText();
+	if (!inner_xml) {
+		tmx_err(E_XDATA, "xml parser: missing content in the 'data' element");
+		assert(false); return 0;
+	}
+
+	if (!data_decode(inner_xml, encoding == CE_CSV ? CSV : B64Z, gidscount, gidsadr)) {
+		assert(false); return 0;
+	}
+
+	return 1;
+}
+
+/* the 'data' element of an infinite map's layer, chunks keep their text and are decoded when
+   tmx_chunk_decode is called on them */
+static int parse_chunks(XMLElement *ele, tmx_layer *layer) {
+	enum tmx_chunk_encoding encoding = parse_data_encoding(ele);
+	if (encoding == CE_NONE) {
+		assert(false); return 0;
+	}
+
+	int count = 0;
+	for (auto chunkEle = ele->FirstChildElement("chunk"); chunkEle; chunkEle = chunkEle->NextSiblingElement("chunk")) {
+		count++;
+	}
+
+	if (count == 0) { /* nothing has been drawn on the layer */
+		return 1;
+	}
+
+	if (!(layer->chunks = alloc_chunks(count))) {
 		assert(false); return 0;
 	}
+	layer->chunk_count = count;
+
+	tmx_chunk *chunk = layer->chunks;
+	for (auto chunkEle = ele->FirstChildElement("chunk"); chunkEle; chunkEle = chunkEle->NextSiblingElement("chunk"), chunk++) {
+		const char *x = chunkEle->Attribute("x");
+		const char *y = chunkEle->Attribute("y");
+		const char *w = chunkEle->Attribute("width");
+		const char *h = chunkEle->Attribute("height");
+		if (!x || !y || !w || !h) {
+			tmx_err(E_MISSEL, "xml parser: missing 'x', 'y', 'width' or 'height' attribute in the 'chunk' element");
+			assert(false); return 0;
+		}
+
+		chunk->x = atoi(x);
+		chunk->y = atoi(y);
+		chunk->width = atoi(w) > 0 ? atoi(w) : 0;
+		chunk->height = atoi(h) > 0 ? atoi(h) : 0;
+		chunk->encoding = encoding;
+		if (chunk->width == 0 || chunk->height == 0) {
+			tmx_err(E_XDATA, "xml parser: empty chunk at %d,%d", chunk->x, chunk->y);
+			assert(false); return 0;
+		}
+
+		const char *inner_xml = chunkEle->GetText();
+		if (!inner_xml) {
+			tmx_err(E_XDATA, "xml parser: missing content in the 'chunk' element");
+			assert(false); return 0;
+		}
+
+		if (!(chunk->data = tmx_strdup(inner_xml))) {
+			tmx_errno = E_ALLOC;
+			assert(false); return 0;
+		}
+	}
+
 	return 1;
 }
 
@@ -422,7 +485,7 @@ static int parse_image(XMLElement *ele, tmx_image **img_adr, short strict, const
 	return 1;
 }
 
-static int parse_layer(XMLElement *ele, tmx_layer **layer_headadr, int map_h, int map_w, enum tmx_layer_type type, const char *filename) {
+static int parse_layer(XMLElement *ele, tmx_layer **layer_headadr, const tmx_map *map, enum tmx_layer_type type, const char *filename) {
 	auto res = alloc_layer();
 	if (!res) {
 		assert(false); return 0;
@@ -488,7 +551,12 @@ static int parse_layer(XMLElement *ele, tmx_layer **layer_headadr, int map_h, in
 		enum tmx_layer_type child_type = parse_layer_type(name);
 
 		if (!strcmp(name, "data")) {
-			success = parse_data(layerChild, &(res->content.gids), map_h * map_w);
+			if (map->infinite) {
+				success = parse_chunks(layerChild, res);
+			}
+			else {
+				success = parse_data(layerChild, &(res->content.gids), map->height * map->width);
+			}
 		}
 		else if (!strcmp(name, "image")) {
 			success = parse_image(layerChild, &(res->content.image), 0, filename);
@@ -512,7 +580,7 @@ static int parse_layer(XMLElement *ele, tmx_layer **layer_headadr, int map_h, in
 			success = parse_properties(layerChild, &(res->properties));
 		}
 		else if (type == L_GROUP && child_type != L_NONE) {
-			if (!parse_layer(ele, &(res->content.group_head), map_h, map_w, child_type, filename)) {
+			if (!parse_layer(ele, &(res->content.group_head), map, child_type, filename)) {
 				assert(false); return 0;
 			}
 		}
@@ -533,10 +601,38 @@ static int parse_tileoffset(XMLElement *ele, int *x, int *y) {
 	assert(false); return 0;
 }
 
-/* recursive function that alloc tmx_anim_frames on the stack and then move them to the heap */
-static tmx_anim_frame* parse_animation(XMLElement *ele, int frame_count, unsigned int *length) {
-	assert(false);
-	assert(false); return 0;
+/* parses the 'frame' elements of an 'animation' element */
+static int parse_animation(XMLElement *ele, tmx_anim_frame **frames_adr, unsigned int *length) {
+	unsigned int count = 0;
+	for (auto frameEle = ele->FirstChildElement("frame"); frameEle; frameEle = frameEle->NextSiblingElement("frame")) {
+		count++;
+	}
+
+	if (count == 0) {
+		return 1;
+	}
+
+	auto frames = (tmx_anim_frame*)tmx_alloc_func(NULL, count * sizeof(tmx_anim_frame));
+	if (!frames) {
+		tmx_errno = E_ALLOC;
+		assert(false); return 0;
+	}
+	*frames_adr = frames;
+	*length = count;
+
+	for (auto frameEle = ele->FirstChildElement("frame"); frameEle; frameEle = frameEle->NextSiblingElement("frame"), frames++) {
+		const char *tileid = frameEle->Attribute("tileid");
+		const char *duration = frameEle->Attribute("duration");
+		if (!tileid || !duration) {
+			tmx_err(E_MISSEL, "xml parser: missing 'tileid' or 'duration' attribute in the 'frame' element");
+			assert(false); return 0;
+		}
+
+		frames->tile_id = atoi(tileid);
+		frames->duration = atoi(duration);
+	}
+
+	return 1;
 }
 
 static int parse_tile(XMLElement *ele, tmx_tileset *tileset, const char *filename) {
@@ -562,6 +658,10 @@ static int parse_tile(XMLElement *ele, tmx_tileset *tileset, const char *filenam
 		memmove((tileset->tiles) + (len - to_move + 1), (tileset->tiles) + (len - to_move), to_move * sizeof(tmx_tile));
 	}
 	res = &(tileset->tiles[len - to_move]);
+	if (to_move > 0) {
+		/* the tile that was here moved up, don't free its properties and animation twice */
+		memset(res, 0, sizeof(tmx_tile));
+	}
 
 	if ((unsigned int)(tileset->user_data.integer) == tileset->tilecount) {
 		tileset->user_data.integer = 0;
@@ -611,15 +711,7 @@ static int parse_tile(XMLElement *ele, tmx_tileset *tileset, const char *filenam
 
 		}
 		else if (!strcmp(name, "animation")) {
-			auto frameEle = subEle->FirstChildElement("frame");
-			while (frameEle) {
-				res->animation = parse_animation(frameEle, 0, &(res->animation_len));
-				if (!res->animation) {
-					assert(false); return 0;
-				}
-				frameEle = frameEle->NextSiblingElement("frame");
-			}
-			success = 1;
+			success = parse_animation(subEle, &(res->animation), &(res->animation_len));
 		}
 
 		if (!success) {
@@ -890,6 +982,10 @@ static tmx_map *parse_root_map(XMLDocument *doc, tmx_tileset_manager *ts_mgr, co
 		res->hexsidelength = atoi(value);
 	}
 
+	if ((value = mapNode->Attribute("infinite"))) {
+		res->infinite = atoi(value) == 1;
+	}
+
 	mapChild = mapNode->FirstChildElement();
 	while (mapChild) {
 		auto name = mapChild->Value();
@@ -903,7 +999,7 @@ static tmx_map *parse_root_map(XMLDocument *doc, tmx_tileset_manager *ts_mgr, co
 		}
 		else {
 			tmx_layer_type layerType = parse_layer_type(name);
-			success = parse_layer(mapChild, &(res->ly_head), res->height, res->width, layerType, filename);
+			success = parse_layer(mapChild, &(res->ly_head), res, layerType, filename);
 		}
 
 		if (!success) {
@@ -208,12 +208,13 @@ workspace "Slate2D"
       targetname "soloud_static"
       warnings "Off"
       sysincludedirs "libs/sdl"
-      defines { "MODPLUG_STATIC", "WITH_OPENMPT", "WITH_SDL2_STATIC" }
+      defines { "MODPLUG_STATIC", "WITH_OPENMPT", "WITH_SDL2_STATIC", "WITH_NULL" }
       files {
         "libs/soloud/src/audiosource/**.c*",
         "libs/soloud/src/filter/**.c*",
         "libs/soloud/src/core/**.c*",
-        "libs/soloud/src/backend/sdl2_static/**.c*"
+        "libs/soloud/src/backend/sdl2_static/**.c*",
+        "libs/soloud/src/backend/null/**.c*"
 	    }
       includedirs {
         "libs/soloud/src/**",
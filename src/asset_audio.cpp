@@ -34,28 +34,37 @@ void Speech_ParseINI(Asset &asset, ini_t *ini) {
 }
 
 void* Sound_Load(Asset &asset) {
-	unsigned char *musicbuf;
-	auto sz = FS_ReadFile(asset.path, (void **)&musicbuf);
+	fileMapping_t file;
+	auto sz = FS_MapFile(asset.path, &file);
 
 	if (sz <= 0) {
+		FS_UnmapFile(&file);
 		return nullptr;
 	}
 
+	// soloud is asked to copy the buffer, so nothing it keeps can point into the mapping once
+	// it's released below. the copy only lives for the load, both sources decode or copy the
+	// data they play from.
+	void *resource = nullptr;
 	switch (asset.type) {
 		case ASSET_SOUND: {
 			auto sound = new SoLoud::Wav();
-			sound->loadMem(musicbuf, sz, false, true);
-			return (void*)sound;
+			sound->loadMem((unsigned char *)file.data, sz, true, false);
+			resource = (void*)sound;
+			break;
 		}
 
 		case ASSET_MOD: {
 			auto mod = new SoLoud::Openmpt();
-			mod->loadMem(musicbuf, sz, false, true);
-			return (void*)mod;
+			mod->loadMem((unsigned char *)file.data, sz, true, false);
+			resource = (void*)mod;
+			break;
 		}
 	}
 
-	return nullptr;
+	FS_UnmapFile(&file);
+
+	return resource;
 }
 
 void Sound_Free(Asset &asset) {
@@ -107,7 +107,7 @@ void* BMPFNT_Load(Asset &asset) {
 	}
 
 	if (ctx == nullptr) {
-		ctx = glfonsCreate(512, 512, FONS_ZERO_TOPLEFT);
+		ctx = TTF_CreateContext();
 	}
 
 	void *buffer;
@@ -1,6 +1,7 @@
 #include "assetloader.h"
 #include "external/rlgl.h"
 #include "console.h"
+#include "cvar_main.h"
 #include <imgui.h>
 
 void * Canvas_Load(Asset & asset) {
@@ -12,6 +13,13 @@ void * Canvas_Load(Asset & asset) {
 
 	auto *canvas = (Canvas*)asset.resource;
 
+	if (eng_headless->integer) {
+		canvas->texture = RenderTexture2D{};
+		canvas->texture.texture.width = canvas->w;
+		canvas->texture.texture.height = canvas->h;
+		return (void*)canvas;
+	}
+
 	canvas->texture = rlLoadRenderTexture(canvas->w, canvas->h);
 
 	if (asset.flags & IMAGEFLAGS_LINEAR_FILTER) {
@@ -2,13 +2,67 @@
 #include "assetloader.h"
 #include "files.h"
 #include "console.h"
+#include "cvar_main.h"
+#include "rawimage.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <imgui.h>
 
+static void Img_SetFilter(unsigned int tex, int flags) {
+	if (flags & IMAGEFLAGS_LINEAR_FILTER) {
+		rlTextureParameters(tex, RL_TEXTURE_MAG_FILTER, RL_FILTER_LINEAR);
+		rlTextureParameters(tex, RL_TEXTURE_MIN_FILTER, RL_FILTER_LINEAR);
+	} else {
+		rlTextureParameters(tex, RL_TEXTURE_MAG_FILTER, RL_FILTER_NEAREST);
+		rlTextureParameters(tex, RL_TEXTURE_MIN_FILTER, RL_FILTER_NEAREST);		
+	}
+}
+
+// uncompressed pages are uploaded straight out of the file mapping, lz4 ones are decompressed into a buffer first
+static Image* Img_LoadRaw(Image *img, const char *path, fileMapping_t *file, const rawImage_t *raw, int flags) {
+	img->w = raw->width;
+	img->h = raw->height;
+	img->hnd = 0;
+
+	if (eng_headless->integer) {
+		FS_UnmapFile(file);
+		return img;
+	}
+
+	uint8_t *pixels = (uint8_t*)raw->data;
+	if (raw->compression != RAWIMAGE_NONE) {
+		pixels = (uint8_t*)malloc((size_t)raw->width * raw->height * 4);
+		if (pixels == nullptr || !RawImg_Decode(raw, pixels)) {
+			Con_Errorf(ERR_GAME, "failed to decompress image %s", path);
+			free(pixels);
+			FS_UnmapFile(file);
+			delete img;
+			return nullptr;
+		}
+	}
+
+	unsigned int tex = rlLoadTexture(pixels, img->w, img->h, UNCOMPRESSED_R8G8B8A8, 1);
+
+	if (pixels != raw->data) {
+		free(pixels);
+	}
+	FS_UnmapFile(file);
+
+	if (tex == 0) {
+		Con_Errorf(ERR_GAME, "couldn't upload texture %s", path);
+		delete img;
+		return nullptr;
+	}
+
+	Img_SetFilter(tex, flags);
+	img->hnd = tex;
+
+	return img;
+}
+
 Image* Img_LoadPath(const char *path, int flags) {
-	unsigned char *buffer;
-	auto sz = FS_ReadFile(path, (void**)&buffer);
+	fileMapping_t file;
+	auto sz = FS_MapFile(path, &file);
 
 	if (sz == -1) {
 		Con_Errorf(ERR_GAME, "Couldn't read image %s", path);
@@ -17,13 +71,36 @@ Image* Img_LoadPath(const char *path, int flags) {
 
 	Image * img = new Image();
 
+	// raw atlas pages from crunch skip decoding entirely, see rawimage.h
+	rawImage_t raw;
+	if (RawImg_Parse(file.data, sz, &raw)) {
+		return Img_LoadRaw(img, path, &file, &raw, flags);
+	}
+
+	// headless runs only need the dimensions, so skip decoding and leave the texture handle at 0
+	if (eng_headless->integer) {
+		int imgBpp;
+		int ok = stbi_info_from_memory((const stbi_uc *)file.data, sz, &img->w, &img->h, &imgBpp);
+		FS_UnmapFile(&file);
+
+		if (!ok) {
+			Con_Errorf(ERR_GAME, "failed to decode PNG %s", path);
+			delete img;
+			return nullptr;
+		}
+
+		img->hnd = 0;
+		return img;
+	}
+
 	int imgBpp;
-	unsigned char *loaded = stbi_load_from_memory(buffer, sz, &img->w, &img->h, &imgBpp, 0);
+	unsigned char *loaded = stbi_load_from_memory((const stbi_uc *)file.data, sz, &img->w, &img->h, &imgBpp, 0);
 
-	free(buffer);
+	FS_UnmapFile(&file);
 
 	if (loaded == nullptr) {
 		Con_Errorf(ERR_GAME, "failed to decode PNG %s", path);
+		delete img;
 		return nullptr;
 	}
 
@@ -39,17 +116,11 @@ Image* Img_LoadPath(const char *path, int flags) {
 
 	if (tex == 0) {
 		Con_Errorf(ERR_GAME, "couldn't upload texture %s", path);
+		delete img;
 		return nullptr;
 	}
 
-	if (flags & IMAGEFLAGS_LINEAR_FILTER) {
-		rlTextureParameters(tex, RL_TEXTURE_MAG_FILTER, RL_FILTER_LINEAR);
-		rlTextureParameters(tex, RL_TEXTURE_MIN_FILTER, RL_FILTER_LINEAR);
-	} else {
-		rlTextureParameters(tex, RL_TEXTURE_MAG_FILTER, RL_FILTER_NEAREST);
-		rlTextureParameters(tex, RL_TEXTURE_MIN_FILTER, RL_FILTER_NEAREST);		
-	}
-
+	Img_SetFilter(tex, flags);
 	img->hnd = tex;
 
 	return img;
@@ -1,6 +1,7 @@
 #include "assetloader.h"
 #include "external/rlgl.h"
 #include "console.h"
+#include "cvar_main.h"
 #include "files.h"
 #include <imgui.h>
 
@@ -17,12 +18,33 @@ void * Shader_Load(Asset & asset) {
 	// loadshader doesn't return a pointer so do a little weirdness here
 	Shader *shader = new Shader();
 
-	if (shasset->isFile) {
-		char *vs;
-		FS_ReadFile(shasset->vs, (void**)&vs);
-
-		char *fs;
-		FS_ReadFile(shasset->fs, (void**)&fs);
+	if (eng_headless->integer) {
+		*shader = Shader{};
+		shasset->locResolution = shasset->locTime = shasset->locTimeDelta = shasset->locMouse = -1;
+	}
+	else if (shasset->isFile) {
+		// size both files from the index so the sources can share a single allocation, and each
+		// file is only opened to read it. the watcher refreshes the index before a hot reload, a
+		// file that's still being saved can outgrow its size and fails the read below.
+		fileStat_t vsStat, fsStat;
+		if (!FS_Stat(shasset->vs, &vsStat) || !FS_Stat(shasset->fs, &fsStat) || vsStat.directory || fsStat.directory || vsStat.size < 0 || fsStat.size < 0) {
+			Con_Errorf(ERR_GAME, "couldn't read shader source for %s", asset.name);
+			delete shader;
+			return nullptr;
+		}
+
+		fileArena_t arena;
+		arena.capacity = (size_t)vsStat.size + (size_t)fsStat.size + 2;
+		arena.data = (uint8_t *)malloc(arena.capacity);
+		arena.used = 0;
+
+		char *vs, *fs;
+		if (arena.data == nullptr || FS_ReadFileInto(shasset->vs, &arena, (void**)&vs) < 0 || FS_ReadFileInto(shasset->fs, &arena, (void**)&fs) < 0) {
+			Con_Errorf(ERR_GAME, "couldn't read shader source for %s", asset.name);
+			free(arena.data);
+			delete shader;
+			return nullptr;
+		}
 
 		*shader = LoadShaderCode(vs, fs);
 
@@ -31,8 +53,7 @@ void * Shader_Load(Asset & asset) {
 		shasset->locTimeDelta = GetShaderLocation(*shader, "iTimeDelta");
 		shasset->locMouse = GetShaderLocation(*shader, "iMouse");
 
-		free(vs);
-		free(fs);
+		free(arena.data);
 	}
 	else {
 		*shader = LoadShaderCode(shasset->vs, shasset->fs);
@@ -71,7 +92,7 @@ void Shader_Free(Asset & asset) {
 	free((void*)res->fs);
 	free((void*)res->vs);
 
-	if (GetShaderDefault().id == res->shader->id) {
+	if (res->shader->id != 0 && GetShaderDefault().id == res->shader->id) {
 		Con_Print("not freeing default shader\n");
 	} else {
 		UnloadShader(*res->shader);
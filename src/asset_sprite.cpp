@@ -35,9 +35,9 @@ void* Sprite_Load(Asset &asset) {
 	// if the sprite ends in bin, load it through crunch, otherwise generate the sprite
 	if (IsCrunchAsset(asset)) {
 		// read the bin file
-		uint8_t *crunch;
-		int len = FS_ReadFile(asset.path, (void**)&crunch);
-		uint8_t *curr = crunch;
+		fileMapping_t file;
+		int len = FS_MapFile(asset.path, &file);
+		uint8_t *curr = (uint8_t *)file.data;
 
 		if (len == -1) {
 			Con_Errorf(ERR_GAME, "couldn't read file %s", asset.path);
@@ -91,7 +91,7 @@ void* Sprite_Load(Asset &asset) {
 
 		}
 
-		free(crunch);
+		FS_UnmapFile(&file);
 		asset.resource = (void*)atlas;
 	}
 	else {
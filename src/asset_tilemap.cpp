@@ -1,8 +1,16 @@
 #include <assert.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
 #include "assetloader.h"
 #include "files.h"
+#include <imgui.h>
 #include <tmx.h>
 #include "main.h"
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 void * tmx_img_load(const char *path) {
 	const char *fullpath = tempstr("maps/%s", path);
@@ -15,10 +23,14 @@ void tmx_img_free(void *address) {
 	// leave the asset around, since they'll often be cleared by the next scene load
 }
 
+static const char* TMX_FilePath(const char *filename) {
+	return tempstr("maps/%s", filename);
+}
+
 void *tmx_fs(const char *filename, int *outSz) {
 	void *xml;
 
-	*outSz = FS_ReadFile(tempstr("maps/%s", filename), &xml);
+	*outSz = FS_ReadFile(TMX_FilePath(filename), &xml);
 
 	if (*outSz < 0) {
 		Con_Errorf(ERR_GAME, "Couldn't load file while parsing map %s", filename);
@@ -28,6 +40,458 @@ void *tmx_fs(const char *filename, int *outSz) {
 	return xml;
 }
 
+// collects the flattened object and property data before it's copied into the index
+typedef struct {
+	std::unordered_map<std::string, int> stringIds;
+	std::vector<int> stringOffsets;
+	std::vector<char> strings;
+	std::vector<tmxPropInfo_t> props;
+	std::vector<tmxObjectInfo_t> objects;
+	std::vector<tmxTileInfo_t> tiles;
+	std::vector<unsigned int> animGids;
+} tmxIndexBuilder_t;
+
+static int TMX_InternString(tmxIndexBuilder_t &b, const char *str) {
+	str = str == nullptr ? "" : str;
+	auto found = b.stringIds.find(str);
+	if (found != b.stringIds.end()) {
+		return found->second;
+	}
+
+	int id = (int)b.stringOffsets.size();
+	b.stringOffsets.push_back((int)b.strings.size());
+	b.strings.insert(b.strings.end(), str, str + strlen(str) + 1);
+	b.stringIds[str] = id;
+	return id;
+}
+
+static void TMX_AddProperty(tmx_property *prop, void *userdata) {
+	tmxIndexBuilder_t &b = *(tmxIndexBuilder_t*)userdata;
+	tmxPropInfo_t info;
+	info.name = TMX_InternString(b, prop->name);
+	info.type = prop->type;
+
+	switch (prop->type) {
+	case PT_INT: info.value.number = prop->value.integer; break;
+	case PT_FLOAT: info.value.number = prop->value.decimal; break;
+	case PT_BOOL: info.value.number = prop->value.boolean ? 1 : 0; break;
+	case PT_COLOR: info.value.number = prop->value.color; break;
+	default: info.value.string = TMX_InternString(b, prop->value.string); break;
+	}
+
+	b.props.push_back(info);
+}
+
+// adds the properties and returns where they start, count gets how many were added
+static int TMX_AddProperties(tmxIndexBuilder_t &b, tmx_properties *properties, int *count) {
+	int start = (int)b.props.size();
+	if (properties != nullptr) {
+		tmx_property_foreach(properties, TMX_AddProperty, &b);
+	}
+
+	*count = (int)b.props.size() - start;
+	return start;
+}
+
+static void TMX_AddObject(tmxIndexBuilder_t &b, const tmx_map *map, const tmx_object *obj) {
+	tmx_tile *tile = nullptr;
+	if (obj->obj_type == OT_TILE) {
+		unsigned int gid = (unsigned int)obj->content.gid & TMX_FLIP_BITS_REMOVAL;
+		tile = gid < map->tilecount ? map->tiles[gid] : nullptr;
+	}
+
+	tmxObjectInfo_t info;
+	info.name = TMX_InternString(b, obj->name);
+	info.type = TMX_InternString(b, obj->type != nullptr ? obj->type : (tile != nullptr ? tile->type : nullptr));
+	info.x = obj->x;
+	info.y = obj->y;
+	info.width = obj->width;
+	info.height = obj->height;
+	info.rotation = obj->rotation;
+	info.visible = obj->visible;
+
+	// the tile's properties are defaults, drop the ones the object sets itself
+	int tileCount = 0, objCount;
+	int tileStart = tile != nullptr ? TMX_AddProperties(b, tile->properties, &tileCount) : (int)b.props.size();
+	TMX_AddProperties(b, obj->properties, &objCount);
+
+	int kept = tileStart;
+	for (int i = tileStart; i < tileStart + tileCount; i++) {
+		bool overridden = false;
+		for (int j = tileStart + tileCount; j < tileStart + tileCount + objCount; j++) {
+			overridden = overridden || b.props[i].name == b.props[j].name;
+		}
+
+		if (!overridden) {
+			b.props[kept++] = b.props[i];
+		}
+	}
+	for (int j = tileStart + tileCount; j < tileStart + tileCount + objCount; j++) {
+		b.props[kept++] = b.props[j];
+	}
+	b.props.resize(kept);
+
+	info.propStart = tileStart;
+	info.propCount = kept - tileStart;
+	b.objects.push_back(info);
+}
+
+template <typename T>
+static T* TMX_CopyOut(const std::vector<T> &v) {
+	T *out = (T*)malloc(sizeof(T) * (v.size() > 0 ? v.size() : 1));
+	if (v.size() > 0) {
+		memcpy(out, v.data(), sizeof(T) * v.size());
+	}
+	return out;
+}
+
+// animations that take no time or show tiles that aren't in the map are left static
+static bool TMX_ValidAnimation(const tmx_map *map, unsigned int gid) {
+	const tmx_tile *tile = map->tiles[gid];
+	unsigned int firstGid = gid - tile->id;
+	unsigned int length = 0;
+
+	for (unsigned int i = 0; i < tile->animation_len; i++) {
+		unsigned int frameGid = firstGid + tile->animation[i].tile_id;
+		if (frameGid >= map->tilecount || map->tiles[frameGid] == nullptr) {
+			return false;
+		}
+		length += tile->animation[i].duration;
+	}
+
+	return length > 0;
+}
+
+static void TMX_BuildIndex(tmx_map *map) {
+	tmxMapIndex_t *index = (tmxMapIndex_t*)calloc(1, sizeof(tmxMapIndex_t));
+
+	for (tmx_layer *layer = map->ly_head; layer != nullptr; layer = layer->next) {
+		index->info.layerCount++;
+	}
+
+	int layerSz = index->info.layerCount > 0 ? index->info.layerCount : 1;
+	index->layers = (tmx_layer**)malloc(sizeof(tmx_layer*) * layerSz);
+	index->layerInfo = (tmxLayerInfo_t*)calloc(layerSz, sizeof(tmxLayerInfo_t));
+	index->chunkGrids = (tmxChunkGrid_t*)calloc(layerSz, sizeof(tmxChunkGrid_t));
+	index->info.layers = index->layerInfo;
+
+	tmxIndexBuilder_t b;
+	index->info.mapPropStart = TMX_AddProperties(b, map->properties, &index->info.mapPropCount);
+
+	int i = 0;
+	for (tmx_layer *layer = map->ly_head; layer != nullptr; layer = layer->next) {
+		tmxLayerInfo_t &info = index->layerInfo[i];
+		index->layers[i++] = layer;
+
+		info.propStart = TMX_AddProperties(b, layer->properties, &info.propCount);
+		info.objectStart = (int)b.objects.size();
+		if (layer->type == L_OBJGR) {
+			for (tmx_object *obj = layer->content.objgr->head; obj != nullptr; obj = obj->next) {
+				TMX_AddObject(b, map, obj);
+			}
+		}
+		info.objectCount = (int)b.objects.size() - info.objectStart;
+	}
+
+	for (unsigned int gid = 0; gid < map->tilecount; gid++) {
+		tmx_tile *tile = map->tiles[gid];
+		if (tile == nullptr) {
+			continue;
+		}
+
+		tmxTileInfo_t info;
+		info.gid = gid;
+		info.type = TMX_InternString(b, tile->type);
+		info.propStart = TMX_AddProperties(b, tile->properties, &info.propCount);
+		b.tiles.push_back(info);
+
+		if (TMX_ValidAnimation(map, gid)) {
+			b.animGids.push_back(gid);
+		}
+	}
+
+	index->info.stringCount = (int)b.stringOffsets.size();
+	index->info.stringOffsets = TMX_CopyOut(b.stringOffsets);
+	index->info.strings = TMX_CopyOut(b.strings);
+	index->info.propCount = (int)b.props.size();
+	index->info.props = TMX_CopyOut(b.props);
+	index->info.objectCount = (int)b.objects.size();
+	index->info.objects = TMX_CopyOut(b.objects);
+	index->info.tileCount = (int)b.tiles.size();
+	index->info.tiles = TMX_CopyOut(b.tiles);
+
+	if (b.animGids.size() > 0) {
+		index->animCount = (int)b.animGids.size();
+		index->animGids = TMX_CopyOut(b.animGids);
+		index->animRemap = (unsigned int*)malloc(sizeof(unsigned int) * map->tilecount);
+		for (unsigned int gid = 0; gid < map->tilecount; gid++) {
+			index->animRemap[gid] = gid;
+		}
+		index->animFrame = -1;
+	}
+
+	map->user_data.pointer = index;
+}
+
+// a grid entry per chunk position, so a few chunks drawn far apart would make a huge grid
+#define TMX_MAX_CHUNK_GRID (1 << 24)
+
+// lays the chunks of each tile layer out on a grid starting at the top left chunk of the map,
+// and sets map->width and height to cover all of them. returns false if the chunks aren't all
+// the same size, lined up on multiples of it, or too spread out.
+static bool TMX_BuildChunkGrids(tmx_map *map, tmxMapIndex_t *index) {
+	int minX = 0, minY = 0, maxX = 0, maxY = 0;
+	bool found = false;
+
+	for (int i = 0; i < index->info.layerCount; i++) {
+		tmx_layer *layer = index->layers[i];
+		if (layer->type != L_LAYER) {
+			continue;
+		}
+
+		for (int c = 0; c < layer->chunk_count; c++) {
+			const tmx_chunk &chunk = layer->chunks[c];
+			if (!found) {
+				index->info.chunkW = (int)chunk.width;
+				index->info.chunkH = (int)chunk.height;
+				minX = maxX = chunk.x;
+				minY = maxY = chunk.y;
+				found = true;
+			}
+
+			if ((int)chunk.width != index->info.chunkW || (int)chunk.height != index->info.chunkH || chunk.x % index->info.chunkW != 0 || chunk.y % index->info.chunkH != 0) {
+				return false;
+			}
+
+			minX = chunk.x < minX ? chunk.x : minX;
+			minY = chunk.y < minY ? chunk.y : minY;
+			maxX = chunk.x > maxX ? chunk.x : maxX;
+			maxY = chunk.y > maxY ? chunk.y : maxY;
+		}
+	}
+
+	// nothing's been drawn on any layer
+	if (!found) {
+		map->width = 0;
+		map->height = 0;
+		return true;
+	}
+
+	int64_t cols = ((int64_t)maxX - minX) / index->info.chunkW + 1;
+	int64_t rows = ((int64_t)maxY - minY) / index->info.chunkH + 1;
+	if (cols * rows > TMX_MAX_CHUNK_GRID || cols * index->info.chunkW > INT32_MAX || rows * index->info.chunkH > INT32_MAX) {
+		return false;
+	}
+
+	index->info.originX = minX;
+	index->info.originY = minY;
+	map->width = (unsigned int)(cols * index->info.chunkW);
+	map->height = (unsigned int)(rows * index->info.chunkH);
+
+	for (int i = 0; i < index->info.layerCount; i++) {
+		tmx_layer *layer = index->layers[i];
+		tmxChunkGrid_t &grid = index->chunkGrids[i];
+		if (layer->type != L_LAYER) {
+			continue;
+		}
+
+		grid.cols = (int)cols;
+		grid.rows = (int)rows;
+		grid.grid = (int*)malloc(sizeof(int) * cols * rows);
+		for (int64_t cell = 0; cell < cols * rows; cell++) {
+			grid.grid[cell] = -1;
+		}
+
+		for (int c = 0; c < layer->chunk_count; c++) {
+			const tmx_chunk &chunk = layer->chunks[c];
+			int64_t cell = ((int64_t)chunk.y - minY) / index->info.chunkH * cols + ((int64_t)chunk.x - minX) / index->info.chunkW;
+			if (grid.grid[cell] != -1) {
+				return false;
+			}
+			grid.grid[cell] = c;
+		}
+	}
+
+	return true;
+}
+
+static void TMX_FreeIndex(tmx_map *map) {
+	tmxMapIndex_t *index = (tmxMapIndex_t*)map->user_data.pointer;
+	if (index == nullptr) {
+		return;
+	}
+
+	for (int i = 0; i < index->info.layerCount; i++) {
+		free(index->chunkGrids[i].grid);
+	}
+	free(index->layers);
+	free(index->layerInfo);
+	free(index->chunkGrids);
+	free((void*)index->info.stringOffsets);
+	free((void*)index->info.strings);
+	free((void*)index->info.props);
+	free((void*)index->info.objects);
+	free((void*)index->info.tiles);
+	free(index->animGids);
+	free(index->animRemap);
+	free(index);
+	map->user_data.pointer = nullptr;
+}
+
+// decoded chunks from every loaded map. a chunk's user_data is its position in here + 1, 0 if it
+// isn't decoded, or -1 if it failed to decode.
+typedef struct {
+	tmx_chunk *chunk;
+	const tmx_map *map;
+	uint64_t lastUsed;
+} tmxResidentChunk_t;
+
+static std::vector<tmxResidentChunk_t> residentChunks;
+static size_t residentBytes;
+static uint64_t chunkClock;
+static conVar_t *tmx_chunkMemory;
+
+static size_t TMX_ChunkBytes(const tmx_chunk *chunk) {
+	return sizeof(int32_t) * chunk->width * chunk->height;
+}
+
+static void TMX_EvictChunk(int i) {
+	tmx_chunk *chunk = residentChunks[i].chunk;
+	residentBytes -= TMX_ChunkBytes(chunk);
+	tmx_chunk_evict(chunk);
+	chunk->user_data.integer = 0;
+
+	int last = (int)residentChunks.size() - 1;
+	if (i != last) {
+		residentChunks[i] = residentChunks[last];
+		residentChunks[i].chunk->user_data.integer = i + 1;
+	}
+	residentChunks.pop_back();
+}
+
+// evicts the least recently used chunks until the rest fit in tmx.chunkMemory. keep is never
+// evicted, so there's always room for the chunk being asked for.
+static void TMX_TrimChunks(const tmx_chunk *keep) {
+	size_t cap = (size_t)(tmx_chunkMemory->integer > 0 ? tmx_chunkMemory->integer : 0) * 1024;
+
+	while (residentBytes > cap && residentChunks.size() > 1) {
+		int oldest = -1;
+		for (int i = 0; i < (int)residentChunks.size(); i++) {
+			if (residentChunks[i].chunk != keep && (oldest < 0 || residentChunks[i].lastUsed < residentChunks[oldest].lastUsed)) {
+				oldest = i;
+			}
+		}
+
+		TMX_EvictChunk(oldest);
+	}
+}
+
+const int32_t* TMX_GetChunk(const tmx_map *map, int layer, int col, int row) {
+	const tmxMapIndex_t *index = (const tmxMapIndex_t*)map->user_data.pointer;
+	if (layer < 0 || layer >= index->info.layerCount) {
+		return nullptr;
+	}
+
+	const tmxChunkGrid_t &grid = index->chunkGrids[layer];
+	if (col < 0 || row < 0 || col >= grid.cols || row >= grid.rows || grid.grid[row * grid.cols + col] < 0) {
+		return nullptr;
+	}
+
+	tmx_chunk *chunk = &index->layers[layer]->chunks[grid.grid[row * grid.cols + col]];
+	if (chunk->user_data.integer > 0) {
+		residentChunks[chunk->user_data.integer - 1].lastUsed = ++chunkClock;
+		return chunk->gids;
+	}
+
+	// don't retry (or print) every time something asks for a broken chunk
+	if (chunk->user_data.integer < 0) {
+		return nullptr;
+	}
+
+	if (!tmx_chunk_decode(chunk)) {
+		Con_Printf("couldn't decode chunk at %i,%i in layer %s: %s\n", chunk->x, chunk->y, index->layers[layer]->name, tmx_strerr());
+		chunk->user_data.integer = -1;
+		return nullptr;
+	}
+
+	residentChunks.push_back({ chunk, map, ++chunkClock });
+	residentBytes += TMX_ChunkBytes(chunk);
+	chunk->user_data.integer = (int)residentChunks.size();
+	TMX_TrimChunks(chunk);
+
+	return chunk->gids;
+}
+
+// tile animations all run off this, so every map's animated tiles stay in step
+static int64_t animMusec;
+static int64_t animFrame;
+
+void TMX_Tick(int64_t musec) {
+	animMusec += musec;
+	animFrame++;
+}
+
+const unsigned int* TMX_AnimRemap(const tmx_map *map) {
+	tmxMapIndex_t *index = (tmxMapIndex_t*)map->user_data.pointer;
+	if (index->animRemap == nullptr || index->animFrame == animFrame) {
+		return index->animRemap;
+	}
+
+	// every cell with the same gid shows the same frame, so this only runs once per animated gid
+	// no matter how many of them get drawn
+	int64_t ms = animMusec / 1000;
+	for (int i = 0; i < index->animCount; i++) {
+		unsigned int gid = index->animGids[i];
+		const tmx_tile *tile = map->tiles[gid];
+
+		int64_t length = 0;
+		for (unsigned int f = 0; f < tile->animation_len; f++) {
+			length += tile->animation[f].duration;
+		}
+
+		int64_t t = ms % length;
+		unsigned int f = 0;
+		while (t >= tile->animation[f].duration) {
+			t -= tile->animation[f].duration;
+			f++;
+		}
+
+		index->animRemap[gid] = gid - tile->id + tile->animation[f].tile_id;
+	}
+
+	index->animFrame = animFrame;
+	return index->animRemap;
+}
+
+static void TMX_CheckDependency(const char *path, void *userdata) {
+	int64_t *newest = (int64_t*)userdata;
+	fileStat_t stat;
+	// a tileset that's gone counts as changed, so the xml's error gets reported
+	int64_t modtime = FS_Stat(path, &stat) ? stat.modtime : INT64_MAX;
+	*newest = modtime > *newest ? modtime : *newest;
+}
+
+// true if the .tmxb at binPath is at least as new as the map and every tileset it was converted from.
+// these come from the file index, which the filewatcher refreshes when a map is edited outside of the engine.
+static bool TMX_BinaryIsFresh(const char *xmlPath, const char *binPath) {
+	fileStat_t xmlStat, binStat;
+	if (!FS_Stat(binPath, &binStat) || !FS_Stat(xmlPath, &xmlStat) || binStat.modtime < xmlStat.modtime) {
+		return false;
+	}
+
+	fileMapping_t file;
+	int sz = FS_MapFile(binPath, &file);
+	if (sz < 0) {
+		return false;
+	}
+
+	int64_t newest = xmlStat.modtime;
+	int count = tmx_binary_dependencies(file.data, sz, &TMX_CheckDependency, &newest);
+	FS_UnmapFile(&file);
+
+	return count >= 0 && binStat.modtime >= newest;
+}
+
 void * TMX_Load(Asset &asset) {
 	tmx_img_load_func = &tmx_img_load;
 	tmx_img_free_func = &tmx_img_free;
@@ -35,38 +499,355 @@ void * TMX_Load(Asset &asset) {
 
 	tmx_map *map;
 
-	const char *xml;
-	int outSz = FS_ReadFile(asset.path, (void **)&xml);
+	// use a .tmxb made by tmx_convert instead of the xml when there's one that's up to date
+	const char *path = asset.path;
+	std::string binPath = std::string(asset.path) + "b";
+	if (strcmp(FS_FileExtension(asset.path), "tmx") == 0 && TMX_BinaryIsFresh(asset.path, binPath.c_str())) {
+		path = binPath.c_str();
+	}
+
+	// neither parser keeps the buffer around, so the map file never needs its own allocation
+	fileMapping_t file;
+	int outSz = FS_MapFile(path, &file);
 	if (outSz < 0) {
-		Con_Errorf(ERR_GAME, "Couldn't read map %s", asset.path);
+		Con_Errorf(ERR_GAME, "Couldn't read map %s", path);
 		return nullptr;
 	}
 
-	map = tmx_load_buffer(xml, outSz);
+	if (tmx_is_binary(file.data, outSz)) {
+		map = tmx_load_binary(file.data, outSz);
+	}
+	else {
+		map = tmx_load_buffer((const char *)file.data, outSz);
+	}
+	FS_UnmapFile(&file);
 
 	if (map == nullptr) {
-		Con_Errorf(ERR_GAME, "Failed to load tmx %s", asset.path);
-		free((void*)xml);
+		Con_Errorf(ERR_GAME, "Failed to load tmx %s: %s", path, tmx_strerr());
 		return nullptr;
 	}
 
 	if (map->orient != O_ORT) {
 		Con_Errorf(ERR_GAME, "Non orthagonal tiles not supported in tmx %s", asset.path);
-		free((void*)xml);
+		tmx_map_free(map);
 		return nullptr;
 	}
 
-	free((void*)xml);
+	TMX_BuildIndex(map);
+
+	if (map->infinite && !TMX_BuildChunkGrids(map, (tmxMapIndex_t*)map->user_data.pointer)) {
+		Con_Errorf(ERR_GAME, "Chunks in tmx %s need to be the same size and not too far apart", asset.path);
+		TMX_FreeIndex(map);
+		tmx_map_free(map);
+		return nullptr;
+	}
 
 	return (void*) map;
 }
 
 void TMX_Free(Asset &asset) {
-	tmx_map_free((tmx_map*) asset.resource);
+	tmx_map *map = (tmx_map*)asset.resource;
+
+	// walking backwards, since evicting moves the last entry into the evicted one's place
+	for (int i = (int)residentChunks.size() - 1; i >= 0; i--) {
+		if (residentChunks[i].map == map) {
+			TMX_EvictChunk(i);
+		}
+	}
+
+	TMX_FreeIndex(map);
+	tmx_map_free(map);
+}
+
+void TMX_Inspect(Asset& asset, bool deselected) {
+	NOTUSED(deselected);
+	tmx_map *map = (tmx_map*)asset.resource;
+	const tmxMapIndex_t *index = (const tmxMapIndex_t*)map->user_data.pointer;
+
+	ImGui::Text("Size: %ix%i tiles of %ix%i", map->width, map->height, map->tile_width, map->tile_height);
+	ImGui::Text("Layers: %i, objects: %i, animated tiles: %i", index->info.layerCount, index->info.objectCount, index->animCount);
+	if (!map->infinite) {
+		return;
+	}
+
+	size_t bytes = 0;
+	for (const tmxResidentChunk_t &r : residentChunks) {
+		bytes += r.map == map ? TMX_ChunkBytes(r.chunk) : 0;
+	}
+
+	ImGui::Text("Origin: %i,%i, chunks of %ix%i", index->info.originX, index->info.originY, index->info.chunkW, index->info.chunkH);
+	ImGui::Text("Decoded: %.1fKB, all maps: %.1fKB of %iKB", bytes / 1024.0, residentBytes / 1024.0, tmx_chunkMemory->integer);
+	if (ImGui::Button("Evict All")) {
+		for (int i = (int)residentChunks.size() - 1; i >= 0; i--) {
+			if (residentChunks[i].map == map) {
+				TMX_EvictChunk(i);
+			}
+		}
+	}
+
+	// each layer's chunk grid, green chunks are decoded, grey ones are still encoded and red ones
+	// failed to decode. huge grids would just be noise, so those only get the count.
+	const float cellSz = 6.0f;
+	for (int i = 0; i < index->info.layerCount; i++) {
+		const tmx_layer *layer = index->layers[i];
+		const tmxChunkGrid_t &grid = index->chunkGrids[i];
+		if (layer->type != L_LAYER) {
+			continue;
+		}
+
+		int decoded = 0;
+		for (int c = 0; c < layer->chunk_count; c++) {
+			decoded += layer->chunks[c].user_data.integer > 0;
+		}
+		ImGui::Text("%s: %i of %i chunks decoded", layer->name, decoded, layer->chunk_count);
+		if (grid.cols > 128 || grid.rows > 128) {
+			continue;
+		}
+
+		ImVec2 pos = ImGui::GetCursorScreenPos();
+		ImDrawList *draw = ImGui::GetWindowDrawList();
+		for (int row = 0; row < grid.rows; row++) {
+			for (int col = 0; col < grid.cols; col++) {
+				int c = grid.grid[row * grid.cols + col];
+				if (c < 0) {
+					continue;
+				}
+
+				ImU32 color = layer->chunks[c].user_data.integer > 0 ? IM_COL32(80, 220, 80, 255) : layer->chunks[c].user_data.integer < 0 ? IM_COL32(220, 60, 60, 255) : IM_COL32(80, 80, 80, 255);
+				ImVec2 min(pos.x + col * cellSz, pos.y + row * cellSz);
+				draw->AddRectFilled(min, ImVec2(min.x + cellSz - 1, min.y + cellSz - 1), color);
+			}
+		}
+		ImGui::Dummy(ImVec2(grid.cols * cellSz, grid.rows * cellSz));
+	}
+}
+
+const tmxMapInfo_t* TMX_GetInfo(const tmx_map *map) {
+	return &((const tmxMapIndex_t*)map->user_data.pointer)->info;
+}
+
+tmx_layer* TMX_GetLayer(const tmx_map *map, int layer) {
+	const tmxMapIndex_t *index = (const tmxMapIndex_t*)map->user_data.pointer;
+	return layer >= 0 && layer < index->info.layerCount ? index->layers[layer] : nullptr;
 }
 
 tmx_map* Get_TMX(AssetHandle id) {
 	Asset *asset = Asset_Get(ASSET_TMX, id);
 	assert(asset != nullptr && asset->resource != nullptr);
 	return (tmx_map*)asset->resource;
-}
\ No newline at end of file
+}
+
+// tmx_convert loads images through these, so each image's resource ends up being the path
+// TMX_Load would have passed to tmx_img_load
+static void * TMX_ConvertImageLoad(const char *path) {
+	return strdup(path);
+}
+
+static void TMX_ConvertImageFree(void *address) {
+	free(address);
+}
+
+// the external tilesets read while converting, stored in the .tmxb so TMX_Load can tell when one
+// of them has changed
+static std::vector<std::string> convertDeps;
+
+static void * TMX_ConvertFileRead(const char *filename, int *outSz) {
+	convertDeps.push_back(TMX_FilePath(filename));
+	return tmx_fs(filename, outSz);
+}
+
+static void TMX_ResolveImage(tmx_image *img) {
+	if (img == nullptr || img->resource_image == nullptr) {
+		return;
+	}
+
+	const char *resolved = (const char*)img->resource_image;
+	char *source = (char*)tmx_alloc_func(nullptr, strlen(resolved) + 1);
+	strcpy(source, resolved);
+	tmx_free_func(img->source);
+	img->source = source;
+}
+
+static void TMX_ResolveLayerImages(tmx_layer *layer) {
+	for (; layer != nullptr; layer = layer->next) {
+		if (layer->type == L_IMAGE) {
+			TMX_ResolveImage(layer->content.image);
+		}
+		else if (layer->type == L_GROUP) {
+			TMX_ResolveLayerImages(layer->content.group_head);
+		}
+	}
+}
+
+// swaps image sources, which are relative to the file they came from, for the resolved path, since
+// a .tmxb doesn't know where its tilesets were loaded from
+static void TMX_ResolveImages(tmx_map *map) {
+	for (tmx_tileset_list *tsl = map->ts_head; tsl != nullptr; tsl = tsl->next) {
+		tmx_tileset *ts = tsl->tileset;
+		TMX_ResolveImage(ts->image);
+		for (unsigned int i = 0; i < ts->tilecount; i++) {
+			TMX_ResolveImage(ts->tiles[i].image);
+		}
+	}
+
+	TMX_ResolveLayerImages(map->ly_head);
+}
+
+// command handler for tmx_convert, writes the binary version of a map next to it
+static void Cmd_TMXConvert_f() {
+	if (Con_GetArgsCount() < 2) {
+		Con_Print("tmx_convert <map.tmx> [output] - write a .tmxb, which is loaded instead of the map while it's newer\n");
+		return;
+	}
+
+	const char *in = Con_GetArg(1);
+	std::string out = Con_GetArgsCount() > 2 ? Con_GetArg(2) : std::string(in) + "b";
+
+	void *xml;
+	int xmlSz = FS_ReadFile(in, &xml);
+	if (xmlSz < 0) {
+		Con_Printf("tmx_convert: couldn't read %s\n", in);
+		return;
+	}
+
+	tmx_img_load_func = &TMX_ConvertImageLoad;
+	tmx_img_free_func = &TMX_ConvertImageFree;
+	tmx_file_read_func = &TMX_ConvertFileRead;
+	convertDeps.clear();
+
+	auto start = std::chrono::steady_clock::now();
+	tmx_map *map = tmx_load_buffer((const char*)xml, xmlSz);
+	double xmlMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	free(xml);
+
+	if (map == nullptr) {
+		Con_Printf("tmx_convert: couldn't load %s: %s\n", in, tmx_strerr());
+		return;
+	}
+
+	TMX_ResolveImages(map);
+	std::vector<const char*> deps;
+	for (const std::string &dep : convertDeps) {
+		deps.push_back(dep.c_str());
+	}
+	int binSz;
+	void *bin = tmx_save_binary_deps(map, deps.data(), (int)deps.size(), &binSz);
+	tmx_map_free(map);
+
+	if (bin == nullptr) {
+		Con_Printf("tmx_convert: couldn't convert %s: %s\n", in, tmx_strerr());
+		return;
+	}
+
+	// load it back, mostly to make sure it works but also to show what it saves
+	start = std::chrono::steady_clock::now();
+	map = tmx_load_binary(bin, binSz);
+	double binMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if (map == nullptr) {
+		Con_Printf("tmx_convert: converted %s doesn't load: %s\n", in, tmx_strerr());
+		tmx_free_func(bin);
+		return;
+	}
+	tmx_map_free(map);
+
+	int written = FS_WriteFile(out.c_str(), bin, binSz);
+	tmx_free_func(bin);
+
+	if (written < 0) {
+		Con_Printf("tmx_convert: couldn't write %s\n", out.c_str());
+		return;
+	}
+
+	Con_Printf("wrote %s, %i bytes from %i bytes of xml. load time %.2fms -> %.2fms\n", out.c_str(), binSz, xmlSz, xmlMs, binMs);
+}
+
+// builds a map with lots of embedded tilesets, tile properties and object properties, which is
+// where libtmx leans on its hashtables the most
+static std::string TMX_BenchMap(int tilesets) {
+	const int tilesPerSet = 16;
+	std::string xml = "<map version=\"1.0\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"4\" height=\"4\" tilewidth=\"8\" tileheight=\"8\">\n";
+	xml += "<properties><property name=\"title\" value=\"bench\"/><property name=\"gravity\" type=\"float\" value=\"0.5\"/></properties>\n";
+
+	for (int ts = 0; ts < tilesets; ts++) {
+		xml += tempstr("<tileset firstgid=\"%i\" name=\"set%i\" tilewidth=\"8\" tileheight=\"8\" tilecount=\"%i\">\n", 1 + ts * tilesPerSet, ts, tilesPerSet);
+		for (int t = 0; t < tilesPerSet; t++) {
+			xml += tempstr("<tile id=\"%i\"><properties><property name=\"solid\" type=\"bool\" value=\"true\"/><property name=\"damage\" type=\"int\" value=\"%i\"/><property name=\"sound\" value=\"step%i\"/></properties></tile>\n", t, t, t % 4);
+		}
+		xml += "</tileset>\n";
+	}
+
+	xml += "<objectgroup name=\"objects\">\n";
+	for (int i = 0; i < tilesets * 4; i++) {
+		xml += tempstr("<object id=\"%i\" name=\"obj%i\" type=\"Thing\" x=\"%i\" y=\"0\" width=\"8\" height=\"8\"><properties><property name=\"speed\" type=\"float\" value=\"1.5\"/><property name=\"target\" value=\"obj%i\"/></properties></object>\n", i + 1, i, i * 8, i + 1);
+	}
+	xml += "</objectgroup>\n</map>\n";
+
+	return xml;
+}
+
+// command handler for tmx_bench, times loading, querying and freeing a generated map
+static void Cmd_TMXBench_f() {
+	int tilesets = Con_GetArgsCount() > 1 ? atoi(Con_GetArg(1)) : 200;
+	int iterations = Con_GetArgsCount() > 2 ? atoi(Con_GetArg(2)) : 20;
+	if (tilesets <= 0 || iterations <= 0) {
+		Con_Print("tmx_bench [tilesets] [iterations] - time loading a generated map with lots of properties\n");
+		return;
+	}
+
+	std::string xml = TMX_BenchMap(tilesets);
+	const char *keys[] = { "solid", "damage", "sound", "missing" };
+	double loadMs = 0, queryMs = 0, freeMs = 0;
+	int lookups = 0;
+	volatile int sink = 0;
+
+	for (int i = 0; i < iterations; i++) {
+		auto start = std::chrono::steady_clock::now();
+		tmx_map *map = tmx_load_buffer(xml.c_str(), (int)xml.size());
+		auto loaded = std::chrono::steady_clock::now();
+		if (map == nullptr) {
+			Con_Printf("tmx_bench: couldn't load the generated map: %s\n", tmx_strerr());
+			return;
+		}
+
+		for (unsigned int gid = 1; gid < map->tilecount; gid++) {
+			tmx_tile *tile = map->tiles[gid];
+			if (tile == nullptr || tile->properties == nullptr) {
+				continue;
+			}
+			for (int k = 0; k < 4; k++, lookups++) {
+				sink += tmx_get_property(tile->properties, keys[k]) != nullptr;
+			}
+		}
+
+		for (tmx_layer *layer = map->ly_head; layer != nullptr; layer = layer->next) {
+			if (layer->type != L_OBJGR) {
+				continue;
+			}
+			for (tmx_object *obj = layer->content.objgr->head; obj != nullptr; obj = obj->next, lookups += 2) {
+				sink += tmx_get_property(obj->properties, "speed") != nullptr;
+				sink += tmx_get_property(obj->properties, "missing") != nullptr;
+			}
+		}
+		auto queried = std::chrono::steady_clock::now();
+
+		tmx_map_free(map);
+		auto freed = std::chrono::steady_clock::now();
+
+		loadMs += std::chrono::duration<double, std::milli>(loaded - start).count();
+		queryMs += std::chrono::duration<double, std::milli>(queried - loaded).count();
+		freeMs += std::chrono::duration<double, std::milli>(freed - queried).count();
+	}
+
+	Con_Printf("%i tilesets, %i bytes of xml, %i iterations\n", tilesets, (int)xml.size(), iterations);
+	Con_Printf("load: %.2fms per map\n", loadMs / iterations);
+	Con_Printf("query: %.2fms per map, %.1fns per lookup\n", queryMs / iterations, queryMs * 1000000.0 / (lookups > 0 ? lookups : 1));
+	Con_Printf("free: %.2fms per map\n", freeMs / iterations);
+}
+
+void TMX_Init() {
+	Con_AddCommand("tmx_bench", Cmd_TMXBench_f);
+	Con_AddCommand("tmx_convert", Cmd_TMXConvert_f);
+
+	// in KB, decoded chunks of infinite maps past this are evicted, least recently used first
+	tmx_chunkMemory = Con_GetVarDefault("tmx.chunkMemory", "4096", 0);
+}
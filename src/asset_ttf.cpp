@@ -3,6 +3,7 @@
 #include "assetloader.h"
 #include "files.h"
 #include "console.h"
+#include "cvar_main.h"
 #include "external/fontstash.h"
 #include "external/gl3corefontstash.h"
 #include "rendercommands.h"
@@ -12,6 +13,19 @@ extern "C" {
 
 FONScontext *ctx;
 
+FONScontext* TTF_CreateContext() {
+	if (!eng_headless->integer) {
+		return glfonsCreate(512, 512, FONS_ZERO_TOPLEFT);
+	}
+
+	FONSparams params;
+	memset(&params, 0, sizeof(params));
+	params.width = 512;
+	params.height = 512;
+	params.flags = FONS_ZERO_TOPLEFT;
+	return fonsCreateInternal(&params);
+}
+
 enum TTFcodepointType {
 	TTF_SPACE,
 	TTF_NEWLINE,
@@ -33,7 +47,7 @@ void* TTF_Load(Asset &asset) {
 	TTFFont_t *fnt = new TTFFont_t();
 
 	if (ctx == nullptr) {
-		ctx = glfonsCreate(512, 512, FONS_ZERO_TOPLEFT);
+		ctx = TTF_CreateContext();
 	}
 
 	int found = fonsGetFontByName(ctx, asset.name);
@@ -52,7 +52,7 @@ static AssetLoadHandler_t assetHandler[ASSET_MAX] = {
 	{"mod", 0, nullptr, Sound_Load, Mod_Free, Sound_Inspect },
 	{"ttf", 0, nullptr, TTF_Load, TTF_Free },
 	{"bitmapfont", 0, BMPFNT_ParseINI, BMPFNT_Load, BMPFNT_Free, BMPFNT_Inspect },
-	{"tmx", 0, nullptr, TMX_Load, TMX_Free },
+	{"tmx", 0, nullptr, TMX_Load, TMX_Free, TMX_Inspect },
 	{"canvas", INIFLAGS_OPTIONALPATH, Canvas_ParseINI, Canvas_Load, Canvas_Free, Canvas_Inspect },
 	{"shader", INIFLAGS_OPTIONALPATH, Shader_ParseINI, Shader_Load, Shader_Free, Shader_Inspect },
 };
@@ -132,10 +132,56 @@ void Asset_Load(AssetHandle i) {
 	asset.loaded = true;
 }
 
+// queues reads of the files an asset's loader is going to ask for, so they come off the disk on the
+// io thread while the assets before it decode and upload
+static void Asset_Prefetch(Asset &asset) {
+	if (asset.loaded) {
+		return;
+	}
+
+	switch (asset.type) {
+		case ASSET_IMAGE:
+		case ASSET_SPRITE:
+		case ASSET_SOUND:
+		case ASSET_MOD:
+		case ASSET_FONT:
+		case ASSET_BITMAPFONT:
+			if (asset.path[0] != '\0') {
+				FS_Prefetch(asset.path, 0);
+			}
+			break;
+
+		case ASSET_TMX: {
+			// TMX_Load checks the .tmxb first when there is one
+			const char *binPath = tempstr("%sb", asset.path);
+			FS_Prefetch(FS_Exists(binPath) ? binPath : asset.path, 0);
+			break;
+		}
+
+		case ASSET_SHADER: {
+			ShaderAsset *shasset = (ShaderAsset*)asset.resource;
+			if (shasset != nullptr && shasset->isFile) {
+				FS_Prefetch(shasset->vs, 0);
+				FS_Prefetch(shasset->fs, 0);
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
 void Asset_LoadAll() {
+	for (int i = 0; i < assets.length; i++) {
+		Asset_Prefetch(assets.data[i]);
+	}
+
 	for (int i = 0; i < assets.length; i++) {
 		Asset_Load(i);
 	}
+
+	FS_ClearPrefetch();
 }
 
 void Asset_Unload(AssetHandle i) {
@@ -125,9 +125,46 @@ void Snd_PauseResume(unsigned int handle, bool pause);
 
 // TMX assets
 
+// tile layers of infinite maps. a grid of cols by rows chunks starting at the map's origin,
+// each entry is an index into layer->chunks or -1 where nothing was drawn
+typedef struct {
+	int cols, rows;
+	int *grid;
+} tmxChunkGrid_t;
+
+// lookup tables built once when an ASSET_TMX loads, so layers can be found by index without
+// walking the layer list. held in map->user_data.pointer, scripts get at it through info.
+typedef struct {
+	tmxMapInfo_t info; // the arrays it points at are owned by the index
+
+	tmx_layer **layers;
+	tmxLayerInfo_t *layerInfo; // same array as info.layers
+	tmxChunkGrid_t *chunkGrids;
+
+	// tiles with animations. animRemap has map->tilecount entries, mapping each gid to the gid that
+	// shows this frame, and is only rewritten for animGids once a frame. nullptr if nothing's animated.
+	int animCount;
+	unsigned int *animGids;
+	unsigned int *animRemap;
+	int64_t animFrame;
+} tmxMapIndex_t;
+
+// registers the tmx_bench and tmx_convert commands and the chunk memory cvar
+void TMX_Init();
 void * TMX_Load(Asset &asset);
 void TMX_Free(Asset &asset);
+void TMX_Inspect(Asset& asset, bool deselected);
 tmx_map* Get_TMX(AssetHandle id);
+// see SLT_TMX_GetInfo
+const tmxMapInfo_t* TMX_GetInfo(const tmx_map *map);
+// returns the layer at index, or nullptr if it's out of range
+tmx_layer* TMX_GetLayer(const tmx_map *map, int layer);
+// see SLT_TMX_GetChunk
+const int32_t* TMX_GetChunk(const tmx_map *map, int layer, int col, int row);
+// advances the clock tile animations run on, called once a frame
+void TMX_Tick(int64_t musec);
+// returns the map's gid remap table for the current frame, or nullptr if no tiles are animated
+const unsigned int* TMX_AnimRemap(const tmx_map *map);
 
 // canvas assets
 
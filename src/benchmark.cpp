@@ -0,0 +1,223 @@
+#include <SDL/SDL.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "console.h"
+#include "cvar_main.h"
+#include "main.h"
+#include "profiler.h"
+#include "rlgl.h"
+#include "benchmark.h"
+
+typedef enum {
+	BENCH_IDLE,
+	BENCH_LOADING, // waiting for the first frame to load the scene
+	BENCH_WARMUP, // the frame the scene loaded on, not counted
+	BENCH_RUNNING
+} benchState_t;
+
+// a profiler zone or game stat, summed per frame
+typedef struct {
+	std::string name;
+	double frame; // running total for the current frame
+	double total;
+	double max;
+} benchSeries_t;
+
+static benchState_t state = BENCH_IDLE;
+static std::string scene;
+static std::string reportPath;
+static int framesWanted;
+
+static std::vector<double> frameTimes; // ms
+static std::vector<benchSeries_t> zones; // ms
+static std::vector<benchSeries_t> stats;
+static benchSeries_t drawCalls;
+static int lastDrawCalls;
+static std::chrono::steady_clock::time_point lastFrameEnd;
+static std::chrono::steady_clock::time_point runStart;
+
+static benchSeries_t* Bench_FindSeries(std::vector<benchSeries_t> &list, const char *name) {
+	for (benchSeries_t &series : list) {
+		if (strcmp(series.name.c_str(), name) == 0) {
+			return &series;
+		}
+	}
+
+	list.push_back({ name, 0, 0, 0 });
+	return &list.back();
+}
+
+static void Bench_FinishFrame(benchSeries_t &series) {
+	series.total += series.frame;
+	series.max = series.frame > series.max ? series.frame : series.max;
+	series.frame = 0;
+}
+
+void Bench_AddStat(const char *name, double value) {
+	if (state != BENCH_RUNNING) {
+		return;
+	}
+
+	Bench_FindSeries(stats, name)->frame += value;
+}
+
+static void Bench_AddZone(const char *name, int depth, int64_t ns, void *userdata) {
+	(void)depth;
+	(void)userdata;
+	Bench_FindSeries(zones, name)->frame += ns / 1E6;
+}
+
+static void Bench_WriteString(FILE *f, const char *str) {
+	fputc('"', f);
+	for (const char *c = str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', f);
+		}
+		fputc(*c, f);
+	}
+	fputc('"', f);
+}
+
+static void Bench_WriteSeries(FILE *f, const benchSeries_t &series, int frames) {
+	fprintf(f, "{\"mean\":%.4f,\"max\":%.4f,\"total\":%.4f}", series.total / frames, series.max, series.total);
+}
+
+static void Bench_WriteSeriesList(FILE *f, const char *key, const std::vector<benchSeries_t> &list, int frames) {
+	fprintf(f, "  \"%s\": {", key);
+	for (size_t i = 0; i < list.size(); i++) {
+		fprintf(f, "%s\n    ", i > 0 ? "," : "");
+		Bench_WriteString(f, list[i].name.c_str());
+		fprintf(f, ": ");
+		Bench_WriteSeries(f, list[i], frames);
+	}
+	fprintf(f, "\n  }");
+}
+
+static void Bench_WriteReport() {
+	int frames = (int)frameTimes.size();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+	std::vector<double> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0;
+	for (double t : sorted) {
+		total += t;
+	}
+
+	FILE *f = fopen(reportPath.c_str(), "w");
+	if (f == nullptr) {
+		Con_Printf("benchmark: couldn't open %s for writing\n", reportPath.c_str());
+		return;
+	}
+
+	fprintf(f, "{\n  \"scene\": ");
+	Bench_WriteString(f, scene.c_str());
+	fprintf(f, ",\n  \"frames\": %i,\n  \"seconds\": %.4f,\n  \"nullRenderer\": %s,\n", frames, elapsed, vid_nullRenderer->integer ? "true" : "false");
+	fprintf(f, "  \"frameTime\": {\"min\":%.4f,\"mean\":%.4f,\"p50\":%.4f,\"p99\":%.4f,\"max\":%.4f},\n",
+		sorted[0], total / frames, sorted[frames / 2], sorted[frames * 99 / 100], sorted[frames - 1]);
+	fprintf(f, "  \"drawCalls\": ");
+	Bench_WriteSeries(f, drawCalls, frames);
+	fprintf(f, ",\n");
+	Bench_WriteSeriesList(f, "zones", zones, frames);
+	fprintf(f, ",\n");
+	Bench_WriteSeriesList(f, "stats", stats, frames);
+	fprintf(f, "\n}\n");
+	fclose(f);
+
+	Con_Printf("benchmark: %i frames of %s, mean %.3fms, p99 %.3fms, report written to %s\n", frames, scene.c_str(), total / frames, sorted[frames * 99 / 100], reportPath.c_str());
+}
+
+void Bench_StartFrame() {
+	if (state != BENCH_LOADING) {
+		return;
+	}
+
+	// scripts go through scene, anything else is a map, same as typing it in the console
+	const char *ext = strrchr(scene.c_str(), '.');
+	if (ext != nullptr && strcmp(ext, ".wren") == 0) {
+		Con_Execute(tempstr("scene %s\n", scene.c_str()));
+	}
+	else {
+		Con_Execute(tempstr("map %s\n", scene.c_str()));
+	}
+
+	state = BENCH_WARMUP;
+}
+
+void Bench_EndFrame() {
+	if (state == BENCH_IDLE || state == BENCH_LOADING) {
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	int calls = rlGetDrawCallCount();
+
+	if (state == BENCH_WARMUP) {
+		state = BENCH_RUNNING;
+		runStart = now;
+		lastFrameEnd = now;
+		lastDrawCalls = calls;
+		for (benchSeries_t &series : stats) {
+			series.frame = 0;
+		}
+		return;
+	}
+
+	frameTimes.push_back(std::chrono::duration<double, std::milli>(now - lastFrameEnd).count());
+	lastFrameEnd = now;
+
+	drawCalls.frame = calls - lastDrawCalls;
+	lastDrawCalls = calls;
+	Bench_FinishFrame(drawCalls);
+
+	Prof_EachFrameZone(&Bench_AddZone, nullptr);
+	for (benchSeries_t &series : zones) {
+		Bench_FinishFrame(series);
+	}
+	for (benchSeries_t &series : stats) {
+		Bench_FinishFrame(series);
+	}
+
+	if ((int)frameTimes.size() >= framesWanted) {
+		Bench_WriteReport();
+		state = BENCH_IDLE;
+		Prof_SetCapture(false);
+		Con_Execute("quit\n");
+	}
+}
+
+void Cmd_Benchmark_f() {
+	int argc = Con_GetArgsCount();
+	if (argc < 3 || argc > 4 || atoi(Con_GetArg(2)) <= 0) {
+		Con_Printf("benchmark <map or scene.wren> <frames> [report.json] - run frames as fast as possible, write a report, and quit\n");
+		return;
+	}
+
+	scene = Con_GetArg(1);
+	framesWanted = atoi(Con_GetArg(2));
+	reportPath = argc == 4 ? Con_GetArg(3) : "benchmark.json";
+
+	frameTimes.clear();
+	frameTimes.reserve(framesWanted);
+	zones.clear();
+	stats.clear();
+	drawCalls = { "draw calls", 0, 0, 0 };
+
+	// nothing should be holding the frame rate back
+	Con_SetVarHandle(vid_maxfps, "0");
+	Con_SetVarHandle(vid_swapinterval, "0");
+	SDL_GL_SetSwapInterval(0);
+
+	Prof_SetCapture(true);
+	state = BENCH_LOADING;
+
+	Con_Printf("benchmark: running %s for %i frames\n", scene.c_str(), framesWanted);
+}
+
+void Bench_Init() {
+	Con_AddCommand("benchmark", Cmd_Benchmark_f);
+}
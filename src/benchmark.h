@@ -0,0 +1,16 @@
+#pragma once
+
+// runs a scene or map for a fixed number of frames as fast as possible, then writes a json report
+// of frame times, per zone times, draw calls, and any stats the game sends in, and quits. usually
+// started from the command line: +benchmark maps/plat2.tmx 600
+void Bench_Init();
+
+// the scene is loaded at the start of the first frame, since game commands like map aren't
+// registered yet when the command line runs
+void Bench_StartFrame();
+
+// call at the end of the frame, before any frame rate limiting
+void Bench_EndFrame();
+
+// adds value to the named stat for the current frame. ignored unless a benchmark is running.
+void Bench_AddStat(const char *name, double value);
@@ -3,10 +3,18 @@
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
+#include <time.h>
 #include "../external/sds.h"
 
 conState_t *con;
 
+// names up to this long are lowercased on the stack during lookup, longer ones need a heap copy
+#define CON_VAR_KEY_LEN 128
+
+// counts lookups that had to allocate, reported by cvar_bench
+static int conVarLookupAllocs = 0;
+
 // Built in commands
 
 // command handler for echo, prints the text to the screen
@@ -123,6 +131,38 @@ void Cmd_Toggle_f() {
 	Con_SetVarFloat(varName, var->integer > 0.0f ? 0.0f : 1.0f);
 }
 
+// command handler for cvar_bench, times convar lookups by name against using the pointer directly
+void Cmd_CvarBench_f() {
+	int iterations = Con_GetArgsCount() > 1 ? atoi(Con_GetArg(1)) : 1000000;
+	if (iterations <= 0) {
+		Con_Print("cvar_bench [iterations] - time convar lookups\n");
+		return;
+	}
+
+	conVar_t *handle = Con_GetVarDefault("cvar_bench.var", "1", 0);
+	const char *names[] = { "cvar_bench.var", "CVar_Bench.Var" };
+	volatile int sink = 0;
+
+	for (int n = 0; n < 2; n++) {
+		int allocs = conVarLookupAllocs;
+		clock_t start = clock();
+		for (int i = 0; i < iterations; i++) {
+			sink += Con_GetVarInt(names[n]);
+		}
+		double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+		Con_Printf("by name \"%s\": %.2fms, %.1fns per lookup, %i heap allocations\n", names[n], ms, ms * 1000000.0 / iterations, conVarLookupAllocs - allocs);
+	}
+
+	clock_t start = clock();
+	for (int i = 0; i < iterations; i++) {
+		sink += handle->integer;
+	}
+	double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+	Con_Printf("by handle: %.2fms, %.1fns per lookup\n", ms, ms * 1000000.0 / iterations);
+
+	(void)sink;
+}
+
 // command handler for listcmds, prints all commands to console
 void Cmd_ListCmds_f() {
 	map_iter_t iter = map_iter(&con->cmds);
@@ -245,6 +285,7 @@ void Con_Init(conState_t *newCon) {
 	map_init(&newCon->vars);
 	map_init(&newCon->cmds);
 	vec_init(&newCon->binds);
+	vec_init(&newCon->bindButtons);
 	vec_init(&newCon->buttons);
 
 	Con_SetActive(newCon);
@@ -256,6 +297,7 @@ void Con_Init(conState_t *newCon) {
 	Con_AddCommand("toggle", Cmd_Toggle_f);
 	Con_AddCommand("reset", Cmd_Reset_f);
 	Con_AddCommand("vstr", Cmd_Vstr_f);
+	Con_AddCommand("cvar_bench", Cmd_CvarBench_f);
 
 	Con_AddCommand("listcmds", Cmd_ListCmds_f);
 
@@ -286,6 +328,7 @@ void Con_Shutdown() {
 		sdsfree(bind);
 	}
 	vec_deinit(&con->binds);
+	vec_deinit(&con->bindButtons);
 
 	i = 0;
 	buttonState_t *button;
@@ -380,12 +423,26 @@ void Con_RemoveCommand(const char *name) {
 
 // Con_RunCommand WILL free the passed string in
 static void Con_RunCommand(sds cmd) {
+	// handlers can run commands of their own (exec, demo_play), so put the outer command's
+	// args back once this one is done with them
+	sds outerCmd = con->cmd;
+	sds *outerArgv = con->argv;
+	int outerArgc = con->argc;
+	sds outerTempArgs = con->tempArgs;
+	con->tempArgs = NULL;
+
 	con->cmd = cmd;
 
 	// setup argv/argc. sdssplitargs will not split terms in quotes.
 	con->argv = sdssplitargs(con->cmd, &con->argc);
 
 	if (con->argc == 0) {
+		sdsfreesplitres(con->argv, con->argc);
+		sdsfree(con->cmd);
+		con->cmd = outerCmd;
+		con->argv = outerArgv;
+		con->argc = outerArgc;
+		con->tempArgs = outerTempArgs;
 		return;
 	}
 
@@ -408,7 +465,7 @@ static void Con_RunCommand(sds cmd) {
 			Con_Printf("\"%s\" is:\"%s" "\" default:\"%s" "\"\n", var->name, var->string, var->defaultValue);
 		}
 		else {
-			Con_SetVar(con->argv[0], Con_GetArgs(1));
+			Con_SetVarHandle(var, Con_GetArgs(1));
 		}
 		handled = true;
 	}
@@ -426,10 +483,10 @@ static void Con_RunCommand(sds cmd) {
 	sdsfreesplitres(con->argv, con->argc);
 	sdsfree(con->tempArgs);
 	sdsfree(con->cmd);
-	con->argv = NULL;
-	con->argc = 0;
-	con->tempArgs = NULL;
-	con->cmd = NULL;
+	con->argv = outerArgv;
+	con->argc = outerArgc;
+	con->tempArgs = outerTempArgs;
+	con->cmd = outerCmd;
 }
 
 // main entry point. takes a string, splits it up into individual cmomands (split by ; or newline) and
@@ -538,8 +595,32 @@ const char *Con_GetRawArgs() {
 
 // Convar handling
 
-// returns a convar, returning NULL if not existant.
+// returns a convar, returning NULL if not existant. keys are stored lowercase, so names that are
+// already lowercase are looked up directly and the rest are lowercased into a stack buffer.
 conVar_t *Con_GetVar(const char *name) {
+	char key[CON_VAR_KEY_LEN];
+	size_t len = 0;
+	bool lower = true;
+
+	for (const char *c = name; *c != '\0'; c++, len++) {
+		if (isupper((unsigned char)*c)) {
+			lower = false;
+		}
+		if (len < sizeof(key) - 1) {
+			key[len] = (char)tolower((unsigned char)*c);
+		}
+	}
+
+	if (lower) {
+		return map_get(&con->vars, name);
+	}
+
+	if (len < sizeof(key)) {
+		key[len] = '\0';
+		return map_get(&con->vars, key);
+	}
+
+	conVarLookupAllocs++;
 	sds sname = sdsnew(name);
 	sdstolower(sname);
 	conVar_t *var = map_get(&con->vars, sname);
@@ -582,11 +663,12 @@ conVar_t *Con_GetVarDefault(const char *name, const char *defaultValue, int flag
 		// clear the current string and reuse it
 		sdsclear(var->defaultValue);
 		var->defaultValue = sdscat(var->defaultValue, defaultValue);
-		var->flags &= ~CONVAR_USER;
+		// take on the registered flags so a latched convar can't be changed after this
+		var->flags = (var->flags & ~CONVAR_USER) | flags;
 
 		// if its ROM, overwrite the current value no matter what
 		if (flags & CONVAR_ROM) {
-			Con_SetVarForce(name, defaultValue);
+			Con_SetVarHandleForce(var, defaultValue);
 		}
 	}
 
@@ -626,6 +708,11 @@ conVar_t *Con_SetVar(const char *name, const char *value) {
 		return Con_GetVarDefault(name, value, CONVAR_USER);
 	}
 
+	return Con_SetVarHandle(var, value);
+}
+
+// same as Con_SetVar, but skips the name lookup for a convar that is already known
+conVar_t *Con_SetVarHandle(conVar_t *var, const char *value) {
 	const char *val = value == NULL ? "" : value;
 
 	// don't do anything if the value hasn't changed
@@ -647,7 +734,7 @@ conVar_t *Con_SetVar(const char *name, const char *value) {
 		return var;
 	}
 
-	return Con_SetVarForce(name, val);
+	return Con_SetVarHandleForce(var, val);
 }
 
 // shortcut to set a float value directly instead of turning it into a string
@@ -670,6 +757,11 @@ conVar_t *Con_SetVarForce(const char *name, const char *value) {
 		return NULL;
 	}
 
+	return Con_SetVarHandleForce(var, value);
+}
+
+// same as Con_SetVarForce, but skips the name lookup for a convar that is already known
+conVar_t *Con_SetVarHandleForce(conVar_t *var, const char *value) {
 	sdsclear(var->string);
 	var->string = sdscat(var->string, value);
 	var->value = strtof(value, NULL);
@@ -689,7 +781,7 @@ conVar_t *Con_ResetVar(const char *name) {
 		return NULL;
 	}
 
-	return Con_SetVar(name, var->defaultValue);
+	return Con_SetVarHandle(var, var->defaultValue);
 }
 
 // stores the passed in commandline so we can scan through it later and pull out convars and finally execute it all
@@ -763,14 +855,33 @@ void Con_SetVarFromStartup(const char * name) {
 // reserves the amount of space needed for keys, and sets all values to NULL
 void Con_AllocateKeys(int count) {
 	vec_reserve(&con->binds, count);
+	vec_reserve(&con->bindButtons, count);
 	for (int i = 0; i < count; i++) {
 		vec_push(&con->binds, NULL);
+		vec_push(&con->bindButtons, -1);
+	}
+}
+
+// finds the button a +command bind refers to, so key presses don't need to search by name
+static int Con_ResolveBindButton(const char *bind) {
+	if (bind == NULL || bind[0] != '+') {
+		return -1;
+	}
+
+	int buttonNum;
+	buttonState_t *button;
+	vec_foreach_ptr(&con->buttons, button, buttonNum) {
+		if (strcmp(button->name, &bind[1]) == 0) {
+			return buttonNum;
+		}
 	}
+
+	return -1;
 }
 
 // returns string binding for key. doesn't return NULL ever, just an empty string
 const char *Con_GetBindForKey(int key) {
-	if (key < 0 || key > con->binds.length) {
+	if (key < 0 || key >= con->binds.length) {
 		return "";
 	}
 
@@ -780,7 +891,7 @@ const char *Con_GetBindForKey(int key) {
 // main input handler, all user input should go through here instead of calling other functions directly
 void Con_HandleKeyPress(int key, bool down, int64_t time) {
 	// look up the binding, process it if its a button press
-	if (key < 0 || key > con->binds.capacity) {
+	if (key < 0 || key >= con->binds.length) {
 		Con_Printf("Con_HandleKeyPress: key %i out of range for vec length %i", key, con->binds.length);
 		return;
 	}
@@ -791,54 +902,52 @@ void Con_HandleKeyPress(int key, bool down, int64_t time) {
 	if (action == NULL) {
 		return;
 	}
-	// +commands are handled specially. search to see if there is a button by this game, and mark it as held
+	// +commands are handled specially. the button was resolved when the bind was set, mark it as held
 	else if (action[0] == '+') {
-		int buttonNum;
-		buttonState_t *button;
-
-		// go through each button to see if the name of the button matches the bind
-		vec_foreach_ptr(&con->buttons, button, buttonNum) {
-			if (strcmp(button->name, &action[1]) == 0) {
-				if (down) {
-					// put this key's id in the keysHeld array so we can track separate key presses
-					for (int i = 0; i < 8; i++) {
-						if (button->keysHeld[i] == 0) {
-							button->keysHeld[i] = key;
-							break;
-						}
-					}
-
-					// if this is the first press, mark it as held
-					if (button->held == false) {
-						button->timestamp = time;
-						button->wasPressed = true;
-						button->held = true;
-					}
+		int buttonNum = con->bindButtons.data[key];
+
+		// bound to a button that doesn't exist
+		if (buttonNum < 0) {
+			return;
+		}
+
+		buttonState_t *button = &con->buttons.data[buttonNum];
+		if (down) {
+			// put this key's id in the keysHeld array so we can track separate key presses
+			for (int i = 0; i < 8; i++) {
+				if (button->keysHeld[i] == 0) {
+					button->keysHeld[i] = key;
+					break;
 				}
-				else {
-					bool anyKeyHeld = false;
-
-					// look through the keys held for the key being let go
-					for (int i = 0; i < 8; i++) {
-						if (button->keysHeld[i] == key) {
-							button->keysHeld[i] = 0;
-						}
-
-						// if another key is still holding this button down, dont clear the button state
-						if (button->keysHeld[i] != 0) {
-							anyKeyHeld = true;
-						}
-					}
-
-					// no keys are holding this button down still, clear the button state
-					// don't unset wasPressed because user code can clear that at whatever frequency it wants
-					if (anyKeyHeld == false) {
-						button->held = false;
-						button->timestamp = false;
-					}
+			}
+
+			// if this is the first press, mark it as held
+			if (button->held == false) {
+				button->timestamp = time;
+				button->wasPressed = true;
+				button->held = true;
+			}
+		}
+		else {
+			bool anyKeyHeld = false;
+
+			// look through the keys held for the key being let go
+			for (int i = 0; i < 8; i++) {
+				if (button->keysHeld[i] == key) {
+					button->keysHeld[i] = 0;
 				}
 
-				break;
+				// if another key is still holding this button down, dont clear the button state
+				if (button->keysHeld[i] != 0) {
+					anyKeyHeld = true;
+				}
+			}
+
+			// no keys are holding this button down still, clear the button state
+			// don't unset wasPressed because user code can clear that at whatever frequency it wants
+			if (anyKeyHeld == false) {
+				button->held = false;
+				button->timestamp = false;
 			}
 		}
 	}
@@ -871,7 +980,7 @@ int Con_GetKeyForString(const char *key) {
 
 // takes the key id and binds it to the passed in console script, value
 void Con_SetBind(int key, const char *value) {
-	if (key < 0 || key > con->binds.capacity) {
+	if (key < 0 || key >= con->binds.length) {
 		return;
 	}
 
@@ -884,14 +993,17 @@ void Con_SetBind(int key, const char *value) {
 	}
 
 	con->binds.data[key] = sdscat(con->binds.data[key], value);
+	con->bindButtons.data[key] = Con_ResolveBindButton(con->binds.data[key]);
 }
 
 // removes a bind by freeing the string and resetting it to null so it can be properly detected as not bound
 void Con_RemoveBind(int key) {
-	if (key < 0 || key > con->binds.capacity) {
+	if (key < 0 || key >= con->binds.length) {
 		return;
 	}
 
+	con->bindButtons.data[key] = -1;
+
 	if (con->binds.data[key] != NULL) {
 		sdsfree(con->binds.data[key]);
 		con->binds.data[key] = NULL;
@@ -917,6 +1029,13 @@ void Con_AllocateButtons(const char **buttonNames, int buttonCount) {
 		newButton.name = sdsnew(buttonNames[i]);
 		vec_push(&con->buttons, newButton);
 	}
+
+	// button indexes may have changed, so point the existing binds at the new buttons
+	int key;
+	sds bind;
+	vec_foreach(&con->binds, bind, key) {
+		con->bindButtons.data[key] = Con_ResolveBindButton(bind);
+	}
 }
 
 // returns a pointer to a button. pointer should be stable as long as you don't call
@@ -80,6 +80,7 @@ typedef struct {
 	conVar_map_t vars; // map of var_name -> conVar_t for all known convars
 	conCmd_map_t cmds; // map of command name -> void(void) function receiver
 	vec_str_t binds; // array of key num -> sds string containing command to run on key press
+	vec_int_t bindButtons; // array of key num -> index into buttons for +button binds, -1 if not bound to a button
 	buttonState_vec_t buttons; // array of buttons, which are commands preceded by a + and track held state
 	conHandlers_t handlers; // see conHandlers_t, developer-specified handlers for various console events
 
@@ -150,7 +151,9 @@ const char *Con_GetArgs(int start);
 // useful if you just want to pass the whole set of arguments into somewhere else
 const char *Con_GetRawArgs();
 
-// finds and returns the named convar, returns NULL if not found
+// finds and returns the named convar, returns NULL if not found. convars are never freed or moved
+// until Con_Shutdown, so the returned pointer can be kept as a handle instead of looking it up
+// by name every time. lookups don't allocate for names shorter than 128 characters.
 conVar_t *Con_GetVar(const char *name);
 
 // finds and returns the named convar, returns a new var set to defaultValue if not found
@@ -180,6 +183,11 @@ conVar_t * Con_SetVarFloat(const char * name, float value);
 // skips all validation and forces the value to be set. convar must already exist.
 conVar_t * Con_SetVarForce(const char * name, const char * value);
 
+// same as Con_SetVar and Con_SetVarForce, but takes a convar handle (see Con_GetVar) instead of a
+// name, so no lookup is needed.
+conVar_t * Con_SetVarHandle(conVar_t *var, const char * value);
+conVar_t * Con_SetVarHandleForce(conVar_t *var, const char * value);
+
 // resets a convar to it's default value, using validation.
 conVar_t * Con_ResetVar(const char * name);
 
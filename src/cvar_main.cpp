@@ -15,11 +15,20 @@ conVar_t *vid_swapinterval;
 conVar_t *vid_fullscreen;
 conVar_t *vid_showfps;
 conVar_t *vid_maxfps;
+conVar_t *vid_pacing;
+conVar_t *vid_nullRenderer;
 conVar_t *eng_pause;
+conVar_t *eng_headless;
+conVar_t *eng_tickRate;
+conVar_t *eng_maxCatchup;
+conVar_t *eng_scene;
+conVar_t *eng_seed;
 conVar_t *snd_volume;
 conVar_t *debug_fontAtlas;
 conVar_t *debug_assets;
 conVar_t *debug_wrenInspector;
+conVar_t *con_logfile;
+conVar_t *debug_profiler;
 
 static conVarTable_t mainCvarTable[] = {
     { &eng_errorMessage, "engine.errorMessage", "", 0 },
@@ -30,11 +39,20 @@ static conVarTable_t mainCvarTable[] = {
     { &vid_fullscreen, "vid.fullscreen", "0", 0 },
     { &vid_showfps, "vid.showfps", "0", 0 },
 	{ &vid_maxfps, "vid.maxfps", "120", 0 },
+	{ &vid_pacing, "vid.pacing", "0", 0 },
+	{ &vid_nullRenderer, "vid.nullRenderer", "0", CONVAR_STARTUP },
 	{ &eng_pause, "engine.pause", "0", 0 },
+	{ &eng_headless, "engine.headless", "0", CONVAR_ROM },
+	{ &eng_tickRate, "engine.tickRate", "60", 0 },
+	{ &eng_maxCatchup, "engine.maxCatchup", "4", 0 },
+	{ &eng_scene, "engine.scene", "", 0 },
+	{ &eng_seed, "engine.seed", "0", 0 },
 	{ &snd_volume, "snd.volume", "1.0", 0 },
 	{ &debug_fontAtlas, "debug.fontAtlas", "0", 0 },
 	{ &debug_assets, "debug.assets", "0", 0 },
 	{ &debug_wrenInspector, "debug.wrenInspector", "0", 0 },
+	{ &con_logfile, "con.logFile", "", 0 },
+	{ &debug_profiler, "debug.profiler", "0", 0 },
 	{ NULL }
 };
 
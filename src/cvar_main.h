@@ -6,13 +6,22 @@ void RegisterMainCvars( void );
 extern conVar_t *eng_errorMessage;
 extern conVar_t *eng_lastErrorStack;
 extern conVar_t *vid_maxfps;
+extern conVar_t *vid_pacing;
+extern conVar_t *vid_nullRenderer;
 extern conVar_t *vid_width;
 extern conVar_t *vid_height;
 extern conVar_t *vid_swapinterval;
 extern conVar_t *vid_fullscreen;
 extern conVar_t *vid_showfps;
 extern conVar_t *eng_pause;
+extern conVar_t *eng_headless;
+extern conVar_t *eng_tickRate;
+extern conVar_t *eng_maxCatchup;
+extern conVar_t *eng_scene;
+extern conVar_t *eng_seed;
 extern conVar_t *snd_volume;
 extern conVar_t *debug_fontAtlas;
 extern conVar_t* debug_assets;
-extern conVar_t* debug_wrenInspector;
\ No newline at end of file
+extern conVar_t* debug_wrenInspector;
+extern conVar_t* con_logfile;
+extern conVar_t* debug_profiler;
\ No newline at end of file
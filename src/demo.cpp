@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <time.h>
+#include "console.h"
+#include "cvar_main.h"
+#include "demo.h"
+#include "timestep.h"
+
+#define DEMO_MAGIC 0x4d454453 // "SDEM"
+#define DEMO_VERSION 2
+#define DEMO_HEADER_SIZE 14
+#define DEMO_DOWN 0x8000
+
+// file layout, all little endian:
+// header: uint32 magic, uint32 version, uint32 engine.seed, uint16 length of engine.scene, then
+//         engine.scene without a terminator
+// frame: int32 frame time in microseconds, uint16 transition count, then that many uint16s of
+//        button index, with DEMO_DOWN set for presses
+
+typedef enum {
+	DEMO_IDLE,
+	DEMO_RECORDING,
+	DEMO_PLAYING
+} demoState_t;
+
+static demoState_t state = DEMO_IDLE;
+static char demoName[256];
+
+// recording
+static FILE *recordFile = nullptr;
+static std::vector<bool> lastHeld;
+static int32_t recordDt; // -1 until the first full frame, since recording starts partway through one
+
+// playback
+static uint8_t *playData = nullptr;
+static size_t playSize = 0;
+static size_t playPos = 0;
+static const uint16_t *playTransitions = nullptr;
+static int playTransitionCount = 0;
+static std::vector<int64_t> playFrameTimes; // real frame times, for the report at the end
+
+static void Demo_ReleaseButtons() {
+	buttonState_t *button;
+	for (int i = 0; (button = Con_GetButton(i)) != nullptr; i++) {
+		memset(button->keysHeld, 0, sizeof(button->keysHeld));
+		button->held = false;
+		button->timestamp = 0;
+	}
+}
+
+static void Demo_Report() {
+	if (playFrameTimes.size() < 2) {
+		return;
+	}
+
+	// the first frame time was measured before playback started
+	std::vector<int64_t> times(playFrameTimes.begin() + 1, playFrameTimes.end());
+	std::sort(times.begin(), times.end());
+
+	int64_t total = 0;
+	for (int64_t t : times) {
+		total += t;
+	}
+
+	size_t count = times.size();
+	Con_Printf("%s: %i frames in %.2fs, avg %.3fms, min %.3fms, p50 %.3fms, p95 %.3fms, p99 %.3fms, max %.3fms\n",
+		demoName, (int)count, total / 1E6, total / 1E3 / count, times[0] / 1E3, times[count / 2] / 1E3,
+		times[count * 95 / 100] / 1E3, times[count * 99 / 100] / 1E3, times[count - 1] / 1E3);
+}
+
+void Demo_Stop() {
+	if (state == DEMO_RECORDING) {
+		fclose(recordFile);
+		recordFile = nullptr;
+		Con_Printf("stopped recording %s\n", demoName);
+	}
+	else if (state == DEMO_PLAYING) {
+		Demo_Report();
+		free(playData);
+		playData = nullptr;
+		playFrameTimes.clear();
+		Demo_ReleaseButtons();
+		Con_Printf("finished playing %s\n", demoName);
+	}
+
+	state = DEMO_IDLE;
+}
+
+bool Demo_IsPlaying() {
+	return state == DEMO_PLAYING;
+}
+
+// sets the seed and runs the scene command, so recording and playback both start from a freshly
+// loaded scene instead of whatever state the game was in
+static void Demo_RestartScene(const std::string &scene, uint32_t seed) {
+	char seedStr[16];
+	snprintf(seedStr, sizeof(seedStr), "%u", seed);
+	Con_SetVar("engine.seed", seedStr);
+
+	if (scene.empty()) {
+		Con_Printf("WARNING: engine.scene isn't set, the demo starts from the current game state\n");
+		return;
+	}
+
+	Con_Execute(scene.c_str());
+}
+
+// reads the next frame into playTransitions, returns false at the end of the demo
+static bool Demo_ReadFrame(int32_t *dt) {
+	if (playPos + 6 > playSize) {
+		return false;
+	}
+
+	uint16_t count;
+	memcpy(dt, playData + playPos, 4);
+	memcpy(&count, playData + playPos + 4, 2);
+	playPos += 6;
+
+	if (playPos + count * 2 > playSize) {
+		Con_Printf("%s is truncated\n", demoName);
+		return false;
+	}
+
+	playTransitions = (const uint16_t *)(playData + playPos);
+	playTransitionCount = count;
+	playPos += count * 2;
+
+	return true;
+}
+
+void Demo_StartFrame(int64_t realMusec, int64_t *dt) {
+	if (state == DEMO_RECORDING) {
+		recordDt = (int32_t)*dt;
+	}
+	else if (state == DEMO_PLAYING) {
+		int32_t demoDt;
+		if (!Demo_ReadFrame(&demoDt)) {
+			Demo_Stop();
+			return;
+		}
+
+		playFrameTimes.push_back(realMusec);
+		*dt = demoDt;
+	}
+}
+
+void Demo_EndInput(int64_t frameTime) {
+	if (state == DEMO_RECORDING && recordDt >= 0) {
+		std::vector<uint16_t> transitions;
+		buttonState_t *button;
+		int i;
+
+		for (i = 0; (button = Con_GetButton(i)) != nullptr; i++) {
+			if (i >= (int)lastHeld.size()) {
+				lastHeld.push_back(false);
+			}
+
+			if (button->held != lastHeld[i]) {
+				transitions.push_back((uint16_t)i | (button->held ? DEMO_DOWN : 0));
+				lastHeld[i] = button->held;
+			}
+		}
+
+		// buttons were reallocated with fewer entries, forget the ones that went away
+		lastHeld.resize(i);
+
+		uint16_t count = (uint16_t)transitions.size();
+		fwrite(&recordDt, 4, 1, recordFile);
+		fwrite(&count, 2, 1, recordFile);
+		if (count > 0) {
+			fwrite(transitions.data(), 2, count, recordFile);
+		}
+	}
+	else if (state == DEMO_PLAYING) {
+		for (int i = 0; i < playTransitionCount; i++) {
+			uint16_t t;
+			memcpy(&t, &playTransitions[i], 2);
+
+			buttonState_t *button = Con_GetButton(t & ~DEMO_DOWN);
+			if (button == nullptr) {
+				continue;
+			}
+
+			if (t & DEMO_DOWN) {
+				button->held = true;
+				button->timestamp = frameTime;
+				button->wasPressed = true;
+			}
+			else {
+				button->held = false;
+				button->timestamp = 0;
+			}
+		}
+
+		playTransitionCount = 0;
+	}
+}
+
+void Cmd_Demo_Record_f() {
+	if (Con_GetArgsCount() != 2) {
+		Con_Printf("demo_record <file> - record frame times and button input to file until demo_stop\n");
+		return;
+	}
+
+	Demo_Stop();
+
+	snprintf(demoName, sizeof(demoName), "%s", Con_GetArg(1));
+	recordFile = fopen(demoName, "wb");
+	if (recordFile == nullptr) {
+		Con_Printf("couldn't open %s for writing\n", demoName);
+		return;
+	}
+
+	// running the scene command replaces the cvar with its own copy, so hang on to this one
+	std::string scene = eng_scene->string;
+	uint32_t seed = eng_seed->integer != 0 ? (uint32_t)eng_seed->integer : (uint32_t)time(nullptr);
+	uint16_t sceneLen = (uint16_t)std::min(scene.size(), (size_t)UINT16_MAX);
+	scene.resize(sceneLen);
+
+	uint32_t header[3] = { DEMO_MAGIC, DEMO_VERSION, seed };
+	fwrite(header, sizeof(header), 1, recordFile);
+	fwrite(&sceneLen, 2, 1, recordFile);
+	fwrite(scene.data(), 1, sceneLen, recordFile);
+
+	Demo_RestartScene(scene, seed);
+
+	// buttons already held when recording starts show up as presses on the first frame
+	lastHeld.clear();
+	recordDt = -1;
+	Tick_Reset();
+	state = DEMO_RECORDING;
+
+	Con_Printf("recording %s\n", demoName);
+}
+
+void Cmd_Demo_Play_f() {
+	if (Con_GetArgsCount() != 2) {
+		Con_Printf("demo_play <file> - play back a demo recorded with demo_record, ignoring real input\n");
+		return;
+	}
+
+	Demo_Stop();
+
+	snprintf(demoName, sizeof(demoName), "%s", Con_GetArg(1));
+	FILE *f = fopen(demoName, "rb");
+	if (f == nullptr) {
+		Con_Printf("couldn't open %s\n", demoName);
+		return;
+	}
+
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	uint8_t *data = (uint8_t *)malloc(size > 0 ? size : 1);
+	bool ok = size >= DEMO_HEADER_SIZE && fread(data, 1, size, f) == (size_t)size;
+	fclose(f);
+
+	uint32_t header[3] = { 0, 0, 0 };
+	uint16_t sceneLen = 0;
+	if (ok) {
+		memcpy(header, data, sizeof(header));
+		memcpy(&sceneLen, data + 12, 2);
+	}
+
+	if (!ok || header[0] != DEMO_MAGIC || header[1] != DEMO_VERSION || DEMO_HEADER_SIZE + (long)sceneLen > size) {
+		Con_Printf("%s is not a demo, or is from a different version\n", demoName);
+		free(data);
+		return;
+	}
+
+	std::string scene((const char *)data + DEMO_HEADER_SIZE, sceneLen);
+
+	// the scene is reloaded before any of the demo's state is set up, since loading it can
+	// run console commands of its own
+	Demo_RestartScene(scene, header[2]);
+
+	playData = data;
+	playSize = (size_t)size;
+	playPos = DEMO_HEADER_SIZE + sceneLen;
+	playTransitionCount = 0;
+	playFrameTimes.clear();
+
+	Demo_ReleaseButtons();
+	Tick_Reset();
+	state = DEMO_PLAYING;
+
+	Con_Printf("playing %s\n", demoName);
+}
+
+void Cmd_Demo_Stop_f() {
+	if (state == DEMO_IDLE) {
+		Con_Printf("no demo is recording or playing\n");
+		return;
+	}
+
+	Demo_Stop();
+}
+
+void Demo_Init() {
+	Con_AddCommand("demo_record", Cmd_Demo_Record_f);
+	Con_AddCommand("demo_play", Cmd_Demo_Play_f);
+	Con_AddCommand("demo_stop", Cmd_Demo_Stop_f);
+}
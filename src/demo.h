@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+
+// demos store the frame time and every button press and release for each frame. during playback
+// they replace both the wall clock and real input, so the same run can be repeated exactly.
+// the header keeps engine.scene and engine.seed, and both recording and playback set the seed and
+// run the scene command first, so they start from the same freshly loaded map.
+void Demo_Init();
+
+// call at the start of a frame with the measured frame time in microseconds. during playback dt
+// is replaced with the recorded frame time.
+void Demo_StartFrame(int64_t realMusec, int64_t *dt);
+
+// call once the frame's input events have been processed. records the button changes, or applies
+// the recorded ones during playback.
+void Demo_EndInput(int64_t frameTime);
+
+// real input should be ignored while this is true
+bool Demo_IsPlaying();
+
+// finishes any recording or playback
+void Demo_Stop();
@@ -429,6 +429,7 @@ void rlglClose(void);                           // De-inititialize rlgl (buffers
 void rlglDraw(void);                            // Update and draw default internal buffers
 
 int rlGetVersion(void);                         // Returns current OpenGL version
+int rlGetDrawCallCount(void);                   // Returns number of draw calls issued by rlglDraw() since startup
 bool rlCheckBufferLimit(int vCount);            // Check internal buffer overflow for a given number of vertex
 void rlSetDebugMarker(const char *text);        // Set debug marker for analysis
 void rlLoadExtensions(void *loader);            // Load OpenGL extensions
@@ -815,6 +816,7 @@ static bool useTransformMatrix = false;
 // Default buffers draw calls
 static DrawCall *draws = NULL;
 static int drawsCounter = 0;
+static int drawCallsTotal = 0;      // Draw calls actually sent to GL, for stats
 
 // Default texture (1px white) useful for plain color polys (required by shader)
 static unsigned int defaultTextureId;
@@ -1717,6 +1719,12 @@ void rlglDraw(void)
 #endif
 }
 
+// Returns number of draw calls issued by rlglDraw() since startup
+int rlGetDrawCallCount(void)
+{
+    return drawCallsTotal;
+}
+
 // Returns current OpenGL version
 int rlGetVersion(void)
 {
@@ -3984,6 +3992,8 @@ static void DrawBuffersDefault(void)
             {
                 glBindTexture(GL_TEXTURE_2D, draws[i].textureId);
 
+                if (draws[i].vertexCount > 0) drawCallsTotal++;
+
                 if ((draws[i].mode == RL_LINES) || (draws[i].mode == RL_TRIANGLES)) glDrawArrays(draws[i].mode, vertexOffset, draws[i].vertexCount);
                 else
                 {
@@ -1,13 +1,43 @@
 #include <physfs.h>
 #include <string.h>
+#include <string>
+#include <unordered_map>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define FS_NATIVE_MAP
+#elif !defined(__EMSCRIPTEN__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define FS_NATIVE_MAP
+#endif
 #include "slate2d.h"
 #include "console.h"
+#include "files.h"
 #include "main.h"
+extern "C" {
+#include "external/sds.h"
+}
 
 conVar_t *fs_basepath;
 conVar_t *fs_basegame;
 conVar_t *fs_game;
 
+// every file and directory visible through the search path, keyed by virtual path. physfs walks
+// every mount on each lookup, once this is built it answers exists/stat/open on its own: a path
+// that isn't in it doesn't exist, and loose files are opened straight from the mount they were
+// found in. it's dropped whenever the search path changes and rebuilt on the next lookup, and
+// FS_WriteFile and FS_RefreshFile keep single entries current. anything else changed on disk
+// needs an fs_reindex.
+static std::unordered_map<std::string, fileStat_t> fsIndex;
+static bool fsIndexBuilt = false;
+static bool fsIndexDirty = false;
+
+// whether each mount is an archive, keyed by the physfs owned mount string
+static std::unordered_map<const char*, bool> fsMountPacked;
+
 void Cmd_Dir_f() {
 	const char *path = Con_GetArgsCount() > 1 ? Con_GetArg(1) : "/";
 	char **rc = PHYSFS_enumerateFiles(path);
@@ -20,14 +50,234 @@ void Cmd_Dir_f() {
 	PHYSFS_freeList(rc);
 }
 
+// keys have no leading, trailing or doubled slashes, same as physfs sees them. the returned string is
+// reused so lookups don't allocate once it has grown to fit the longest path.
+static const std::string& FS_IndexKey(const char *path) {
+	static std::string key;
+	key.clear();
+
+	for (const char *c = path; *c != '\0'; c++) {
+		if (*c == '/' && (key.empty() || key.back() == '/')) {
+			continue;
+		}
+		key.push_back(*c);
+	}
+
+	if (!key.empty() && key.back() == '/') {
+		key.pop_back();
+	}
+
+	return key;
+}
+
+// anything that isn't a directory on disk is read through physfs
+static bool FS_MountIsPacked(const char *mount) {
+	if (mount == nullptr) {
+		return true;
+	}
+
+	auto it = fsMountPacked.find(mount);
+	if (it != fsMountPacked.end()) {
+		return it->second;
+	}
+
+#ifdef FS_NATIVE_MAP
+#ifdef _WIN32
+	DWORD attrs = GetFileAttributesA(mount);
+	bool packed = attrs == INVALID_FILE_ATTRIBUTES || !(attrs & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat st;
+	bool packed = stat(mount, &st) != 0 || !S_ISDIR(st.st_mode);
+#endif
+#else
+	bool packed = true;
+#endif
+
+	fsMountPacked[mount] = packed;
+	return packed;
+}
+
+static bool FS_PhysfsStat(const char *path, fileStat_t *stat) {
+	PHYSFS_Stat pstat;
+	if (PHYSFS_stat(path, &pstat) == 0 || (pstat.filetype != PHYSFS_FILETYPE_REGULAR && pstat.filetype != PHYSFS_FILETYPE_DIRECTORY)) {
+		return false;
+	}
+
+	stat->mount = PHYSFS_getRealDir(path);
+	stat->packed = FS_MountIsPacked(stat->mount);
+	stat->directory = pstat.filetype == PHYSFS_FILETYPE_DIRECTORY;
+	stat->size = pstat.filesize;
+	stat->modtime = pstat.modtime;
+	return true;
+}
+
+// asks physfs about path and brings its entry up to date, adding or removing it. returns the entry,
+// or null if nothing exists there.
+static fileStat_t* FS_IndexRefresh(const char *path) {
+	const std::string &key = FS_IndexKey(path);
+
+	fileStat_t stat;
+	if (!FS_PhysfsStat(key.c_str(), &stat)) {
+		fsIndex.erase(key);
+		return nullptr;
+	}
+
+	fileStat_t &entry = fsIndex[key];
+	entry = stat;
+	return &entry;
+}
+
+static void FS_IndexDirectory(const char *dir);
+
+// returns the cached entry for path, or null if it isn't in the index
+static fileStat_t* FS_IndexFind(const char *path) {
+	if (fsIndexDirty) {
+		FS_RebuildIndex();
+	}
+
+	auto it = fsIndex.find(FS_IndexKey(path));
+	return it != fsIndex.end() ? &it->second : nullptr;
+}
+
+static void FS_IndexDirectory(const char *dir) {
+	char **files = PHYSFS_enumerateFiles(dir);
+
+	for (char **i = files; *i != NULL; i++) {
+		sds fullPath = dir[0] == '\0' ? sdsnew(*i) : sdscatfmt(sdsempty(), "%s/%s", dir, *i);
+
+		fileStat_t entry;
+		if (!FS_PhysfsStat(fullPath, &entry)) {
+			sdsfree(fullPath);
+			continue;
+		}
+		fsIndex[fullPath] = entry;
+
+		if (entry.directory) {
+			FS_IndexDirectory(fullPath);
+		}
+
+		sdsfree(fullPath);
+	}
+
+	PHYSFS_freeList(files);
+}
+
+// rescans the whole search path, picking up files added or removed outside of the engine
+void FS_RebuildIndex() {
+	fsIndex.clear();
+	fsMountPacked.clear();
+	FS_IndexDirectory("");
+	fsIndexBuilt = true;
+	fsIndexDirty = false;
+}
+
+static void FS_InvalidateIndex() {
+	if (fsIndexBuilt) {
+		fsIndex.clear();
+		fsMountPacked.clear();
+		fsIndexDirty = true;
+	}
+}
+
+bool FS_Mount(const char *dir, const char *mountPoint, bool append) {
+	int ok = PHYSFS_mount(dir, mountPoint, append ? 1 : 0);
+	FS_InvalidateIndex();
+	return ok != 0;
+}
+
+bool FS_Unmount(const char *dir) {
+	int ok = PHYSFS_unmount(dir);
+	FS_InvalidateIndex();
+	return ok != 0;
+}
+
+bool FS_Stat(const char *path, fileStat_t *stat) {
+	if (!fsIndexBuilt) {
+		return FS_PhysfsStat(path, stat);
+	}
+
+	fileStat_t *entry = FS_IndexFind(path);
+	if (entry == nullptr) {
+		return false;
+	}
+
+	*stat = *entry;
+	return true;
+}
+
+void FS_RefreshFile(const char *path) {
+	if (!fsIndexBuilt) {
+		return;
+	}
+
+	if (fsIndexDirty) {
+		FS_RebuildIndex();
+	}
+
+	FS_IndexRefresh(path);
+}
+
 bool FS_Exists(const char *file) {
-	if (PHYSFS_exists(file)) {
-		if (!PHYSFS_isDirectory(file)) {
-			return true;
+	if (!fsIndexBuilt) {
+		return PHYSFS_exists(file) && !PHYSFS_isDirectory(file);
+	}
+
+	fileStat_t *entry = FS_IndexFind(file);
+	return entry != nullptr && !entry->directory;
+}
+
+// physfs can only read, so this writes to the directory path already resolves to, or the game's own
+// directory for new files, and updates the index entry. the directory path is in has to exist.
+int FS_WriteFile(const char *path, const void *data, int size) {
+	fileStat_t *entry = fsIndexBuilt ? FS_IndexFind(path) : nullptr;
+	const char *gameDir = fs_game->string[0] != '\0' ? fs_game->string : fs_basegame->string;
+	std::string dirs[] = { entry != nullptr ? entry->mount : "", std::string(fs_basepath->string) + "/" + gameDir };
+
+	for (const std::string &dir : dirs) {
+		if (dir.empty()) {
+			continue;
+		}
+
+		// archives are mounts too, opening a path inside of one fails and moves on to the game dir
+		std::string realPath = dir + "/" + FS_IndexKey(path);
+		FILE *f = fopen(realPath.c_str(), "wb");
+		if (f == nullptr) {
+			continue;
 		}
+
+		size_t written = fwrite(data, 1, (size_t)size, f);
+		fclose(f);
+
+		if (fsIndexBuilt) {
+			FS_IndexRefresh(path);
+		}
+
+		if (written != (size_t)size) {
+			Con_Printf("FS_WriteFile: couldn't write %s\n", realPath.c_str());
+			return -1;
+		}
+
+		return size;
 	}
-	
-	return false;
+
+	Con_Printf("FS_WriteFile: couldn't open %s for writing\n", path);
+	return -1;
+}
+
+void Cmd_FS_Reindex_f() {
+	FS_RebuildIndex();
+
+	int files = 0, dirs = 0;
+	for (auto &entry : fsIndex) {
+		if (entry.second.directory) {
+			dirs++;
+		}
+		else {
+			files++;
+		}
+	}
+
+	Con_Printf("indexed %i files in %i directories\n", files, dirs);
 }
 
 char** FS_List(const char *path) {
@@ -50,7 +300,7 @@ void FS_AddPaksFromList(char **list, const char *basePath, const char *gamePath)
 		if ((l > extlen) && ((*i)[l - extlen - 1] == '.')) {
 			ext = (*i) + (l - extlen);
 			if (strcasecmp(ext, archiveExt) == 0) {
-				PHYSFS_mount(tempstr("%s/%s/%s", basePath, gamePath, *i), "/", 1);
+				FS_Mount(tempstr("%s/%s/%s", basePath, gamePath, *i), "/", true);
 			}
 		}
 	}
@@ -80,25 +330,25 @@ void FS_Init(const char *argv0) {
 
 	// get the file listing for the basegame dir, then immediately unmount
 	const char *fullBasePath = tempstr("%s/%s", fs_basepath->string, fs_basegame->string);
-	PHYSFS_mount(fullBasePath, "/", 1);
+	FS_Mount(fullBasePath, "/", true);
 	baseFiles = PHYSFS_enumerateFiles("/");
-	PHYSFS_removeFromSearchPath(fullBasePath);
+	FS_Unmount(fullBasePath);
 
 	// if fs_game is set, do the same thing for the fs_game dir
 	if (modLoaded) {
 		const char *fullGamePath = tempstr("%s/%s", fs_basepath->string, fs_game->string);
-		PHYSFS_mount(fullGamePath, "/", 1);
+		FS_Mount(fullGamePath, "/", true);
 		gameFiles = PHYSFS_enumerateFiles("/");
-		PHYSFS_removeFromSearchPath(fullGamePath);
+		FS_Unmount(fullGamePath);
 
 		// mount the mod dir first, then mount mod PK3s
-		PHYSFS_mount(tempstr("%s/%s", fs_basepath->string, fs_game->string), "/", 1);
+		FS_Mount(tempstr("%s/%s", fs_basepath->string, fs_game->string), "/", true);
 		FS_AddPaksFromList(gameFiles, fs_basepath->string, fs_game->string);
 		PHYSFS_freeList(gameFiles);
 	}
 
 	// then mount the base game dir, then the mount base game PK3s
-	PHYSFS_mount(tempstr("%s/%s", fs_basepath->string, fs_basegame->string), "/", 1);
+	FS_Mount(tempstr("%s/%s", fs_basepath->string, fs_basegame->string), "/", true);
 	FS_AddPaksFromList(baseFiles, fs_basepath->string, fs_basegame->string);
 	PHYSFS_freeList(baseFiles);
 
@@ -109,9 +359,90 @@ void FS_Init(const char *argv0) {
 
 	// add command handler for dir to view virtual filesystem
 	Con_AddCommand("dir", Cmd_Dir_f);
+	Con_AddCommand("fs_reindex", Cmd_FS_Reindex_f);
+
+	// build the lookup index now that the search path is final
+	Cmd_FS_Reindex_f();
+
+	FS_AsyncInit();
+}
+
+// opens a loose file through the mount it was indexed under, skipping the search path walk in
+// PHYSFS_openRead. returns null for packed files, and for anything before the index is built.
+static FILE* FS_OpenLoose(const char *path, const fileStat_t *entry) {
+	if (entry == nullptr || entry->packed) {
+		return nullptr;
+	}
+
+	std::string nativePath = std::string(entry->mount) + "/" + FS_IndexKey(path);
+	return fopen(nativePath.c_str(), "rb");
+}
+
+// the size comes from the open file rather than the index, in case it changed on disk
+static int64_t FS_LooseLength(FILE *f) {
+	if (fseek(f, 0, SEEK_END) != 0) {
+		return -1;
+	}
+
+	int64_t sz = ftell(f);
+	rewind(f);
+	return sz;
+}
+
+fsLocation_t FS_Locate(const char *path, char **nativePath) {
+	*nativePath = nullptr;
+
+	if (!fsIndexBuilt) {
+		return FS_PACKED;
+	}
+
+	fileStat_t *entry = FS_IndexFind(path);
+	if (entry == nullptr || entry->directory) {
+		return FS_MISSING;
+	}
+
+	if (entry->packed) {
+		return FS_PACKED;
+	}
+
+	std::string native = std::string(entry->mount) + "/" + FS_IndexKey(path);
+	*nativePath = strdup(native.c_str());
+	return FS_LOOSE;
 }
 
 int FS_ReadFile(const char *path, void **buffer) {
+	int prefetched;
+	if (buffer != nullptr && FS_TakePrefetch(path, buffer, &prefetched)) {
+		return prefetched;
+	}
+
+	fileStat_t *entry = fsIndexBuilt ? FS_IndexFind(path) : nullptr;
+
+	if (fsIndexBuilt && (entry == nullptr || entry->directory)) {
+		return -1;
+	}
+
+	if (entry != nullptr && !entry->packed) {
+		// deleted since it was indexed if this fails
+		FILE *f = FS_OpenLoose(path, entry);
+		if (f == nullptr) {
+			return -1;
+		}
+
+		int64_t sz = FS_LooseLength(f);
+		if (sz < 0 || sz > INT32_MAX - 1 || buffer == nullptr) {
+			fclose(f);
+			return sz <= INT32_MAX - 1 ? (int)sz : -1;
+		}
+
+		*buffer = malloc((size_t)sz + 1);
+		size_t read_sz = fread(*buffer, 1, (size_t)sz, f);
+		fclose(f);
+
+		((char *)*buffer)[read_sz] = '\0';
+		return (int)read_sz;
+	}
+
 	auto f = PHYSFS_openRead(path);
 
 	if (f == nullptr) {
@@ -120,18 +451,23 @@ int FS_ReadFile(const char *path, void **buffer) {
 
 	auto sz = PHYSFS_fileLength(f);
 
-	if (buffer == nullptr) {
+	if (sz < 0 || buffer == nullptr) {
+		PHYSFS_close(f);
 		return (int)sz;
 	}
 	
+	// only the terminator needs clearing, everything before it is about to be overwritten
 	*buffer = malloc((size_t)sz+1);
-	memset(*buffer, 0, (size_t)sz + 1);
 
 	auto read_sz = PHYSFS_read(f, *buffer, (PHYSFS_uint32)1, (PHYSFS_uint32)sz);
 
 	if (read_sz == -1) {
 		auto lastErr = PHYSFS_getLastError();
 		Con_Printf("FS err: %s", lastErr);
+		((char *)*buffer)[0] = '\0';
+	}
+	else {
+		((char *)*buffer)[read_sz] = '\0';
 	}
 
 	PHYSFS_close(f);
@@ -139,6 +475,194 @@ int FS_ReadFile(const char *path, void **buffer) {
 	return (int)read_sz;
 }
 
+// reads a file into the free space at the end of arena instead of making a new allocation. the contents
+// are null terminated and arena->used is moved past them. returns -1 if the file is missing or won't fit.
+int FS_ReadFileInto(const char *path, fileArena_t *arena, void **buffer) {
+	void *prefetched;
+	int prefetchedSz;
+	if (FS_TakePrefetch(path, &prefetched, &prefetchedSz)) {
+		if (prefetchedSz < 0 || arena->used + (size_t)prefetchedSz + 1 > arena->capacity) {
+			Con_Printf("FS_ReadFileInto: %s (%i bytes) doesn't fit in arena (%zu free)\n", path, prefetchedSz, arena->capacity - arena->used);
+			free(prefetched);
+			return -1;
+		}
+
+		*buffer = arena->data + arena->used;
+		memcpy(*buffer, prefetched, (size_t)prefetchedSz + 1);
+		arena->used += (size_t)prefetchedSz + 1;
+		free(prefetched);
+		return prefetchedSz;
+	}
+
+	fileStat_t *entry = fsIndexBuilt ? FS_IndexFind(path) : nullptr;
+
+	if (fsIndexBuilt ? (entry == nullptr || entry->directory) : !FS_Exists(path)) {
+		return -1;
+	}
+
+	FILE *loose = FS_OpenLoose(path, entry);
+	PHYSFS_File *f = loose == nullptr && (entry == nullptr || entry->packed) ? PHYSFS_openRead(path) : nullptr;
+
+	if (loose == nullptr && f == nullptr) {
+		return -1;
+	}
+
+	int64_t sz = loose != nullptr ? FS_LooseLength(loose) : PHYSFS_fileLength(f);
+
+	if (sz < 0 || arena->used + (size_t)sz + 1 > arena->capacity) {
+		Con_Printf("FS_ReadFileInto: %s (%lld bytes) doesn't fit in arena (%zu free)\n", path, (long long)sz, arena->capacity - arena->used);
+		if (loose != nullptr) {
+			fclose(loose);
+		}
+		else {
+			PHYSFS_close(f);
+		}
+		return -1;
+	}
+
+	uint8_t *dest = arena->data + arena->used;
+	int64_t read_sz;
+	if (loose != nullptr) {
+		read_sz = (int64_t)fread(dest, 1, (size_t)sz, loose);
+		fclose(loose);
+	}
+	else {
+		read_sz = PHYSFS_readBytes(f, dest, (PHYSFS_uint64)sz);
+		PHYSFS_close(f);
+	}
+
+	if (read_sz == -1) {
+		Con_Printf("FS err: %s", PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+		return -1;
+	}
+
+	dest[read_sz] = '\0';
+	arena->used += (size_t)read_sz + 1;
+	*buffer = dest;
+
+	return (int)read_sz;
+}
+
+// used when a file can't be mapped directly, either because it's packed in an archive or
+// the platform doesn't support it. FS_UnmapFile will free the buffer.
+static int FS_MapFileFallback(const char *path, fileMapping_t *mapping) {
+	mapping->mapped = false;
+	mapping->size = FS_ReadFile(path, &mapping->data);
+
+	if (mapping->size < 0) {
+		mapping->data = nullptr;
+	}
+
+	return mapping->size;
+}
+
+int FS_MapFile(const char *path, fileMapping_t *mapping) {
+	memset(mapping, 0, sizeof(*mapping));
+
+	// already read on the io thread, FS_UnmapFile frees it like any other unmapped file
+	if (FS_TakePrefetch(path, &mapping->data, &mapping->size)) {
+		if (mapping->size < 0) {
+			mapping->data = nullptr;
+		}
+		return mapping->size;
+	}
+
+#ifdef FS_NATIVE_MAP
+	// only loose files in a mounted directory can be mapped, packed ones are read out of the archive.
+	// only the mount is needed, the size comes from the native handle
+	fileStat_t stat;
+	fileStat_t *entry = fsIndexBuilt ? FS_IndexFind(path) : (FS_PhysfsStat(path, &stat) ? &stat : nullptr);
+	if (entry == nullptr || entry->directory || entry->mount == nullptr) {
+		return -1;
+	}
+
+	if (entry->packed) {
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	const char *nativePath = tempstr("%s/%s", entry->mount, FS_IndexKey(path).c_str());
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(nativePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	LARGE_INTEGER sz;
+	if (!GetFileSizeEx(file, &sz) || sz.QuadPart == 0 || sz.QuadPart > INT32_MAX) {
+		CloseHandle(file);
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	// the view keeps the mapping object alive, so both handles can be closed right away
+	HANDLE fileMap = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (fileMap == NULL) {
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	void *data = MapViewOfFile(fileMap, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(fileMap);
+	if (data == NULL) {
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	mapping->size = (int)sz.QuadPart;
+#else
+	int fd = open(nativePath, O_RDONLY);
+	if (fd == -1) {
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size > INT32_MAX) {
+		close(fd);
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return FS_MapFileFallback(path, mapping);
+	}
+
+	mapping->size = (int)st.st_size;
+#endif
+
+	mapping->data = data;
+	mapping->mapped = true;
+
+	return mapping->size;
+#else
+	return FS_MapFileFallback(path, mapping);
+#endif
+}
+
+void FS_UnmapFile(fileMapping_t *mapping) {
+	if (mapping->data == nullptr) {
+		return;
+	}
+
+#ifdef FS_NATIVE_MAP
+	if (mapping->mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(mapping->data);
+#else
+		munmap(mapping->data, (size_t)mapping->size);
+#endif
+	}
+	else {
+		free(mapping->data);
+	}
+#else
+	free(mapping->data);
+#endif
+
+	mapping->data = nullptr;
+	mapping->size = 0;
+	mapping->mapped = false;
+}
+
 const char *FS_FileExtension(const char *filename) {
     const char *dot = strrchr(filename, '.');
 	
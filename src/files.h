@@ -1,13 +1,79 @@
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
 #include "console.h"
 
 extern conVar_t *fs_basepath;
 extern conVar_t *fs_basegame;
 extern conVar_t *fs_game;
 
+// a read only view of a whole file. loose files on disk are memory mapped, files inside of
+// archives are read into a buffer. either way, release it with FS_UnmapFile.
+typedef struct {
+	void *data; // file contents, not null terminated
+	int size; // length of data in bytes
+	bool mapped; // true if data is a memory mapping, false if it was read into a malloc'd buffer
+} fileMapping_t;
+
+// caller owned block of memory that FS_ReadFileInto reads into. set used back to 0 to reuse it.
+typedef struct {
+	uint8_t *data;
+	size_t capacity;
+	size_t used;
+} fileArena_t;
+
+// cached info about a path in the virtual filesystem, see FS_Stat
+typedef struct {
+	const char *mount; // search path entry the path resolves to, owned by physfs
+	bool packed; // true if mount is an archive rather than a directory on disk
+	bool directory;
+	int64_t size;
+	int64_t modtime;
+} fileStat_t;
+
+// where a read of a path will be served from, see FS_Locate
+typedef enum {
+	FS_MISSING,
+	FS_LOOSE,
+	FS_PACKED,
+} fsLocation_t;
+
+// called on the main thread from FS_AsyncTick once an async read finishes. size is -1 if the file
+// couldn't be opened. buffer is null terminated and freed after the callback returns.
+typedef void(*fsReadCallback_t)(int request, const char *path, const void *buffer, int size, void *userdata);
+
 void FS_Init(const char *argv0);
 int FS_ReadFile(const char *path, void **buffer);
+int FS_ReadFileInto(const char *path, fileArena_t *arena, void **buffer);
+int FS_MapFile(const char *path, fileMapping_t *mapping);
+void FS_UnmapFile(fileMapping_t *mapping);
+int FS_WriteFile(const char *path, const void *data, int size);
 bool FS_Exists(const char *file);
+bool FS_Stat(const char *path, fileStat_t *stat);
+// re-reads path's entry from disk after it changed outside of the engine
+void FS_RefreshFile(const char *path);
+// use these instead of PHYSFS_mount/unmount so the index is rebuilt for the new search path
+bool FS_Mount(const char *dir, const char *mountPoint, bool append);
+bool FS_Unmount(const char *dir);
+void FS_RebuildIndex();
+// FS_LOOSE sets nativePath to a malloc'd path on disk. FS_PACKED means the read has to go through physfs,
+// which is also the answer for everything before the index is built.
+fsLocation_t FS_Locate(const char *path, char **nativePath);
 char** FS_List(const char *path);
 void FS_FreeList(void * listVar);
-const char *FS_FileExtension(const char *filename);
\ No newline at end of file
+const char *FS_FileExtension(const char *filename);
+
+// async reads are served by an io thread, highest priority first, then in the order they were queued.
+// returns a request id that can be passed to FS_CancelAsync.
+void FS_AsyncInit();
+void FS_AsyncShutdown();
+void FS_AsyncTick();
+int FS_ReadAsync(const char *path, int priority, fsReadCallback_t callback, void *userdata);
+bool FS_CancelAsync(int request);
+// queues a read that's handed to the next FS_ReadFile, FS_ReadFileInto or FS_MapFile of the same path instead
+// of a callback. the asset loader uses these so files are read on the io thread while earlier assets decode.
+void FS_Prefetch(const char *path, int priority);
+// takes the prefetched contents of path, waiting if they're still being read. false if path wasn't prefetched.
+bool FS_TakePrefetch(const char *path, void **buffer, int *size);
+// drops prefetches nothing asked for
+void FS_ClearPrefetch();
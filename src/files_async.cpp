@@ -0,0 +1,473 @@
+#include <SDL/SDL.h>
+#include <physfs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "console.h"
+#include "files.h"
+#include "main.h"
+#include "profiler.h"
+
+// emscripten builds don't have threads, requests are read during FS_AsyncTick instead
+#if !defined(__EMSCRIPTEN__)
+#define FS_ASYNC_THREAD
+#endif
+
+typedef struct {
+	int id;
+	int priority;
+	char *path;
+	char *nativePath; // set for loose files, read without going through physfs
+	bool missing; // not in the file index, fails without touching the disk
+	fsReadCallback_t callback; // null for prefetches, which wait in completed for FS_TakePrefetch
+	void *userdata;
+	bool cancelled;
+
+	void *buffer;
+	int size;
+
+	uint64_t queued; // performance counter timestamps
+	uint64_t started;
+	uint64_t finished;
+} fsAsyncRequest_t;
+
+typedef vec_t(fsAsyncRequest_t*) fsAsyncRequest_vec_t;
+
+static fsAsyncRequest_vec_t pending;
+static fsAsyncRequest_vec_t completed;
+static fsAsyncRequest_t *inFlight = nullptr;
+static int nextRequestId = 1;
+
+static SDL_mutex *lock = nullptr;
+static SDL_cond *wake = nullptr;
+static SDL_cond *finished = nullptr; // signalled whenever a request lands in completed
+static SDL_Thread *thread = nullptr;
+static bool running = false;
+
+// only touched on the main thread
+static struct {
+	int requests;
+	int completed;
+	int cancelled;
+	int failed;
+	int64_t bytes;
+	double latencyTotal; // ms from FS_ReadAsync to the callback
+	double latencyMax;
+	double readTotal; // ms the io thread spent reading
+} stats;
+
+static double FS_AsyncMs(uint64_t start, uint64_t end) {
+	return (double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static void FS_AsyncFree(fsAsyncRequest_t *req) {
+	free(req->buffer);
+	free(req->path);
+	free(req->nativePath);
+	free(req);
+}
+
+// picks the highest priority request, ties go to whichever was queued first. must hold the lock.
+static fsAsyncRequest_t* FS_AsyncPop() {
+	if (pending.length == 0) {
+		return nullptr;
+	}
+
+	int best = 0;
+	for (int i = 1; i < pending.length; i++) {
+		if (pending.data[i]->priority > pending.data[best]->priority) {
+			best = i;
+		}
+	}
+
+	fsAsyncRequest_t *req = pending.data[best];
+	vec_splice(&pending, best, 1);
+	return req;
+}
+
+// runs on the io thread, so no console calls in here
+static void FS_AsyncRead(fsAsyncRequest_t *req) {
+	PROFILE_ZONE("fs read");
+	req->started = SDL_GetPerformanceCounter();
+	req->buffer = nullptr;
+	req->size = -1;
+
+	if (req->missing) {
+		req->finished = SDL_GetPerformanceCounter();
+		return;
+	}
+
+	if (req->nativePath != nullptr) {
+		FILE *f = fopen(req->nativePath, "rb");
+		long sz = f != nullptr && fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+		req->buffer = sz >= 0 && sz < INT32_MAX ? malloc((size_t)sz + 1) : nullptr;
+		if (req->buffer != nullptr) {
+			rewind(f);
+			size_t read = fread(req->buffer, 1, (size_t)sz, f);
+			((char*)req->buffer)[read] = '\0';
+			req->size = (int)read;
+		}
+		if (f != nullptr) {
+			fclose(f);
+		}
+
+		req->finished = SDL_GetPerformanceCounter();
+		return;
+	}
+
+	PHYSFS_File *f = PHYSFS_openRead(req->path);
+	if (f != nullptr) {
+		// the length can't be determined for some archive entries, and sizes have to fit in an int
+		PHYSFS_sint64 sz = PHYSFS_fileLength(f);
+		req->buffer = sz >= 0 && sz < INT32_MAX ? malloc((size_t)sz + 1) : nullptr;
+		PHYSFS_sint64 read = req->buffer != nullptr ? PHYSFS_readBytes(f, req->buffer, (PHYSFS_uint64)sz) : -1;
+		PHYSFS_close(f);
+
+		if (req->buffer != nullptr && read == sz) {
+			((char*)req->buffer)[sz] = '\0';
+			req->size = (int)sz;
+		}
+		else {
+			free(req->buffer);
+			req->buffer = nullptr;
+		}
+	}
+
+	req->finished = SDL_GetPerformanceCounter();
+}
+
+#ifdef FS_ASYNC_THREAD
+static int FS_AsyncThread(void *ptr) {
+	NOTUSED(ptr);
+	Prof_SetThreadName("fsasync");
+
+	SDL_LockMutex(lock);
+	while (running) {
+		fsAsyncRequest_t *req = FS_AsyncPop();
+		if (req == nullptr) {
+			SDL_CondWait(wake, lock);
+			continue;
+		}
+
+		inFlight = req;
+		SDL_UnlockMutex(lock);
+
+		FS_AsyncRead(req);
+
+		SDL_LockMutex(lock);
+		inFlight = nullptr;
+		vec_push(&completed, req);
+		SDL_CondBroadcast(finished);
+	}
+	SDL_UnlockMutex(lock);
+
+	return 0;
+}
+#endif
+
+static int FS_AsyncQueue(const char *path, int priority, fsReadCallback_t callback, void *userdata) {
+	if (lock == nullptr) {
+		Con_Error(ERR_GAME, "async io is not initialized");
+		return -1;
+	}
+
+	fsAsyncRequest_t *req = (fsAsyncRequest_t*)calloc(1, sizeof(fsAsyncRequest_t));
+	req->priority = priority;
+	req->path = strdup(path);
+	// the file index is only safe to use here on the main thread, so the io thread gets told where to look
+	req->missing = FS_Locate(path, &req->nativePath) == FS_MISSING;
+	req->callback = callback;
+	req->userdata = userdata;
+	req->queued = SDL_GetPerformanceCounter();
+
+	SDL_LockMutex(lock);
+	req->id = nextRequestId++;
+	vec_push(&pending, req);
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(lock);
+
+	stats.requests++;
+
+	return req->id;
+}
+
+int FS_ReadAsync(const char *path, int priority, fsReadCallback_t callback, void *userdata) {
+	return FS_AsyncQueue(path, priority, callback, userdata);
+}
+
+void FS_Prefetch(const char *path, int priority) {
+	FS_AsyncQueue(path, priority, nullptr, nullptr);
+}
+
+// finds the prefetch for path in list, or -1. must hold the lock.
+static int FS_AsyncFindPrefetch(fsAsyncRequest_vec_t *list, const char *path) {
+	for (int i = 0; i < list->length; i++) {
+		fsAsyncRequest_t *req = list->data[i];
+		if (req->callback == nullptr && !req->cancelled && strcmp(req->path, path) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+bool FS_TakePrefetch(const char *path, void **buffer, int *size) {
+	if (lock == nullptr) {
+		return false;
+	}
+
+	fsAsyncRequest_t *req = nullptr;
+
+	SDL_LockMutex(lock);
+	while (req == nullptr) {
+		int i = FS_AsyncFindPrefetch(&completed, path);
+		if (i >= 0) {
+			req = completed.data[i];
+			vec_splice(&completed, i, 1);
+			break;
+		}
+
+		// still queued, it's needed now so don't wait for its turn
+		i = FS_AsyncFindPrefetch(&pending, path);
+		if (i >= 0) {
+			req = pending.data[i];
+			vec_splice(&pending, i, 1);
+			SDL_UnlockMutex(lock);
+			FS_AsyncRead(req);
+			SDL_LockMutex(lock);
+			break;
+		}
+
+		bool reading = inFlight != nullptr && inFlight->callback == nullptr && !inFlight->cancelled && strcmp(inFlight->path, path) == 0;
+		if (!reading) {
+			break;
+		}
+		SDL_CondWait(finished, lock);
+	}
+	SDL_UnlockMutex(lock);
+
+	if (req == nullptr) {
+		return false;
+	}
+
+	stats.completed++;
+	stats.readTotal += FS_AsyncMs(req->started, req->finished);
+	if (req->size < 0) {
+		stats.failed++;
+	}
+	else {
+		stats.bytes += req->size;
+	}
+
+	*buffer = req->buffer;
+	*size = req->size;
+	req->buffer = nullptr;
+	FS_AsyncFree(req);
+
+	return true;
+}
+
+void FS_ClearPrefetch() {
+	if (lock == nullptr) {
+		return;
+	}
+
+	SDL_LockMutex(lock);
+	for (int i = pending.length - 1; i >= 0; i--) {
+		if (pending.data[i]->callback == nullptr) {
+			FS_AsyncFree(pending.data[i]);
+			vec_splice(&pending, i, 1);
+		}
+	}
+	for (int i = completed.length - 1; i >= 0; i--) {
+		if (completed.data[i]->callback == nullptr) {
+			FS_AsyncFree(completed.data[i]);
+			vec_splice(&completed, i, 1);
+		}
+	}
+	// FS_AsyncTick frees this one once it lands
+	if (inFlight != nullptr && inFlight->callback == nullptr) {
+		inFlight->cancelled = true;
+	}
+	SDL_UnlockMutex(lock);
+}
+
+bool FS_CancelAsync(int request) {
+	if (lock == nullptr) {
+		return false;
+	}
+
+	bool found = false;
+	int i;
+	fsAsyncRequest_t *req;
+
+	SDL_LockMutex(lock);
+
+	// not started yet, just drop it
+	vec_foreach(&pending, req, i) {
+		if (req->id == request) {
+			vec_splice(&pending, i, 1);
+			FS_AsyncFree(req);
+			found = true;
+			break;
+		}
+	}
+
+	// already being read or waiting for the tick, skip the callback when it comes back
+	if (!found && inFlight != nullptr && inFlight->id == request) {
+		inFlight->cancelled = true;
+		found = true;
+	}
+
+	if (!found) {
+		vec_foreach(&completed, req, i) {
+			if (req->id == request) {
+				req->cancelled = true;
+				found = true;
+				break;
+			}
+		}
+	}
+
+	SDL_UnlockMutex(lock);
+
+	if (found) {
+		stats.cancelled++;
+	}
+
+	return found;
+}
+
+void FS_AsyncTick() {
+	if (lock == nullptr) {
+		return;
+	}
+
+#ifndef FS_ASYNC_THREAD
+	fsAsyncRequest_t *next;
+	while ((next = FS_AsyncPop()) != nullptr) {
+		FS_AsyncRead(next);
+		vec_push(&completed, next);
+	}
+	SDL_CondBroadcast(finished);
+#endif
+
+	// swap the completed list out so callbacks can queue more reads without deadlocking.
+	// prefetches stay behind until FS_TakePrefetch or FS_ClearPrefetch picks them up.
+	fsAsyncRequest_vec_t done;
+	vec_init(&done);
+	SDL_LockMutex(lock);
+	int kept = 0;
+	for (int i = 0; i < completed.length; i++) {
+		fsAsyncRequest_t *req = completed.data[i];
+		if (req->callback == nullptr && !req->cancelled) {
+			completed.data[kept++] = req;
+		}
+		else {
+			vec_push(&done, req);
+		}
+	}
+	completed.length = kept;
+	SDL_UnlockMutex(lock);
+
+	uint64_t now = SDL_GetPerformanceCounter();
+	int i;
+	fsAsyncRequest_t *req;
+	vec_foreach(&done, req, i) {
+		if (!req->cancelled && req->callback != nullptr) {
+			double latency = FS_AsyncMs(req->queued, now);
+			stats.completed++;
+			stats.latencyTotal += latency;
+			stats.latencyMax = latency > stats.latencyMax ? latency : stats.latencyMax;
+			stats.readTotal += FS_AsyncMs(req->started, req->finished);
+
+			if (req->size < 0) {
+				stats.failed++;
+			}
+			else {
+				stats.bytes += req->size;
+			}
+
+			req->callback(req->id, req->path, req->buffer, req->size, req->userdata);
+		}
+
+		FS_AsyncFree(req);
+	}
+
+	vec_deinit(&done);
+}
+
+void Cmd_FS_AsyncStats_f() {
+	if (Con_GetArgsCount() > 1 && strcmp(Con_GetArg(1), "reset") == 0) {
+		memset(&stats, 0, sizeof(stats));
+		Con_Printf("async io stats reset\n");
+		return;
+	}
+
+	SDL_LockMutex(lock);
+	int queued = pending.length + (inFlight != nullptr ? 1 : 0);
+	SDL_UnlockMutex(lock);
+
+	double avg = stats.completed > 0 ? stats.latencyTotal / stats.completed : 0;
+	double mbps = stats.readTotal > 0 ? (stats.bytes / (1024.0 * 1024.0)) / (stats.readTotal / 1000.0) : 0;
+
+	Con_Printf("async io: %i requested, %i completed, %i failed, %i cancelled, %i in queue\n", stats.requests, stats.completed, stats.failed, stats.cancelled, queued);
+	Con_Printf("latency: %.2fms avg, %.2fms max\n", avg, stats.latencyMax);
+	Con_Printf("throughput: %.2f MB in %.2fms of reading, %.2f MB/s\n", stats.bytes / (1024.0 * 1024.0), stats.readTotal, mbps);
+}
+
+void FS_AsyncInit() {
+	if (lock != nullptr) {
+		return;
+	}
+
+	vec_init(&pending);
+	vec_init(&completed);
+	memset(&stats, 0, sizeof(stats));
+
+	lock = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	finished = SDL_CreateCond();
+	running = true;
+
+#ifdef FS_ASYNC_THREAD
+	thread = SDL_CreateThread(&FS_AsyncThread, "fsasync", nullptr);
+#endif
+
+	Con_AddCommand("fs_asyncstats", Cmd_FS_AsyncStats_f);
+}
+
+void FS_AsyncShutdown() {
+	if (lock == nullptr) {
+		return;
+	}
+
+	SDL_LockMutex(lock);
+	running = false;
+	SDL_CondSignal(wake);
+	SDL_UnlockMutex(lock);
+
+	if (thread != nullptr) {
+		SDL_WaitThread(thread, nullptr);
+		thread = nullptr;
+	}
+
+	// anything left over never gets a callback
+	int i;
+	fsAsyncRequest_t *req;
+	vec_foreach(&pending, req, i) {
+		FS_AsyncFree(req);
+	}
+	vec_foreach(&completed, req, i) {
+		FS_AsyncFree(req);
+	}
+	vec_deinit(&pending);
+	vec_deinit(&completed);
+
+	SDL_DestroyCond(wake);
+	SDL_DestroyCond(finished);
+	SDL_DestroyMutex(lock);
+	wake = nullptr;
+	finished = nullptr;
+	lock = nullptr;
+}
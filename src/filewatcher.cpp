@@ -2,6 +2,7 @@
 #include <physfs.h>
 #include "console.h"
 #include "main.h"
+#include "files.h"
 extern "C" {
 #include "external/sds.h"
 }
@@ -146,6 +147,13 @@ void FileWatcher_Init() {
 
 void FileWatcher_Tick() {
 	if (fileChanged) {
+		// the file index only follows writes made through the engine, so catch it up on these first
+		int i;
+		fileWatcherInfo_t *file;
+		vec_foreach_ptr(&sourceFiles, file, i) {
+			FS_RefreshFile(file->name);
+		}
+
 		auto v = Con_GetVarString("filewatcher_execute");
 		Con_Execute(v);
 
@@ -8,43 +8,65 @@
 #include "cvar_main.h"
 #include "main.h"
 
-#define CONSOLE_MAX_LINES 4000
-
 #define IM_ARRAYSIZE(_ARR)  ((int)(sizeof(_ARR)/sizeof(*_ARR)))
 
 ConsoleUI::ConsoleUI() {
+	LogArena = (char*)malloc(CONSOLE_ARENA_SIZE);
 	ClearLog();
 	memset(InputBuf, 0, sizeof(InputBuf));
 	HistoryPos = -1;
 }
 
 ConsoleUI::~ConsoleUI() {
-	ClearLog();
+	free(LogArena);
 	for (int i = 0; i < History.Size; i++)
 		free(History[i]);
 }
 
 void ConsoleUI::ClearLog() {
-	for (int i = 0; i < Items.Size; i++)
-		free(Items[i]);
-	Items.clear();
+	ArenaHead = 0;
+	LineStart = 0;
+	LineCount = 0;
 	ScrollToBottom = true;
 }
 
+void ConsoleUI::PopLine() {
+	LineStart = (LineStart + 1) % CONSOLE_MAX_LINES;
+	LineCount--;
+}
+
 void ConsoleUI::AddLog(const char* fmt, ...) {
 	char buf[1024];
 	va_list args;
 	va_start(args, fmt);
-	vsnprintf(buf, IM_ARRAYSIZE(buf), fmt, args);
-	buf[IM_ARRAYSIZE(buf) - 1] = 0;
+	int len = vsnprintf(buf, IM_ARRAYSIZE(buf), fmt, args);
 	va_end(args);
-	Items.push_back(Strdup(buf));
-	ScrollToBottom = true;
 
-	if (Items.size() > CONSOLE_MAX_LINES) {
-		free(Items[0]);
-		Items.erase(Items.begin());
+	if (len < 0) {
+		return;
+	}
+	len = len < IM_ARRAYSIZE(buf) - 1 ? len : IM_ARRAYSIZE(buf) - 1;
+	int size = len + 1;
+
+	// lines never wrap around the end of the arena, they start over at the front instead. anything
+	// left between the head and the end is older than what's at the front, so it goes first.
+	if (ArenaHead + size > CONSOLE_ARENA_SIZE) {
+		while (LineCount > 0 && Lines[LineStart].offset >= ArenaHead) {
+			PopLine();
+		}
+		ArenaHead = 0;
+	}
+
+	// drop the oldest lines until there's a free slot and nothing is using the space we need
+	while (LineCount > 0 && (LineCount == CONSOLE_MAX_LINES || (Lines[LineStart].offset >= ArenaHead && Lines[LineStart].offset < ArenaHead + size))) {
+		PopLine();
 	}
+
+	memcpy(LogArena + ArenaHead, buf, size);
+	Lines[(LineStart + LineCount) % CONSOLE_MAX_LINES] = { ArenaHead, len };
+	LineCount++;
+	ArenaHead += size;
+	ScrollToBottom = true;
 }
 
 void ConsoleUI::Draw(int width, int height) {
@@ -92,6 +114,10 @@ void ConsoleUI::Draw(int width, int height) {
 				Con_SetVarFloat("debug.fontAtlas", debug_fontAtlas->integer ? 0 : 1);
 			}
 
+			if (ImGui::MenuItem("Profiler", nullptr, debug_profiler->boolean)) {
+				Con_SetVarFloat("debug.profiler", debug_profiler->integer ? 0 : 1);
+			}
+
 			ImGui::EndMenu();
 		}
 
@@ -113,12 +139,12 @@ void ConsoleUI::Draw(int width, int height) {
 	}
 
 	ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(4, 1)); // Tighten spacing
-	ImGuiListClipper clipper(Items.Size);
+	ImGuiListClipper clipper(LineCount);
 	while (clipper.Step()) {
 		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
 		{
-			const char* item = Items[i];
-			ImGui::TextUnformatted(item);
+			const ConsoleLine &line = Lines[(LineStart + i) % CONSOLE_MAX_LINES];
+			ImGui::TextUnformatted(LogArena + line.offset, LogArena + line.offset + line.length);
 		}
 	}
 	if (ScrollToBottom)
@@ -6,10 +6,24 @@
 
 // IMGUI CONSOLE
 
+#define CONSOLE_MAX_LINES 4000
+#define CONSOLE_ARENA_SIZE (512 * 1024)
+
+// a line of console output, stored in ConsoleUI::LogArena
+struct ConsoleLine
+{
+    int offset;
+    int length;
+};
+
 struct ConsoleUI
 {
     char                  InputBuf[256];
-    ImVector<char*>       Items;
+    char*                 LogArena;      // text for every line, reused front to back as a ring
+    int                   ArenaHead;     // offset the next line will be written to
+    ConsoleLine           Lines[CONSOLE_MAX_LINES]; // ring of lines, oldest at LineStart
+    int                   LineStart;
+    int                   LineCount;
     bool                  ScrollToBottom;
     ImVector<char*>       History;
     int                   HistoryPos;    // -1: new line, 0..History.Size-1 browsing history.
@@ -24,6 +38,7 @@ struct ConsoleUI
     static char* Strdup(const char *str) { size_t len = strlen(str) + 1; void* buff = malloc(len); return (char*)memcpy(buff, (const void*)str, len); }
 
     void ClearLog();
+    void PopLine();
     void AddLog(const char* fmt, ...) IM_FMTARGS(2);
     void Draw(int width, int height);
     void ExecCommand(const char * command_line);
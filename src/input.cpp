@@ -128,15 +128,51 @@ MousePosition In_MousePosition() {
 	return mousePos;
 }
 
-int In_GetKeyNum(const char *str) {
-	for (int i = 0; i < MAX_KEYS; i++) {
+// open addressed table of key name -> key number, so binds and config execution don't have to scan
+// every key name. slots hold key numbers, 0 is empty since key 0 is <UNKNOWN> anyway.
+#define KEY_HASH_SIZE 2048
+static_assert(KEY_HASH_SIZE >= MAX_KEYS * 2, "KEY_HASH_SIZE needs to be at least twice MAX_KEYS");
+static uint16_t keyHash[KEY_HASH_SIZE];
+static bool keyHashBuilt = false;
+
+// case insensitive fnv-1a, key names are matched case insensitively
+static uint32_t In_HashKeyName(const char *str) {
+	uint32_t hash = 2166136261u;
+	for (const char *c = str; *c != '\0'; c++) {
+		hash ^= (uint32_t)tolower((unsigned char)*c);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void In_BuildKeyHash() {
+	for (int i = 1; i < MAX_KEYS; i++) {
 		if (keys[i] == NULL) {
 			continue;
 		}
 
-		if (strcasecmp(str, keys[i]) == 0) {
-			return i;
+		uint32_t slot = In_HashKeyName(keys[i]) & (KEY_HASH_SIZE - 1);
+		while (keyHash[slot] != 0) {
+			slot = (slot + 1) & (KEY_HASH_SIZE - 1);
+		}
+		keyHash[slot] = (uint16_t)i;
+	}
+
+	keyHashBuilt = true;
+}
+
+int In_GetKeyNum(const char *str) {
+	if (!keyHashBuilt) {
+		In_BuildKeyHash();
+	}
+
+	uint32_t slot = In_HashKeyName(str) & (KEY_HASH_SIZE - 1);
+	while (keyHash[slot] != 0) {
+		if (strcasecmp(str, keys[keyHash[slot]]) == 0) {
+			return keyHash[slot];
 		}
+		slot = (slot + 1) & (KEY_HASH_SIZE - 1);
 	}
 
 	return 0;
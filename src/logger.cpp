@@ -0,0 +1,209 @@
+#include <SDL/SDL.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "logger.h"
+#include "main.h"
+
+// emscripten builds don't have threads, output is written straight away instead
+#if !defined(__EMSCRIPTEN__)
+#define LOG_THREAD
+#endif
+
+// must be a power of two so positions can wrap with a mask
+#define LOG_QUEUE_SIZE (256 * 1024)
+
+static char queue[LOG_QUEUE_SIZE];
+// total bytes ever written/read. the difference is how much is queued, the low bits are the offset.
+static std::atomic<uint32_t> writePos(0);
+static std::atomic<uint32_t> readPos(0);
+
+static std::atomic<FILE*> pendingFile(nullptr);
+static std::atomic<bool> fileChanged(false);
+static FILE *logFile = nullptr;
+
+static std::atomic<bool> running(false);
+static SDL_Thread *thread = nullptr;
+
+// lines that didn't fit in the queue, only touched by the writing thread
+static int droppedLines = 0;
+
+static void Log_Output(const char *text, size_t len) {
+	fwrite(text, 1, len, stdout);
+	if (logFile != nullptr) {
+		fwrite(text, 1, len, logFile);
+	}
+}
+
+// writes out everything queued so far, returns false if there was nothing to do
+static bool Log_Drain() {
+	if (fileChanged.exchange(false)) {
+		if (logFile != nullptr) {
+			fclose(logFile);
+		}
+		logFile = pendingFile.exchange(nullptr);
+	}
+
+	uint32_t r = readPos.load(std::memory_order_relaxed);
+	uint32_t w = writePos.load(std::memory_order_acquire);
+
+	if (r == w) {
+		return false;
+	}
+
+	uint32_t start = r & (LOG_QUEUE_SIZE - 1);
+	uint32_t len = w - r;
+	uint32_t first = len < LOG_QUEUE_SIZE - start ? len : LOG_QUEUE_SIZE - start;
+
+	Log_Output(&queue[start], first);
+	if (first < len) {
+		Log_Output(&queue[0], len - first);
+	}
+
+	fflush(stdout);
+	if (logFile != nullptr) {
+		fflush(logFile);
+	}
+
+	readPos.store(w, std::memory_order_release);
+	return true;
+}
+
+#ifdef LOG_THREAD
+static int Log_Thread(void *ptr) {
+	NOTUSED(ptr);
+
+	while (running.load()) {
+		if (!Log_Drain()) {
+			SDL_Delay(5);
+		}
+	}
+
+	// catch anything written while shutting down
+	Log_Drain();
+	return 0;
+}
+#endif
+
+static bool Log_Enqueue(const char *text, size_t len) {
+	uint32_t w = writePos.load(std::memory_order_relaxed);
+	uint32_t r = readPos.load(std::memory_order_acquire);
+
+	if (len > LOG_QUEUE_SIZE - (w - r)) {
+		return false;
+	}
+
+	uint32_t start = w & (LOG_QUEUE_SIZE - 1);
+	size_t first = len < LOG_QUEUE_SIZE - start ? len : LOG_QUEUE_SIZE - start;
+	memcpy(&queue[start], text, first);
+	memcpy(&queue[0], text + first, len - first);
+
+	writePos.store(w + (uint32_t)len, std::memory_order_release);
+	return true;
+}
+
+void Log_Write(const char *text) {
+#ifdef LOG_THREAD
+	if (running.load(std::memory_order_relaxed)) {
+		// rather lose output than stall the frame waiting for the logger to catch up
+		if (droppedLines > 0) {
+			char msg[64];
+			int len = snprintf(msg, sizeof(msg), "[log: %i lines dropped]\n", droppedLines);
+			if (!Log_Enqueue(msg, (size_t)len)) {
+				droppedLines++;
+				return;
+			}
+			droppedLines = 0;
+		}
+
+		if (!Log_Enqueue(text, strlen(text))) {
+			droppedLines++;
+		}
+		return;
+	}
+#endif
+
+	Log_Output(text, strlen(text));
+}
+
+// opens a new log file, appending to it if it already exists. an empty path closes the current one.
+void Log_SetFile(const char *path) {
+	FILE *f = nullptr;
+
+	if (path != nullptr && path[0] != '\0') {
+		f = fopen(path, "a");
+		if (f == nullptr) {
+			Log_Write(tempstr("couldn't open log file %s\n", path));
+		}
+	}
+
+#ifdef LOG_THREAD
+	if (running.load()) {
+		// the logger thread owns the file, hand it over and let it close the old one
+		FILE *old = pendingFile.exchange(f);
+		if (old != nullptr) {
+			fclose(old);
+		}
+		fileChanged.store(true);
+		return;
+	}
+#endif
+
+	if (logFile != nullptr) {
+		fclose(logFile);
+	}
+	logFile = f;
+}
+
+// blocks until everything written so far is out, for when the process is about to exit
+void Log_Flush() {
+#ifdef LOG_THREAD
+	if (running.load()) {
+		while (readPos.load(std::memory_order_acquire) != writePos.load(std::memory_order_relaxed)) {
+			SDL_Delay(1);
+		}
+		return;
+	}
+#endif
+
+	fflush(stdout);
+	if (logFile != nullptr) {
+		fflush(logFile);
+	}
+}
+
+void Log_Init() {
+#ifdef LOG_THREAD
+	if (running.load()) {
+		return;
+	}
+
+	running.store(true);
+	thread = SDL_CreateThread(&Log_Thread, "logger", nullptr);
+	if (thread == nullptr) {
+		running.store(false);
+	}
+#endif
+}
+
+void Log_Shutdown() {
+#ifdef LOG_THREAD
+	if (thread != nullptr) {
+		running.store(false);
+		SDL_WaitThread(thread, nullptr);
+		thread = nullptr;
+	}
+
+	if (fileChanged.exchange(false)) {
+		if (logFile != nullptr) {
+			fclose(logFile);
+		}
+		logFile = pendingFile.exchange(nullptr);
+	}
+#endif
+
+	if (logFile != nullptr) {
+		fclose(logFile);
+		logFile = nullptr;
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// console output sink. lines are copied into a lock free queue and written to stdout, and the log
+// file if one is open, by a separate thread so printing never waits on the terminal or disk.
+// Log_Write must only be called from one thread at a time.
+void Log_Init();
+void Log_Write(const char *text);
+void Log_SetFile(const char *path);
+void Log_Flush();
+void Log_Shutdown();
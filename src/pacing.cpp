@@ -0,0 +1,240 @@
+#include <chrono>
+#include <thread>
+#include <math.h>
+#include <string.h>
+#if defined(__linux__)
+#include <time.h>
+#include <errno.h>
+#endif
+#include "console.h"
+#include "cvar_main.h"
+#include "pacing.h"
+
+#define PACE_LEGACY 0
+#define PACE_DEADLINE 1
+#define PACE_ADAPTIVE 2
+
+// histogram of how far each frame interval lands from the target period
+#define PACE_BIN_US 250
+#define PACE_BIN_MIN_US -1000
+#define PACE_BINS 24
+
+// adaptive mode reevaluates the rate divisor over this many frames
+#define PACE_WINDOW 60
+#define PACE_MAX_DIVISOR 4
+
+static int64_t lastWake = 0; // ns, end of the previous Pace_Wait
+static int64_t deadline = 0; // ns, absolute time the current frame should end
+static int64_t oversleep = 0; // ns, running estimate of how late sleeps wake up
+static int lastMode = -1;
+static int lastFps = 0;
+
+static int divisor = 1;
+static int windowFrames = 0;
+static int windowMisses = 0;
+static int64_t windowMaxWork = 0;
+
+static struct {
+	int frames;
+	int missed;
+	int under; // intervals below the first bin
+	int over; // intervals past the last bin
+	int bins[PACE_BINS];
+	double sum; // us, interval minus target
+	double sumSq;
+	int64_t spin; // ns spent busy waiting
+	int64_t sleep; // ns spent sleeping
+} stats;
+
+static int64_t Pace_Now() {
+#if defined(__linux__)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static void Pace_SleepUntil(int64_t when) {
+#if defined(__linux__)
+	struct timespec ts;
+	ts.tv_sec = when / 1000000000;
+	ts.tv_nsec = when % 1000000000;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+#else
+	std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(when)));
+#endif
+}
+
+static void Pace_ResetStats() {
+	memset(&stats, 0, sizeof(stats));
+}
+
+static void Pace_Record(int64_t interval, int64_t period) {
+	double offset = (interval - period) / 1000.0;
+	int bin = (int)floor((offset - PACE_BIN_MIN_US) / PACE_BIN_US);
+
+	if (bin < 0) {
+		stats.under++;
+	}
+	else if (bin >= PACE_BINS) {
+		stats.over++;
+	}
+	else {
+		stats.bins[bin]++;
+	}
+
+	stats.frames++;
+	stats.sum += offset;
+	stats.sumSq += offset * offset;
+}
+
+// divides maxfps by one more, down to maxfps / PACE_MAX_DIVISOR, when too many frames miss, and
+// by one less once the work comfortably fits in the faster period again
+static void Pace_Adapt(int64_t work, int64_t basePeriod, bool missed) {
+	windowFrames++;
+	windowMisses += missed ? 1 : 0;
+	windowMaxWork = work > windowMaxWork ? work : windowMaxWork;
+
+	if (windowFrames < PACE_WINDOW) {
+		return;
+	}
+
+	if (windowMisses > PACE_WINDOW / 10 && divisor < PACE_MAX_DIVISOR) {
+		divisor++;
+		Con_Printf("vid.pacing: missing deadlines, pacing at %.1f fps\n", 1E9 / (basePeriod * divisor));
+	}
+	else if (windowMisses == 0 && divisor > 1 && windowMaxWork < basePeriod * (divisor - 1) * 7 / 10) {
+		divisor--;
+		Con_Printf("vid.pacing: pacing at %.1f fps\n", 1E9 / (basePeriod * divisor));
+	}
+
+	windowFrames = 0;
+	windowMisses = 0;
+	windowMaxWork = 0;
+}
+
+void Pace_Wait(int maxfps) {
+	int64_t entry = Pace_Now();
+	int mode = vid_pacing->integer;
+
+	if (maxfps <= 0) {
+		lastWake = entry;
+		return;
+	}
+
+	// start over whenever the settings change so the old deadline doesn't cause a burst of frames
+	if (mode != lastMode || maxfps != lastFps || lastWake == 0) {
+		lastMode = mode;
+		lastFps = maxfps;
+		deadline = entry;
+		divisor = 1;
+		windowFrames = windowMisses = 0;
+		windowMaxWork = 0;
+		Pace_ResetStats();
+		lastWake = 0;
+	}
+
+	int64_t basePeriod = 1000000000LL / maxfps;
+	int64_t period = basePeriod * (mode == PACE_ADAPTIVE ? divisor : 1);
+	int64_t wake;
+
+	if (mode == PACE_LEGACY) {
+		// OSes seem to not be able to sleep for shorter than a millisecond. so let's sleep until
+		// we're close-ish and then burn loop the rest.
+		int64_t target = (lastWake != 0 ? lastWake : entry) + period;
+		int64_t current = entry;
+		while (current <= target) {
+			int64_t amt = (target - current) - 2000000;
+			if (amt > 0) {
+				std::this_thread::sleep_for(std::chrono::nanoseconds(amt));
+				int64_t slept = Pace_Now();
+				stats.sleep += slept - current;
+				current = slept;
+			}
+			else {
+				int64_t spun = Pace_Now();
+				stats.spin += spun - current;
+				current = spun;
+			}
+		}
+
+		stats.missed += entry > target ? 1 : 0;
+		wake = current;
+	}
+	else {
+		// deadlines advance by exactly one period so error doesn't accumulate. if we're more than a
+		// period behind there's no catching up, so start from now instead.
+		deadline += period;
+		bool missed = entry > deadline;
+		if (entry - deadline > period) {
+			deadline = entry;
+		}
+
+		if (!missed) {
+			Pace_SleepUntil(deadline - oversleep);
+		}
+
+		wake = Pace_Now();
+		stats.sleep += wake - entry;
+		stats.missed += missed ? 1 : 0;
+
+		// track how late the os wakes us up, and aim that much earlier next time
+		if (!missed) {
+			int64_t late = wake - (deadline - oversleep);
+			oversleep += (late - oversleep) / 8;
+			oversleep = oversleep < 0 ? 0 : oversleep > 2000000 ? 2000000 : oversleep;
+		}
+
+		// the first frame after a reset has no previous wake to measure its work from
+		if (mode == PACE_ADAPTIVE && lastWake != 0) {
+			Pace_Adapt(entry - lastWake, basePeriod, missed);
+		}
+	}
+
+	if (lastWake != 0) {
+		Pace_Record(wake - lastWake, period);
+	}
+
+	lastWake = wake;
+}
+
+void Cmd_PacingStats_f() {
+	if (Con_GetArgsCount() > 1 && strcmp(Con_GetArg(1), "reset") == 0) {
+		Pace_ResetStats();
+		Con_Printf("pacing stats reset\n");
+		return;
+	}
+
+	if (stats.frames == 0) {
+		Con_Printf("no frames recorded, vid.maxfps needs to be above 0\n");
+		return;
+	}
+
+	double mean = stats.sum / stats.frames;
+	double stddev = sqrt(fmax(0, stats.sumSq / stats.frames - mean * mean));
+
+	Con_Printf("vid.pacing %i, %i frames, %i missed deadlines, oversleep estimate %.3fms\n", vid_pacing->integer, stats.frames, stats.missed, oversleep / 1E6);
+	Con_Printf("interval vs target: mean %+.3fms, stddev %.3fms\n", mean / 1000.0, stddev / 1000.0);
+	Con_Printf("time waiting: %.1fms sleeping, %.1fms spinning\n", stats.sleep / 1E6, stats.spin / 1E6);
+
+	int peak = stats.under > stats.over ? stats.under : stats.over;
+	for (int i = 0; i < PACE_BINS; i++) {
+		peak = stats.bins[i] > peak ? stats.bins[i] : peak;
+	}
+
+	const char *bar = "########################################";
+	int barLen = (int)strlen(bar);
+
+	Con_Printf("%17s: %6i %.*s\n", "< -1.00ms", stats.under, stats.under * barLen / peak, bar);
+	for (int i = 0; i < PACE_BINS; i++) {
+		double lo = (PACE_BIN_MIN_US + i * PACE_BIN_US) / 1000.0;
+		Con_Printf("%+6.2f..%+6.2fms: %6i %.*s\n", lo, lo + PACE_BIN_US / 1000.0, stats.bins[i], stats.bins[i] * barLen / peak, bar);
+	}
+	Con_Printf("%17s: %6i %.*s\n", "> +5.00ms", stats.over, stats.over * barLen / peak, bar);
+}
+
+void Pace_Init() {
+	Con_AddCommand("pacing_stats", Cmd_PacingStats_f);
+}
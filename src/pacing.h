@@ -0,0 +1,8 @@
+#pragma once
+
+// frame rate limiting for vid.maxfps. vid.pacing picks how the wait is done:
+// 0 - sleep until ~2ms before the deadline and spin the rest
+// 1 - sleep until an absolute deadline, compensating for measured oversleep, no spinning
+// 2 - same as 1, but drops to maxfps / 2, / 3 or / 4 while deadlines keep getting missed
+void Pace_Init();
+void Pace_Wait(int maxfps);
@@ -0,0 +1,298 @@
+#include <SDL/SDL.h>
+#include <imgui.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "console.h"
+#include "cvar_main.h"
+#include "profiler.h"
+
+// zones kept per thread, older ones get overwritten. must be a power of two.
+#define PROF_RING_SIZE 65536
+#define PROF_MAX_DEPTH 64
+#define PROF_FRAME_MARKS 256
+
+typedef struct {
+	const char *name;
+	int64_t start; // nanoseconds since startup
+	int64_t end;
+	int depth;
+} profZone_t;
+
+typedef struct {
+	char name[32];
+	int id;
+
+	// zones are written once they end, count is published after the zone is filled in
+	profZone_t zones[PROF_RING_SIZE];
+	std::atomic<uint64_t> count;
+
+	// open zones, only touched by the owning thread
+	const char *stackNames[PROF_MAX_DEPTH];
+	int64_t stackStarts[PROF_MAX_DEPTH];
+	int depth;
+} profThread_t;
+
+std::atomic<bool> prof_enabled(false);
+
+static std::vector<profThread_t*> threads;
+static SDL_mutex *threadsLock = nullptr;
+static thread_local profThread_t *localThread = nullptr;
+
+static int64_t frameMarks[PROF_FRAME_MARKS];
+static uint64_t frameCount = 0;
+static bool capturing = false;
+static bool timelinePaused = false;
+static int64_t pausedFrame[2];
+
+static auto profStart = std::chrono::steady_clock::now();
+
+static int64_t Prof_Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profStart).count();
+}
+
+static profThread_t* Prof_GetThread() {
+	if (localThread != nullptr) {
+		return localThread;
+	}
+
+	profThread_t *thread = new profThread_t();
+	thread->count.store(0);
+	thread->depth = 0;
+
+	SDL_LockMutex(threadsLock);
+	thread->id = (int)threads.size();
+	snprintf(thread->name, sizeof(thread->name), "thread %i", thread->id);
+	threads.push_back(thread);
+	SDL_UnlockMutex(threadsLock);
+
+	localThread = thread;
+	return thread;
+}
+
+void Prof_SetThreadName(const char *name) {
+	profThread_t *thread = Prof_GetThread();
+	snprintf(thread->name, sizeof(thread->name), "%s", name);
+}
+
+// zones are tracked even while the profiler is off so begin/end pairs that straddle
+// a toggle stay balanced, they just aren't recorded. zones started while it's off don't
+// read the clock, and have a start of -1 so they aren't recorded if it turns on before they end.
+void Prof_Begin(const char *name) {
+	profThread_t *thread = Prof_GetThread();
+
+	if (thread->depth < PROF_MAX_DEPTH) {
+		thread->stackNames[thread->depth] = name;
+		thread->stackStarts[thread->depth] = prof_enabled.load(std::memory_order_relaxed) ? Prof_Now() : -1;
+	}
+	thread->depth++;
+}
+
+void Prof_End() {
+	profThread_t *thread = Prof_GetThread();
+
+	if (thread->depth == 0) {
+		return;
+	}
+
+	thread->depth--;
+
+	if (thread->depth >= PROF_MAX_DEPTH || thread->stackStarts[thread->depth] < 0 || !prof_enabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	uint64_t count = thread->count.load(std::memory_order_relaxed);
+	profZone_t *zone = &thread->zones[count & (PROF_RING_SIZE - 1)];
+	zone->name = thread->stackNames[thread->depth];
+	zone->start = thread->stackStarts[thread->depth];
+	zone->end = Prof_Now();
+	zone->depth = thread->depth;
+	thread->count.store(count + 1, std::memory_order_release);
+}
+
+void Prof_FrameMark() {
+	prof_enabled.store(debug_profiler->integer != 0 || capturing, std::memory_order_relaxed);
+
+	frameMarks[frameCount % PROF_FRAME_MARKS] = Prof_Now();
+	frameCount++;
+}
+
+// calls cb for every recorded zone on the thread that ends at or after since, newest first.
+// zones being overwritten by the owning thread while this runs may come out garbled, which is
+// fine for a debug view.
+template <typename F>
+static void Prof_EachZone(profThread_t *thread, int64_t since, F cb) {
+	uint64_t count = thread->count.load(std::memory_order_acquire);
+	uint64_t oldest = count > PROF_RING_SIZE ? count - PROF_RING_SIZE : 0;
+
+	for (uint64_t i = count; i > oldest; i--) {
+		const profZone_t &zone = thread->zones[(i - 1) & (PROF_RING_SIZE - 1)];
+		// zones are written in the order they end, so once one ends before since we're done
+		if (zone.end < since) {
+			break;
+		}
+		cb(zone);
+	}
+}
+
+void Prof_SetCapture(bool capture) {
+	capturing = capture;
+}
+
+void Prof_EachFrameZone(void(*cb)(const char *name, int depth, int64_t ns, void *userdata), void *userdata) {
+	if (frameCount == 0) {
+		return;
+	}
+
+	int64_t frameStart = frameMarks[(frameCount - 1) % PROF_FRAME_MARKS];
+	Prof_EachZone(Prof_GetThread(), frameStart, [&](const profZone_t &zone) {
+		if (zone.start >= frameStart) {
+			cb(zone.name, zone.depth, zone.end - zone.start, userdata);
+		}
+	});
+}
+
+static void Prof_WriteJSONString(FILE *f, const char *str) {
+	fputc('"', f);
+	for (const char *c = str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', f);
+		}
+		fputc(*c, f);
+	}
+	fputc('"', f);
+}
+
+void Cmd_Profile_Dump_f() {
+	if (Con_GetArgsCount() != 2) {
+		Con_Printf("profile_dump <file> - write recorded profiler zones to a chrome trace file (chrome://tracing)\n");
+		return;
+	}
+
+	const char *path = Con_GetArg(1);
+	FILE *f = fopen(path, "w");
+	if (f == nullptr) {
+		Con_Printf("couldn't open %s for writing\n", path);
+		return;
+	}
+
+	int written = 0;
+	fprintf(f, "{\"traceEvents\":[\n");
+
+	SDL_LockMutex(threadsLock);
+	for (profThread_t *thread : threads) {
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":", written++ ? ",\n" : "", thread->id);
+		Prof_WriteJSONString(f, thread->name);
+		fprintf(f, "}}");
+
+		Prof_EachZone(thread, 0, [&](const profZone_t &zone) {
+			fprintf(f, ",\n{\"name\":");
+			Prof_WriteJSONString(f, zone.name);
+			fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}", thread->id, zone.start / 1000.0, (zone.end - zone.start) / 1000.0);
+			written++;
+		});
+	}
+	SDL_UnlockMutex(threadsLock);
+
+	fprintf(f, "\n]}\n");
+	fclose(f);
+
+	Con_Printf("wrote %i profiler events to %s\n", written - (int)threads.size(), path);
+}
+
+static ImU32 Prof_ZoneColor(const char *name) {
+	// color by name so the same zone looks the same every frame
+	uint32_t hash = 2166136261u;
+	for (const char *c = name; *c != '\0'; c++) {
+		hash = (hash ^ (uint8_t)*c) * 16777619u;
+	}
+
+	return IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 80 + ((hash >> 16) & 0x7F), 255);
+}
+
+void Prof_DrawTimeline() {
+	if (!debug_profiler->integer || frameCount < 2) {
+		return;
+	}
+
+	// show the last complete frame
+	int64_t frameStart, frameEnd;
+	if (timelinePaused) {
+		frameStart = pausedFrame[0];
+		frameEnd = pausedFrame[1];
+	}
+	else {
+		frameStart = frameMarks[(frameCount - 2) % PROF_FRAME_MARKS];
+		frameEnd = frameMarks[(frameCount - 1) % PROF_FRAME_MARKS];
+		pausedFrame[0] = frameStart;
+		pausedFrame[1] = frameEnd;
+	}
+
+	double frameMs = (frameEnd - frameStart) / 1E6;
+
+	ImGui::SetNextWindowSize(ImVec2(800, 240), ImGuiCond_FirstUseEver);
+	bool open = true;
+	if (!ImGui::Begin("Profiler", &open)) {
+		ImGui::End();
+		return;
+	}
+
+	if (!open) {
+		Con_SetVar("debug.profiler", "0");
+	}
+
+	ImGui::Checkbox("Pause", &timelinePaused);
+	ImGui::SameLine();
+	ImGui::Text("frame: %.3f ms", frameMs);
+
+	const float rowHeight = ImGui::GetTextLineHeight() + 4;
+	const float labelWidth = 100;
+	ImDrawList *draw = ImGui::GetWindowDrawList();
+	float width = ImGui::GetContentRegionAvail().x - labelWidth;
+	double scale = width / (double)(frameEnd - frameStart > 0 ? frameEnd - frameStart : 1);
+
+	SDL_LockMutex(threadsLock);
+	for (profThread_t *thread : threads) {
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		int maxDepth = 0;
+
+		draw->AddText(origin, ImGui::GetColorU32(ImGuiCol_Text), thread->name);
+
+		Prof_EachZone(thread, frameStart, [&](const profZone_t &zone) {
+			if (zone.start > frameEnd) {
+				return;
+			}
+
+			float x0 = origin.x + labelWidth + (float)((zone.start < frameStart ? 0 : zone.start - frameStart) * scale);
+			float x1 = origin.x + labelWidth + (float)((zone.end > frameEnd ? frameEnd - frameStart : zone.end - frameStart) * scale);
+			float y0 = origin.y + zone.depth * rowHeight;
+			ImVec2 min(x0, y0), max(x1 > x0 + 1 ? x1 : x0 + 1, y0 + rowHeight - 1);
+
+			draw->AddRectFilled(min, max, Prof_ZoneColor(zone.name));
+			if (max.x - min.x > ImGui::CalcTextSize(zone.name).x + 4) {
+				draw->AddText(ImVec2(x0 + 2, y0 + 2), IM_COL32_BLACK, zone.name);
+			}
+
+			if (ImGui::IsMouseHoveringRect(min, max)) {
+				ImGui::SetTooltip("%s: %.3f ms", zone.name, (zone.end - zone.start) / 1E6);
+			}
+
+			maxDepth = zone.depth > maxDepth ? zone.depth : maxDepth;
+		});
+
+		ImGui::Dummy(ImVec2(labelWidth + width, (maxDepth + 1) * rowHeight + 4));
+	}
+	SDL_UnlockMutex(threadsLock);
+
+	ImGui::End();
+}
+
+void Prof_Init() {
+	if (threadsLock == nullptr) {
+		threadsLock = SDL_CreateMutex();
+	}
+
+	Prof_SetThreadName("main");
+	Con_AddCommand("profile_dump", Cmd_Profile_Dump_f);
+}
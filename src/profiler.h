@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// lightweight cpu profiler. zones are recorded into a ring buffer per thread, and can be viewed
+// as a timeline (debug.profiler 1) or dumped as a chrome trace (profile_dump). when the profiler
+// is off, a zone costs a single branch on prof_enabled.
+
+extern std::atomic<bool> prof_enabled;
+
+void Prof_Init();
+void Prof_FrameMark();
+void Prof_SetThreadName(const char *name);
+void Prof_Begin(const char *name);
+void Prof_End();
+void Prof_DrawTimeline();
+
+// records zones even while debug.profiler is off, takes effect on the next Prof_FrameMark
+void Prof_SetCapture(bool capture);
+
+// calls cb for every zone the calling thread finished since the last Prof_FrameMark
+void Prof_EachFrameZone(void(*cb)(const char *name, int depth, int64_t ns, void *userdata), void *userdata);
+
+// times the rest of the enclosing scope. name must be a string literal or otherwise outlive the profiler.
+struct ProfZone {
+	bool active;
+
+	ProfZone(const char *name) {
+		active = prof_enabled.load(std::memory_order_relaxed);
+		if (active) {
+			Prof_Begin(name);
+		}
+	}
+
+	~ProfZone() {
+		if (active) {
+			Prof_End();
+		}
+	}
+};
+
+#define PROF_CONCAT2(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT2(a, b)
+#define PROFILE_ZONE(name) ProfZone PROF_CONCAT(profZone, __LINE__)(name)
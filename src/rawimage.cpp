@@ -0,0 +1,269 @@
+#include <stdlib.h>
+#include <string.h>
+#include "rawimage.h"
+
+// lz4 block format limits: the last 5 bytes are always literals, and the last match has to start
+// at least 12 bytes before the end of the block
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MF_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 16
+
+static uint32_t Read32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint64_t Read64(const uint8_t *p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t ReadLE32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void WriteLE32(uint8_t *p, uint32_t v) {
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+// 15 in the token, then 255s until the remainder
+static uint8_t* WriteLength(uint8_t *op, size_t len) {
+	for (len -= 15; len >= 255; len -= 255) {
+		*op++ = 255;
+	}
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+static uint8_t* WriteSequence(uint8_t *op, const uint8_t *literals, size_t literalLen, size_t offset, size_t matchLen) {
+	uint8_t *token = op++;
+	*token = (uint8_t)((literalLen >= 15 ? 15 : literalLen) << 4);
+	if (literalLen >= 15) {
+		op = WriteLength(op, literalLen);
+	}
+	memcpy(op, literals, literalLen);
+	op += literalLen;
+
+	// the last sequence is only literals
+	if (matchLen == 0) {
+		return op;
+	}
+
+	*op++ = offset & 0xff;
+	*op++ = (offset >> 8) & 0xff;
+
+	matchLen -= LZ4_MIN_MATCH;
+	*token |= matchLen >= 15 ? 15 : matchLen;
+	if (matchLen >= 15) {
+		op = WriteLength(op, matchLen);
+	}
+
+	return op;
+}
+
+size_t LZ4_CompressBound(size_t size) {
+	return size + size / 255 + 16;
+}
+
+size_t LZ4_CompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity) {
+	if (dstCapacity < LZ4_CompressBound(srcSize)) {
+		return 0;
+	}
+
+	const uint8_t *ip = src, *anchor = src;
+	const uint8_t *end = src + srcSize;
+	uint8_t *op = dst;
+
+	if (srcSize > LZ4_MF_LIMIT) {
+		// positions + 1 of the last 4 bytes seen with each hash, 0 if there weren't any
+		uint32_t *table = (uint32_t*)calloc(1 << LZ4_HASH_BITS, sizeof(uint32_t));
+		if (table == nullptr) {
+			return 0;
+		}
+
+		const uint8_t *matchLimit = end - LZ4_LAST_LITERALS;
+		const uint8_t *mfLimit = end - LZ4_MF_LIMIT;
+		unsigned misses = 0;
+
+		while (ip <= mfLimit) {
+			uint32_t seq = Read32(ip);
+			uint32_t h = (seq * 2654435761u) >> (32 - LZ4_HASH_BITS);
+			uint32_t pos = table[h];
+			table[h] = (uint32_t)(ip - src) + 1;
+
+			const uint8_t *ref = pos ? src + pos - 1 : ip;
+			if (ref == ip || ip - ref > LZ4_MAX_OFFSET || Read32(ref) != seq) {
+				// step further the longer nothing matches, like lz4's acceleration
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+
+			const uint8_t *m = ip + LZ4_MIN_MATCH, *r = ref + LZ4_MIN_MATCH;
+			while (m + 8 <= matchLimit && Read64(m) == Read64(r)) {
+				m += 8;
+				r += 8;
+			}
+			while (m < matchLimit && *m == *r) {
+				m++;
+				r++;
+			}
+
+			op = WriteSequence(op, anchor, ip - anchor, ip - ref, m - ip);
+			ip = anchor = m;
+			misses = 0;
+		}
+
+		free(table);
+	}
+
+	op = WriteSequence(op, anchor, end - anchor, 0, 0);
+	return op - dst;
+}
+
+int64_t LZ4_DecompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity) {
+	const uint8_t *ip = src, *iend = src + srcSize;
+	uint8_t *op = dst, *oend = dst + dstCapacity;
+
+	while (ip < iend) {
+		unsigned token = *ip++;
+
+		size_t literalLen = token >> 4;
+		if (literalLen == 15) {
+			unsigned b;
+			do {
+				if (ip >= iend) {
+					return -1;
+				}
+				b = *ip++;
+				literalLen += b;
+			} while (b == 255);
+		}
+
+		if (literalLen > (size_t)(iend - ip) || literalLen > (size_t)(oend - op)) {
+			return -1;
+		}
+		memcpy(op, ip, literalLen);
+		op += literalLen;
+		ip += literalLen;
+
+		if (ip == iend) {
+			break;
+		}
+
+		if (iend - ip < 2) {
+			return -1;
+		}
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - dst)) {
+			return -1;
+		}
+
+		size_t matchLen = token & 15;
+		if (matchLen == 15) {
+			unsigned b;
+			do {
+				if (ip >= iend) {
+					return -1;
+				}
+				b = *ip++;
+				matchLen += b;
+			} while (b == 255);
+		}
+		matchLen += LZ4_MIN_MATCH;
+		if (matchLen > (size_t)(oend - op)) {
+			return -1;
+		}
+
+		// matches can overlap what they write, but the copied span doubles each pass so
+		// long runs of the same pixel don't have to go a byte at a time
+		const uint8_t *match = op - offset;
+		while (matchLen > 0) {
+			size_t n = (size_t)(op - match) < matchLen ? (size_t)(op - match) : matchLen;
+			memcpy(op, match, n);
+			op += n;
+			matchLen -= n;
+		}
+	}
+
+	return op - dst;
+}
+
+bool RawImg_Parse(const void *buffer, size_t size, rawImage_t *img) {
+	const uint8_t *p = (const uint8_t*)buffer;
+	if (size < RAWIMAGE_HEADER_SIZE || memcmp(p, RAWIMAGE_MAGIC, 4) != 0) {
+		return false;
+	}
+
+	unsigned version = p[4] | (p[5] << 8);
+	unsigned compression = p[6] | (p[7] << 8);
+	uint32_t width = ReadLE32(p + 8);
+	uint32_t height = ReadLE32(p + 12);
+	uint32_t dataSize = ReadLE32(p + 16);
+
+	if (version != RAWIMAGE_VERSION || compression > RAWIMAGE_LZ4) {
+		return false;
+	}
+	if (width == 0 || height == 0 || width > RAWIMAGE_MAX_SIZE || height > RAWIMAGE_MAX_SIZE) {
+		return false;
+	}
+	if (dataSize > size - RAWIMAGE_HEADER_SIZE) {
+		return false;
+	}
+	if (compression == RAWIMAGE_NONE && dataSize != (size_t)width * height * 4) {
+		return false;
+	}
+
+	img->width = (int)width;
+	img->height = (int)height;
+	img->compression = (rawImageCompression_t)compression;
+	img->data = p + RAWIMAGE_HEADER_SIZE;
+	img->size = dataSize;
+	return true;
+}
+
+bool RawImg_Decode(const rawImage_t *img, uint8_t *pixels) {
+	size_t size = (size_t)img->width * img->height * 4;
+
+	if (img->compression == RAWIMAGE_NONE) {
+		memcpy(pixels, img->data, size);
+		return true;
+	}
+
+	return LZ4_DecompressBlock(img->data, img->size, pixels, size) == (int64_t)size;
+}
+
+uint8_t* RawImg_Encode(const uint8_t *pixels, int width, int height, rawImageCompression_t compression, size_t *size) {
+	size_t pixelSize = (size_t)width * height * 4;
+	size_t capacity = compression == RAWIMAGE_LZ4 ? LZ4_CompressBound(pixelSize) : pixelSize;
+	uint8_t *buffer = (uint8_t*)malloc(RAWIMAGE_HEADER_SIZE + capacity);
+	if (buffer == nullptr) {
+		return nullptr;
+	}
+
+	size_t dataSize = pixelSize;
+	if (compression == RAWIMAGE_LZ4) {
+		dataSize = LZ4_CompressBlock(pixels, pixelSize, buffer + RAWIMAGE_HEADER_SIZE, capacity);
+	} else {
+		memcpy(buffer + RAWIMAGE_HEADER_SIZE, pixels, pixelSize);
+	}
+
+	memcpy(buffer, RAWIMAGE_MAGIC, 4);
+	buffer[4] = RAWIMAGE_VERSION & 0xff;
+	buffer[5] = (RAWIMAGE_VERSION >> 8) & 0xff;
+	buffer[6] = compression & 0xff;
+	buffer[7] = (compression >> 8) & 0xff;
+	WriteLE32(buffer + 8, (uint32_t)width);
+	WriteLE32(buffer + 12, (uint32_t)height);
+	WriteLE32(buffer + 16, (uint32_t)dataSize);
+
+	*size = RAWIMAGE_HEADER_SIZE + dataSize;
+	return buffer;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// rgba8 images that can be uploaded without decoding, written by crunch for atlas pages (--image raw or lz4).
+// a 20 byte little endian header, then the pixels with rows top to bottom:
+// [char[4]] "CRAW"
+// [uint16] version
+// [uint16] compression
+// [uint32] width
+// [uint32] height
+// [uint32] size of the data after the header
+#define RAWIMAGE_MAGIC "CRAW"
+#define RAWIMAGE_VERSION 1
+#define RAWIMAGE_HEADER_SIZE 20
+#define RAWIMAGE_MAX_SIZE 16384
+
+typedef enum {
+	RAWIMAGE_NONE, // width * height * 4 bytes of pixels
+	RAWIMAGE_LZ4, // one lz4 block that decompresses to width * height * 4 bytes
+} rawImageCompression_t;
+
+typedef struct {
+	int width;
+	int height;
+	rawImageCompression_t compression;
+	const uint8_t *data; // points into the buffer passed to RawImg_Parse
+	size_t size;
+} rawImage_t;
+
+// returns false if buffer doesn't hold a valid header, so callers can fall back to decoding it as a png
+bool RawImg_Parse(const void *buffer, size_t size, rawImage_t *img);
+// writes width * height * 4 bytes to pixels, returns false if the data is corrupt
+bool RawImg_Decode(const rawImage_t *img, uint8_t *pixels);
+// returns a malloc'd buffer holding the header and data, and its size in *size
+uint8_t* RawImg_Encode(const uint8_t *pixels, int width, int height, rawImageCompression_t compression, size_t *size);
+
+// lz4 block format, compatible with LZ4_compress_default and LZ4_decompress_safe
+size_t LZ4_CompressBound(size_t size);
+size_t LZ4_CompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity);
+// returns the decompressed size, or -1 if the block is corrupt or doesn't fit in dst
+int64_t LZ4_DecompressBlock(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity);
@@ -7,6 +7,8 @@
 #include "input.h"
 #include "external/fontstash.h"
 #include "console.h"
+#include "cvar_main.h"
+#include "profiler.h"
 
 extern conVar_t* vid_width, * vid_height;
 Canvas * activeCanvas = nullptr;
@@ -441,16 +443,43 @@ const void *RB_DrawTri(const void *data) {
 	return (const void *)(cmd + 1);
 }
 
+static void RB_DrawMapTile(const drawMapCommand_t *cmd, const tmx_map *map, const unsigned int *animRemap, unsigned int raw, unsigned int x, unsigned int y) {
+	unsigned int gid = raw & TMX_FLIP_BITS_REMOVAL;
+
+	if (gid == 0) {
+		return;
+	}
+
+	if (animRemap != nullptr) {
+		gid = animRemap[gid];
+	}
+
+	uint8_t flipBits = (raw & TMX_FLIPPED_HORIZONTALLY ? FLIP_H : 0) | (raw & TMX_FLIPPED_VERTICALLY ? FLIP_V : 0) | (raw & TMX_FLIPPED_DIAGONALLY ? FLIP_DIAG : 0);
+
+	tmx_tile *tile = map->tiles[gid];
+	tmx_tileset *ts = tile->tileset;
+	Asset *asset = (Asset*)tile->tileset->image->resource_image;
+
+	Image *image = (Image*)asset->resource;
+
+	DrawImage(
+		//  offset + current x/y         - start tile offset         
+		cmd->x + x * ts->tile_width - (cmd->cellX * ts->tile_width),
+		cmd->y + y * ts->tile_height - (cmd->cellY * ts->tile_height),
+		(float)ts->tile_width,
+		(float)ts->tile_height,
+		(float)tile->ul_x,
+		(float)tile->ul_y,
+		1.0f, flipBits, image->hnd, image->w, image->h
+	);
+}
+
 const void *RB_DrawMapLayer(const void *data) {
 	auto cmd = (const drawMapCommand_t *)data;
 
 	tmx_map *map = (tmx_map *)Asset_Get(ASSET_TMX, cmd->mapId)->resource;
 
-	tmx_layer *layer = map->ly_head;
-	unsigned int i = 0;
-	while (layer != nullptr && i++ != cmd->layer) {
-		layer = layer->next;
-	}
+	tmx_layer *layer = TMX_GetLayer(map, (int)cmd->layer);
 
 	assert(layer != nullptr);
 
@@ -461,33 +490,39 @@ const void *RB_DrawMapLayer(const void *data) {
 		unsigned int endX = map->width < cmd->cellX + cellW ? map->width : cmd->cellX + cellW;
 		unsigned int endY = map->height < cmd->cellY + cellH ? map->height : cmd->cellY + cellH;
 
-		for (unsigned int y = cmd->cellY; y < endY; y++) {
-			for (unsigned int x = cmd->cellX; x < endX; x++) {
-				unsigned int raw = layer->content.gids[(y*map->width) + x];
-				unsigned int gid = raw & TMX_FLIP_BITS_REMOVAL;
-
-				if (gid == 0) {
-					continue;
+		const unsigned int *animRemap = TMX_AnimRemap(map);
+
+		// infinite maps with nothing drawn on them are 0x0 and don't have a chunk size
+		if (map->infinite && map->width > 0) {
+			// only the chunks the cells overlap are looked up, which decodes them if they aren't already
+			const tmxMapInfo_t *info = TMX_GetInfo(map);
+			unsigned int chunkW = (unsigned int)info->chunkW, chunkH = (unsigned int)info->chunkH;
+
+			for (unsigned int row = cmd->cellY / chunkH; row * chunkH < endY; row++) {
+				for (unsigned int col = cmd->cellX / chunkW; col * chunkW < endX; col++) {
+					const int32_t *gids = TMX_GetChunk(map, (int)cmd->layer, (int)col, (int)row);
+					if (gids == nullptr) {
+						continue;
+					}
+
+					unsigned int startX = col * chunkW > cmd->cellX ? col * chunkW : cmd->cellX;
+					unsigned int startY = row * chunkH > cmd->cellY ? row * chunkH : cmd->cellY;
+					unsigned int stopX = (col + 1) * chunkW < endX ? (col + 1) * chunkW : endX;
+					unsigned int stopY = (row + 1) * chunkH < endY ? (row + 1) * chunkH : endY;
+
+					for (unsigned int y = startY; y < stopY; y++) {
+						for (unsigned int x = startX; x < stopX; x++) {
+							RB_DrawMapTile(cmd, map, animRemap, (unsigned int)gids[(y - row * chunkH) * chunkW + (x - col * chunkW)], x, y);
+						}
+					}
+				}
+			}
+		}
+		else if (!map->infinite) {
+			for (unsigned int y = cmd->cellY; y < endY; y++) {
+				for (unsigned int x = cmd->cellX; x < endX; x++) {
+					RB_DrawMapTile(cmd, map, animRemap, layer->content.gids[(y*map->width) + x], x, y);
 				}
-
-				uint8_t flipBits = (raw & TMX_FLIPPED_HORIZONTALLY ? FLIP_H : 0) | (raw & TMX_FLIPPED_VERTICALLY ? FLIP_V : 0) | (raw & TMX_FLIPPED_DIAGONALLY ? FLIP_DIAG : 0);
-
-				tmx_tile *tile = map->tiles[gid];
-				tmx_tileset *ts = tile->tileset;
-				Asset *asset = (Asset*)tile->tileset->image->resource_image;
-
-				Image *image = (Image*)asset->resource;
-
-				DrawImage(
-					//  offset + current x/y         - start tile offset         
-					cmd->x + x * ts->tile_width - (cmd->cellX * ts->tile_width),
-					cmd->y + y * ts->tile_height - (cmd->cellY * ts->tile_height),
-					(float)ts->tile_width,
-					(float)ts->tile_height,
-					(float)tile->ul_x,
-					(float)tile->ul_y,
-					1.0f, flipBits, image->hnd, image->w, image->h
-				);
 			}
 		}
 	}
@@ -496,6 +531,12 @@ const void *RB_DrawMapLayer(const void *data) {
 }
 
 void SubmitRenderCommands(renderCommandList_t * list) {
+	PROFILE_ZONE("render commands");
+
+	if (vid_nullRenderer->integer) {
+		return;
+	}
+
 	const void *data = list->cmds;
 
 	while (1) {
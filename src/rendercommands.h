@@ -163,4 +163,7 @@ struct RenderState {
 typedef struct RenderState RenderState;
 
 extern RenderState state;
-extern FONScontext *ctx;
\ No newline at end of file
+extern FONScontext *ctx;
+
+// creates the shared font context. headless runs get one that lays out text but never touches the gpu.
+FONScontext* TTF_CreateContext();
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <cmath>
 #include <chrono>
 #include <thread>
+#include <vector>
+#include <string.h>
 #include <stdint.h>
 
 #ifdef __EMSCRIPTEN__
@@ -41,6 +43,12 @@ extern "C" {
 #include <soloud_thread.h>
 
 #include "filewatcher.h"
+#include "logger.h"
+#include "profiler.h"
+#include "pacing.h"
+#include "timestep.h"
+#include "demo.h"
+#include "benchmark.h"
 #include "crunch_frontend.h"
 #include "assetloader.h"
 
@@ -60,6 +68,7 @@ int64_t last_update_musec = 0, frame_musec = 0, com_frameTime = 0;
 //float frame_accum;
 bool frameAdvance = false;
 long long now = 0;
+static long long lastFrameStart = 0;
 static renderCommandList_t cmdList;
 SDL_Window *window;
 SDL_GLContext context;
@@ -133,12 +142,17 @@ void Cmd_Clear_f() {
 
 void ConH_Print(const char *line) {
 	IMConsole()->AddLog("%s", line);
-	printf("%s", line);
+	Log_Write(line);
 }
 
 void ConH_Error(int level, const char *message) {
 	Con_Print(message);
 
+	// make sure the error makes it to the terminal and log before we potentially exit
+	if (level == ERR_FATAL) {
+		Log_Flush();
+	}
+
 #if defined(_WIN32) && defined(DEBUG)
 	if (level == ERR_FATAL) {
 		__debugbreak();
@@ -177,9 +191,19 @@ SLT_API double SLT_StartFrame() {
 		return 0;
 	}
 
+	// com_frameTime follows the demo's clock instead of the real one while a demo is playing
 	now = measure_now();
-	frame_musec = now - com_frameTime;
-	com_frameTime = now;
+	int64_t realMusec = now - lastFrameStart;
+	lastFrameStart = now;
+	frame_musec = realMusec;
+	Demo_StartFrame(realMusec, &frame_musec);
+	com_frameTime += frame_musec;
+
+	// tile animations hold still while the game is paused
+	TMX_Tick(!eng_pause->integer || frameAdvance ? frame_musec : 0);
+
+	Prof_FrameMark();
+	Prof_Begin("event pump");
 
 	SDL_Event ev;
 	ImGuiIO &io = ImGui::GetIO();
@@ -188,6 +212,7 @@ SLT_API double SLT_StartFrame() {
 
 		switch (ev.type) {
 		case SDL_QUIT:
+			Prof_End();
 			return -1;
 		case SDL_KEYDOWN:
 			if (ev.key.keysym.sym == SDLK_BACKQUOTE) {
@@ -196,10 +221,16 @@ SLT_API double SLT_StartFrame() {
 				break;
 			}
 		default:
-			ProcessInputEvent(ev);
+			if (!Demo_IsPlaying()) {
+				ProcessInputEvent(ev);
+			}
 		}
 	}
 
+	Demo_EndInput(com_frameTime);
+
+	Prof_End();
+
 	frameStarted = true;
 
 	memset(&cmdList, 0, sizeof(cmdList));
@@ -209,9 +240,31 @@ SLT_API double SLT_StartFrame() {
 		snd_volume->modified = false;
 	}
 
-	FileWatcher_Tick();
-	
-	ImGui_ImplSdl_NewFrame(window);
+	if (con_logfile->modified) {
+		Log_SetFile(con_logfile->string);
+		con_logfile->modified = false;
+	}
+
+	{
+		PROFILE_ZONE("file ticks");
+		FileWatcher_Tick();
+		FS_AsyncTick();
+	}
+
+	Bench_StartFrame();
+
+	{
+		PROFILE_ZONE("imgui new frame");
+		if (eng_headless->integer) {
+			ImGuiIO &io = ImGui::GetIO();
+			io.DisplaySize = ImVec2((float)vid_width->integer, (float)vid_height->integer);
+			io.DeltaTime = frame_musec > 0 ? frame_musec / 1E6f : 1.0f / 60.0f;
+			ImGui::NewFrame();
+		}
+		else {
+			ImGui_ImplSdl_NewFrame(window);
+		}
+	}
 
 	if (eng_errorMessage->string[0] != '\0') {
 		ImGui::SetNextWindowPos(ImVec2(vid_width->integer / 2, vid_height->integer), 0, ImVec2(0.5, 0.5));
@@ -246,38 +299,78 @@ SLT_API void SLT_EndFrame() {
 		frameAdvance = false;
 	}
 
-	IMConsole()->Draw(vid_width->integer, vid_height->integer);
-	Asset_DrawInspector();
+	{
+		PROFILE_ZONE("imgui render");
+		IMConsole()->Draw(vid_width->integer, vid_height->integer);
+		Asset_DrawInspector();
+		Prof_DrawTimeline();
 
-	ImGui::Render();
-	ImGui_ImplSdl_RenderDrawData(ImGui::GetDrawData());
+		ImGui::Render();
+		if (!vid_nullRenderer->integer) {
+			ImGui_ImplSdl_RenderDrawData(ImGui::GetDrawData());
+		}
+	}
 
-	if (debug_fontAtlas->integer) {
-		rlLoadIdentity();
-		if (ctx != nullptr) fonsDrawDebug(ctx, 0, 32);
-		rlglDraw();
+	// the null renderer still builds everything, it just never hands it to the gpu
+	if (!vid_nullRenderer->integer) {
+		if (debug_fontAtlas->integer) {
+			rlLoadIdentity();
+			if (ctx != nullptr) fonsDrawDebug(ctx, 0, 32);
+			rlglDraw();
+		}
+
+		PROFILE_ZONE("swap");
+		SDL_GL_SwapWindow(window);
 	}
 
-	SDL_GL_SwapWindow(window);
+	Bench_EndFrame();
 
-	// OSes seem to not be able to sleep for shorter than a millisecond. so let's sleep until
-	// we're close-ish and then burn loop the rest. we get a majority of the cpu/power gains
-	// while still remaining pretty accurate on frametimes.
-	if (vid_maxfps->integer > 0) {
-		long long target = now + (long long)(1000.0f / vid_maxfps->integer * 1000);
-		long long currentSleepTime = measure_now();
-		while (currentSleepTime <= target) {
-			long long amt = (target - currentSleepTime) - 2000;
-			if (amt > 0) {
-				std::this_thread::sleep_for(std::chrono::microseconds(amt));
-			}
-			currentSleepTime = measure_now();
-		}
+	PROFILE_ZONE("frame limiter");
+	Pace_Wait(vid_maxfps->integer);
+}
+
+// shared by the regular and headless init, once all of the devices are up
+static void SLT_FinishInit() {
+	// now that we've ran the user configs and initialized everything else, apply everything else on the
+	// command line here. this will set the rest of the variables and run any commands specified.
+	Con_ExecuteCommandLine();
+
+	Log_SetFile(con_logfile->string);
+	con_logfile->modified = false;
+}
+
+// no window, gl context, or audio device. the console, filesystem, assets (metadata only), and scripts all work
+// as usual, but nothing is ever drawn or played. meant for validating levels and running simulations on machines
+// without a gpu.
+static void SLT_InitHeadless() {
+	if (SDL_Init(SDL_INIT_EVENTS) < 0) {
+		Con_Errorf(ERR_FATAL, "There was an error initing SDL2: %s", SDL_GetError());
 	}
+
+	atexit(SDL_Quit);
+
+	SoLoud::result result = soloud.init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER);
+	if (result != 0) {
+		Con_Errorf(ERR_FATAL, "Error initializing null audio: %s", soloud.getErrorString(result));
+	}
+
+	// imgui still runs so the console and debug windows don't need special cases, its output just gets dropped.
+	// the font atlas is built here since there's no renderer backend to do it.
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO();
+	io.IniFilename = NULL;
+	unsigned char *pixels;
+	int width, height;
+	io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+
+	Con_SetVarHandleForce(vid_nullRenderer, "1");
+
+	SLT_FinishInit();
 }
 
 SLT_API void SLT_Init(int argc, char* argv[]) {
-	// initialize console. construct imgui console, setup handlers, and then initialize the actual console
+	// initialize console. start the logger, construct imgui console, setup handlers, and then initialize the actual console
+	Log_Init();
 	IMConsole();
 	console.handlers.print = &ConH_Print;
 	console.handlers.getKeyForString = &In_GetKeyNum;
@@ -291,15 +384,33 @@ SLT_API void SLT_Init(int argc, char* argv[]) {
 	const char* defaultButtons[] = { "up", "down", "left", "right", "a", "b", "x", "y", "l", "r", "start", "select" };
 	Con_AllocateButtons(&defaultButtons[0], 12);
 
+	// registers a command, so it needs the console, and FS_Init starts the async io thread which names itself
+	Prof_Init();
+
+	// --headless has to be known before anything is initialized, so pull it out here. everything else on the
+	// command line is console commands.
+	static std::vector<char*> args;
+	bool headless = false;
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0) {
+			headless = true;
+		}
+		else {
+			args.push_back(argv[i]);
+		}
+	}
+
 	// setup console to pull cvars from command line
-	Con_SetupCommandLine(argc, argv);
+	Con_SetupCommandLine((int)args.size(), args.data());
 
 	// we don't have a filesystem yet so we don't want to run the whole command line
 	// yet. pick out the convars that are important for FS initialization, and then later on
-	// we'll run the rest.
+	// we'll run the rest. vid.nullRenderer is latched the same way since it can't change
+	// once the renderer is up.
 	Con_SetVarFromStartup("fs.basepath");
 	Con_SetVarFromStartup("fs.basegame");
 	Con_SetVarFromStartup("fs.game");
+	Con_SetVarFromStartup("vid.nullRenderer");
 	FS_Init(argv[0]);
 
 	// add engine level commands here
@@ -310,8 +421,16 @@ SLT_API void SLT_Init(int argc, char* argv[]) {
 	Con_AddCommand("clear", Cmd_Clear_f);
 
 	RegisterMainCvars();
+	if (headless) {
+		Con_SetVarHandleForce(eng_headless, "1");
+	}
 	FileWatcher_Init();
+	Pace_Init();
+	Tick_Init();
+	Demo_Init();
+	Bench_Init();
 	Crunch_Init();
+	TMX_Init();
 
 	if (!FS_Exists("default.cfg")) {
 		Con_Error(ERR_FATAL, "Filesystem error, check fs.basepath is set correctly. (Could not find default.cfg)");
@@ -324,6 +443,11 @@ SLT_API void SLT_Init(int argc, char* argv[]) {
 
 	SDL_SetMainReady();
 
+	if (headless) {
+		SLT_InitHeadless();
+		return;
+	}
+
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER) < 0) {
 		Con_Errorf(ERR_FATAL, "There was an error initing SDL2: %s", SDL_GetError());
 	}
@@ -388,17 +512,20 @@ SLT_API void SLT_Init(int argc, char* argv[]) {
 	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 #endif
 
-	// now that we've ran the user configs and initialized everything else, apply everything else on the
-	// command line here. this will set the rest of the variables and run any commands specified.
-	Con_ExecuteCommandLine();
+	SLT_FinishInit();
 }
 
 SLT_API void SLT_Shutdown() {
+	Demo_Stop();
+	FS_AsyncShutdown();
 	Con_Shutdown();
 	Asset_ClearAll();
-	ImGui_ImplSdl_Shutdown();
+	if (!eng_headless->integer) {
+		ImGui_ImplSdl_Shutdown();
+	}
 	ImGui::DestroyContext();
 	SDL_GL_DeleteContext(context);
+	Log_Shutdown();
 }
 
 SLT_API void SLT_Con_SetErrorHandler(void(*errHandler)(int level, const char *msg)) {
@@ -443,6 +570,10 @@ SLT_API const conVar_t* SLT_Con_SetVar(const char* var_name, const char* value)
 	return Con_SetVar(var_name, value);
 }
 
+SLT_API const conVar_t* SLT_Con_SetVarHandle(const conVar_t* var, const char* value) {
+	return Con_SetVarHandle((conVar_t*)var, value);
+}
+
 SLT_API int SLT_Con_GetArgCount(void) {
 	return Con_GetArgsCount();
 }
@@ -463,6 +594,26 @@ SLT_API int SLT_FS_ReadFile(const char* path, void** buffer) {
 	return FS_ReadFile(path, buffer);
 }
 
+SLT_API int SLT_FS_ReadAsync(const char* path, int priority, SLT_ReadCallback callback, void* userdata) {
+	return FS_ReadAsync(path, priority, callback, userdata);
+}
+
+SLT_API uint8_t SLT_FS_CancelAsync(int request) {
+	return FS_CancelAsync(request);
+}
+
+SLT_API void SLT_Prof_Begin(const char* name) {
+	Prof_Begin(name);
+}
+
+SLT_API void SLT_Prof_End() {
+	Prof_End();
+}
+
+SLT_API void SLT_Bench_AddStat(const char* name, double value) {
+	Bench_AddStat(name, value);
+}
+
 SLT_API uint8_t SLT_FS_Exists(const char* file) {
 	return FS_Exists(file) ? 1 : 0;
 }
@@ -551,6 +702,18 @@ SLT_API const tmx_map* SLT_Get_TMX(AssetHandle id) {
 	return Get_TMX(id);
 }
 
+SLT_API const tmxMapInfo_t* SLT_TMX_GetInfo(const tmx_map *map) {
+	return TMX_GetInfo(map);
+}
+
+SLT_API tmx_layer* SLT_TMX_GetLayer(const tmx_map *map, int layer) {
+	return TMX_GetLayer(map, layer);
+}
+
+SLT_API const int32_t* SLT_TMX_GetChunk(const tmx_map *map, int layer, int col, int row) {
+	return TMX_GetChunk(map, layer, col, row);
+}
+
 SLT_API unsigned int SLT_Snd_Play(AssetHandle asset, float volume, float pan, uint8_t loop) {
 	return Snd_Play(asset, volume, pan, loop > 0);
 }
@@ -576,6 +739,22 @@ SLT_API void SLT_UpdateLastFrameTime() {
 	last_update_musec = com_frameTime;
 }
 
+SLT_API int SLT_Tick_Begin(double dt) {
+	return Tick_Advance(dt, eng_pause->integer && frameAdvance);
+}
+
+SLT_API double SLT_Tick_Length() {
+	return Tick_Length();
+}
+
+SLT_API double SLT_Tick_Alpha() {
+	return Tick_Alpha();
+}
+
+SLT_API int64_t SLT_Tick_Count() {
+	return Tick_Count();
+}
+
 #define GET_COMMAND(type, id) type *cmd; cmd = (type *)R_GetCommandBuffer(sizeof(*cmd)); if (!cmd) { return; } cmd->commandId = id;
 
 void* R_GetCommandBuffer(int bytes) {
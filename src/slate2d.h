@@ -58,6 +58,63 @@ typedef struct {
 	int x, y;
 } MousePosition;
 
+// object and property data from an ASSET_TMX, flattened when the map loads so scripts can read it
+// without walking the tmx structures, see SLT_TMX_GetInfo. strings are ids into tmxMapInfo_t's
+// string table, every distinct string is stored once.
+typedef struct {
+	int name;
+	enum tmx_property_type type;
+	union {
+		double number; // PT_INT, PT_FLOAT, PT_COLOR, and PT_BOOL as 0 or 1
+		int string; // PT_NONE, PT_STRING and PT_FILE
+	} value;
+} tmxPropInfo_t;
+
+// props are a range in tmxMapInfo_t.props
+typedef struct {
+	int name, type; // type falls back to the tile's type for tile objects
+	double x, y, width, height, rotation;
+	int visible;
+	int propStart, propCount; // includes the tile's properties for tile objects, unless the object overrides them
+} tmxObjectInfo_t;
+
+typedef struct {
+	int objectStart, objectCount; // range in tmxMapInfo_t.objects, empty for tile layers
+	int propStart, propCount;
+} tmxLayerInfo_t;
+
+typedef struct {
+	unsigned int gid;
+	int type;
+	int propStart, propCount;
+} tmxTileInfo_t;
+
+typedef struct {
+	int layerCount;
+	const tmxLayerInfo_t *layers;
+
+	int stringCount;
+	const int *stringOffsets; // into strings
+	const char *strings;
+
+	int propCount;
+	const tmxPropInfo_t *props;
+	int mapPropStart, mapPropCount;
+
+	int objectCount;
+	const tmxObjectInfo_t *objects;
+
+	int tileCount; // tiles that have tile info, in gid order
+	const tmxTileInfo_t *tiles;
+
+	// infinite maps have map->width and height set to cover every chunk, cell 0,0 is the tile at
+	// originX, originY in tiled. every chunk has to be chunkW by chunkH tiles.
+	int originX, originY;
+	int chunkW, chunkH;
+} tmxMapInfo_t;
+
+#define TMX_String(info, id) ((info)->strings + (info)->stringOffsets[id])
+
 #ifdef _MSC_VER 
 	#ifdef SLT_COMPILE_DLL
 		#define SLT_API __declspec(dllexport)
@@ -106,6 +163,21 @@ SLT_API void SLT_EndFrame();
 // may run into issues using delay and repeated keypresses in SLT_In_ButtonPressed.
 SLT_API void SLT_UpdateLastFrameTime();
 
+// fixed timestep support. pass the dt from SLT_StartFrame in, and run your update that many times with
+// SLT_Tick_Length as the timestep. the rate is set by engine.tickRate, and engine.maxCatchup limits how many
+// ticks can run in one frame, anything past that is dropped. while paused, frame_advance runs a single tick.
+SLT_API int SLT_Tick_Begin(double dt);
+
+// length of a single tick in seconds.
+SLT_API double SLT_Tick_Length();
+
+// how far the leftover time is into the next tick, from 0 to 1. pass this to your draw to interpolate between
+// the previous and current simulation state.
+SLT_API double SLT_Tick_Alpha();
+
+// total ticks ran since startup.
+SLT_API int64_t SLT_Tick_Count();
+
 
 // sends a string containing a command, or series of commands delimited by ; to the console system. will
 // immediately fire any command handlers.
@@ -133,6 +205,10 @@ SLT_API const conVar_t* SLT_Con_GetVar(const char* name);
 // sets a console variable, and returns it, creating it if it doesn't exist.
 SLT_API const conVar_t* SLT_Con_SetVar(const char* var_name, const char* value);
 
+// sets a console variable previously returned by one of the functions above. convars stay valid until shutdown, so
+// holding on to one and setting it this way skips looking it up by name.
+SLT_API const conVar_t* SLT_Con_SetVarHandle(const conVar_t* var, const char* value);
+
 
 // if running inside a console command handler, return how many arguments have been parsed.
 SLT_API int SLT_Con_GetArgCount(void);
@@ -153,6 +229,18 @@ SLT_API void SLT_Con_AddCommand(const char* name, conCmd_t cmd);
 // length of the file, or -1 if the file does not exist.
 SLT_API int SLT_FS_ReadFile(const char* path, void** buffer);
 
+// receives the result of SLT_FS_ReadAsync on the main thread, during SLT_StartFrame. size is -1 if the file does
+// not exist. the buffer is freed once the callback returns, so copy out anything you want to keep.
+typedef void(*SLT_ReadCallback)(int request, const char* path, const void* buffer, int size, void* userdata);
+
+// queues a read of the file at path on the io thread and returns a request id. requests with a higher priority are
+// read first. run fs_asyncstats in the console to see latency and throughput.
+SLT_API int SLT_FS_ReadAsync(const char* path, int priority, SLT_ReadCallback callback, void* userdata);
+
+// cancels a request from SLT_FS_ReadAsync so its callback won't be called, even if the read already finished and is
+// waiting for the next SLT_StartFrame. returns false if the callback already ran or the id is unknown.
+SLT_API uint8_t SLT_FS_CancelAsync(int request);
+
 // returns true or false if the file exists at the given path in the virtual filesystem.
 SLT_API uint8_t SLT_FS_Exists(const char* file);
 
@@ -164,6 +252,18 @@ SLT_API char** SLT_FS_List(const char* path);
 SLT_API void SLT_FS_FreeList(void* listVar);
 
 
+// starts a named profiler zone on the calling thread, closed by SLT_Prof_End. zones show up in the profiler timeline
+// (debug.profiler 1) and in profile_dump traces. name must stay valid for the rest of the program, so use a literal.
+SLT_API void SLT_Prof_Begin(const char* name);
+
+// ends the most recent zone started with SLT_Prof_Begin.
+SLT_API void SLT_Prof_End();
+
+// adds value to a named per frame stat in the report written by the benchmark command, which lists the mean, max,
+// and total over the run. does nothing unless a benchmark is running.
+SLT_API void SLT_Bench_AddStat(const char* name, double value);
+
+
 // allocates a set of buttons, which should be high-level actions dependant on your game. all button names passed
 // are automatically prefixed by +, and can be bound from the console to keyboard keys or controllers. by default,
 // Slate2D will setup these buttons for you, and binds them to the keyboard and all 4 gamepads:
@@ -236,6 +336,16 @@ SLT_API const Image* SLT_Get_Img(AssetHandle id);
 // returns a complex tmx structure.
 SLT_API const tmx_map* SLT_Get_TMX(AssetHandle id);
 
+// returns the object, property and tile data flattened when the map was loaded. owned by the map.
+SLT_API const tmxMapInfo_t* SLT_TMX_GetInfo(const tmx_map *map);
+
+// returns the layer at index layer, counting from the first in the file, or NULL if there isn't one.
+SLT_API tmx_layer* SLT_TMX_GetLayer(const tmx_map *map, int layer);
+
+// returns the gids of the chunk at col, row of a layer of an infinite map, counting in chunks from the top
+// left one, decoding it if it isn't in memory, or NULL if there's no chunk there. only good until the next call, which can evict it.
+SLT_API const int32_t* SLT_TMX_GetChunk(const tmx_map *map, int layer, int col, int row);
+
 
 // plays an ASSET_SPEECH, ASSET_SOUND, or ASSET_MOD at the given settings. returns a handle that can be used to
 // call SLT_Snd_Stop or SLT_Snd_PauseResume with.
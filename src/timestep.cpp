@@ -0,0 +1,104 @@
+#include <string.h>
+#include "console.h"
+#include "cvar_main.h"
+#include "timestep.h"
+
+#define TICK_HIST_SIZE 8
+
+static double accumulator = 0;
+static double tickLength = 1.0 / 60;
+static int64_t ticks = 0;
+
+static struct {
+	int64_t frames;
+	int64_t ticks;
+	int64_t catchupFrames; // frames that hit engine.maxCatchup
+	double dropped; // seconds thrown away past the catchup limit
+	int64_t perFrame[TICK_HIST_SIZE]; // how many frames ran 0, 1, 2... ticks, last bucket is everything above
+} stats;
+
+static void Tick_UpdateRate() {
+	if (eng_tickRate->value <= 0) {
+		Con_Printf("engine.tickRate must be above 0, using 60\n");
+		Con_SetVarHandle(eng_tickRate, "60");
+	}
+
+	tickLength = 1.0 / eng_tickRate->value;
+	accumulator = 0;
+	eng_tickRate->modified = false;
+}
+
+void Tick_Reset() {
+	accumulator = 0;
+}
+
+int Tick_Advance(double dt, bool step) {
+	if (eng_tickRate->modified) {
+		Tick_UpdateRate();
+	}
+
+	int count;
+
+	if (step) {
+		count = 1;
+	}
+	else {
+		accumulator += dt > 0 ? dt : 0;
+		// summing frame deltas leaves rounding error, so a tick that's due can come up a hair short
+		count = (int)(accumulator / tickLength + 1E-6);
+
+		int maxCatchup = eng_maxCatchup->integer > 0 ? eng_maxCatchup->integer : 1;
+		if (count > maxCatchup) {
+			// we're too far behind to catch up, e.g. after a hitch or a breakpoint. run what we're
+			// allowed to and drop the rest instead of spiraling.
+			stats.catchupFrames++;
+			stats.dropped += accumulator - maxCatchup * tickLength;
+			count = maxCatchup;
+			accumulator = 0;
+		}
+		else {
+			accumulator -= count * tickLength;
+			accumulator = accumulator < 0 ? 0 : accumulator;
+		}
+	}
+
+	ticks += count;
+	stats.frames++;
+	stats.ticks += count;
+	stats.perFrame[count < TICK_HIST_SIZE - 1 ? count : TICK_HIST_SIZE - 1]++;
+
+	return count;
+}
+
+double Tick_Length() {
+	return tickLength;
+}
+
+double Tick_Alpha() {
+	double alpha = accumulator / tickLength;
+	return alpha < 0 ? 0 : alpha > 1 ? 1 : alpha;
+}
+
+int64_t Tick_Count() {
+	return ticks;
+}
+
+void Cmd_TickStats_f() {
+	if (Con_GetArgsCount() > 1 && strcmp(Con_GetArg(1), "reset") == 0) {
+		memset(&stats, 0, sizeof(stats));
+		Con_Printf("tick stats reset\n");
+		return;
+	}
+
+	Con_Printf("%lld ticks over %lld frames at %.1f ticks/sec, %lld ticks total\n", (long long)stats.ticks, (long long)stats.frames, 1.0 / tickLength, (long long)ticks);
+	Con_Printf("%lld frames hit engine.maxCatchup, %.2fms of simulation dropped\n", (long long)stats.catchupFrames, stats.dropped * 1000.0);
+
+	for (int i = 0; i < TICK_HIST_SIZE; i++) {
+		Con_Printf("%i%s ticks: %lld frames\n", i, i == TICK_HIST_SIZE - 1 ? "+" : "", (long long)stats.perFrame[i]);
+	}
+}
+
+void Tick_Init() {
+	Tick_UpdateRate();
+	Con_AddCommand("tick_stats", Cmd_TickStats_f);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+
+// fixed timestep accumulator. the game feeds in the frame delta and gets back how many ticks of
+// engine.tickRate to run, so simulation stays deterministic no matter the render rate.
+void Tick_Init();
+
+// throws away any leftover time, so the next ticks line up the same way every time. used when
+// starting demos.
+void Tick_Reset();
+
+// adds dt seconds and returns how many ticks should run this frame, capped at engine.maxCatchup.
+// time past the cap is dropped. step forces exactly one tick, used for frame advance while paused.
+int Tick_Advance(double dt, bool step);
+
+// length of a single tick in seconds
+double Tick_Length();
+
+// how far into the next tick the accumulator is, 0..1. use to interpolate between the last two
+// simulated states when drawing.
+double Tick_Alpha();
+
+// total ticks ran since startup
+int64_t Tick_Count();